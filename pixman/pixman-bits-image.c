@@ -191,6 +191,102 @@ bits_image_fetch_pixel_bilinear_float (bits_image_t   *image,
     *ret = bilinear_interpolation_float (tl, tr, bl, br, distx, disty);
 }
 
+static force_inline void
+bits_image_fetch_pixel_bicubic_32 (bits_image_t   *image,
+				   pixman_fixed_t  x,
+				   pixman_fixed_t  y,
+				   get_pixel_t	   get_pixel,
+				   void		  *out)
+{
+    pixman_repeat_t repeat_mode = image->common.repeat;
+    int width = image->width;
+    int height = image->height;
+    uint32_t pixels[16];
+    int32_t wx[4], wy[4];
+    int x1, y1, i, j;
+    uint32_t *ret = out;
+
+    x1 = x - pixman_fixed_1 / 2;
+    y1 = y - pixman_fixed_1 / 2;
+
+    pixman_fixed_to_bicubic_weights (x1, wx);
+    pixman_fixed_to_bicubic_weights (y1, wy);
+
+    x1 = pixman_fixed_to_int (x1) - 1;
+    y1 = pixman_fixed_to_int (y1) - 1;
+
+    for (i = 0; i < 4; ++i)
+    {
+	for (j = 0; j < 4; ++j)
+	{
+	    int rx = x1 + j;
+	    int ry = y1 + i;
+
+	    if (repeat_mode != PIXMAN_REPEAT_NONE)
+	    {
+		repeat (repeat_mode, &rx, width);
+		repeat (repeat_mode, &ry, height);
+
+		get_pixel (image, rx, ry, FALSE, &pixels[i * 4 + j]);
+	    }
+	    else
+	    {
+		get_pixel (image, rx, ry, TRUE, &pixels[i * 4 + j]);
+	    }
+	}
+    }
+
+    *ret = bicubic_interpolation (pixels, wx, wy);
+}
+
+static force_inline void
+bits_image_fetch_pixel_bicubic_float (bits_image_t   *image,
+				      pixman_fixed_t  x,
+				      pixman_fixed_t  y,
+				      get_pixel_t     get_pixel,
+				      void	     *out)
+{
+    pixman_repeat_t repeat_mode = image->common.repeat;
+    int width = image->width;
+    int height = image->height;
+    argb_t pixels[16];
+    float wx[4], wy[4];
+    int x1, y1, i, j;
+    argb_t *ret = out;
+
+    x1 = x - pixman_fixed_1 / 2;
+    y1 = y - pixman_fixed_1 / 2;
+
+    pixman_fixed_to_bicubic_weights_float (x1, wx);
+    pixman_fixed_to_bicubic_weights_float (y1, wy);
+
+    x1 = pixman_fixed_to_int (x1) - 1;
+    y1 = pixman_fixed_to_int (y1) - 1;
+
+    for (i = 0; i < 4; ++i)
+    {
+	for (j = 0; j < 4; ++j)
+	{
+	    int rx = x1 + j;
+	    int ry = y1 + i;
+
+	    if (repeat_mode != PIXMAN_REPEAT_NONE)
+	    {
+		repeat (repeat_mode, &rx, width);
+		repeat (repeat_mode, &ry, height);
+
+		get_pixel (image, rx, ry, FALSE, &pixels[i * 4 + j]);
+	    }
+	    else
+	    {
+		get_pixel (image, rx, ry, TRUE, &pixels[i * 4 + j]);
+	    }
+	}
+    }
+
+    *ret = bicubic_interpolation_float (pixels, wx, wy);
+}
+
 static force_inline void accum_32(unsigned int *satot, unsigned int *srtot,
 				  unsigned int *sgtot, unsigned int *sbtot,
 				  const void *p, pixman_fixed_t f)
@@ -465,6 +561,13 @@ bits_image_fetch_pixel_filtered (bits_image_t  *image,
 	}
         break;
 
+    case PIXMAN_FILTER_BICUBIC:
+	if (wide)
+	    bits_image_fetch_pixel_bicubic_float (image, x, y, get_pixel, out);
+	else
+	    bits_image_fetch_pixel_bicubic_32 (image, x, y, get_pixel, out);
+	break;
+
     default:
 	assert (0);
         break;
@@ -674,8 +777,8 @@ __bits_image_fetch_general (pixman_iter_t  *iter,
 	{
 	    if (w != 0)
 	    {
-		x0 = ((uint64_t)x << 16) / w;
-		y0 = ((uint64_t)y << 16) / w;
+		x0 = ((int64_t)x * pixman_fixed_1) / w;
+		y0 = ((int64_t)y * pixman_fixed_1) / w;
 	    }
 	    else
 	    {
@@ -232,3 +232,51 @@
 #    error "Unknown thread local support for this system. Pixman will not work with multiple threads. Define PIXMAN_NO_TLS to acknowledge and accept this limitation and compile pixman without thread-safety support."
 
 #endif
+
+/* Atomics
+ *
+ * Just enough to let an image cache state that it derives lazily while
+ * several threads composite it: a counter, and a pointer that is
+ * published once and read with acquire semantics.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_ACQUIRE)
+
+#   define PIXMAN_ATOMIC_ADD(ptr, n)					\
+    __atomic_add_fetch ((ptr), (n), __ATOMIC_RELAXED)
+#   define PIXMAN_ATOMIC_LOAD_PTR(ptr)					\
+    __atomic_load_n ((ptr), __ATOMIC_ACQUIRE)
+#   define PIXMAN_ATOMIC_PUBLISH_PTR(ptr, value)			\
+    __sync_bool_compare_and_swap ((ptr), NULL, (value))
+
+#elif defined(__GNUC__)
+
+#   define PIXMAN_ATOMIC_ADD(ptr, n)					\
+    __sync_add_and_fetch ((ptr), (n))
+#   define PIXMAN_ATOMIC_LOAD_PTR(ptr)					\
+    __sync_val_compare_and_swap ((ptr), NULL, NULL)
+#   define PIXMAN_ATOMIC_PUBLISH_PTR(ptr, value)			\
+    __sync_bool_compare_and_swap ((ptr), NULL, (value))
+
+#elif defined(_MSC_VER)
+
+#   include <intrin.h>
+
+#   define PIXMAN_ATOMIC_ADD(ptr, n)					\
+    (_InterlockedExchangeAdd ((long volatile *)(ptr), (n)) + (n))
+#   define PIXMAN_ATOMIC_LOAD_PTR(ptr)					\
+    _InterlockedCompareExchangePointer ((void * volatile *)(ptr), NULL, NULL)
+#   define PIXMAN_ATOMIC_PUBLISH_PTR(ptr, value)			\
+    (_InterlockedCompareExchangePointer (				\
+	(void * volatile *)(ptr), (value), NULL) == NULL)
+
+#else
+
+/* Without atomics, state derived during compositing is not thread safe */
+#   define PIXMAN_ATOMIC_ADD(ptr, n)					\
+    (*(ptr) += (n))
+#   define PIXMAN_ATOMIC_LOAD_PTR(ptr)					\
+    (*(ptr))
+#   define PIXMAN_ATOMIC_PUBLISH_PTR(ptr, value)			\
+    (*(ptr) ? 0 : (*(ptr) = (value), 1))
+
+#endif
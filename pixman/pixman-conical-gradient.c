@@ -50,6 +50,71 @@ coordinates_to_parameter (double x, double y, double angle)
 				      */
 }
 
+/* Transform the center of pixel (x, y) into gradient space, along with
+ * the step from one pixel to the next.
+ */
+static pixman_bool_t
+conical_gradient_transform (pixman_image_t *image,
+			    int             x,
+			    int             y,
+			    double         *rx,
+			    double         *ry,
+			    double         *rz,
+			    double         *cx,
+			    double         *cy,
+			    double         *cz)
+{
+    *cx = 1.;
+    *cy = 0.;
+    *cz = 0.;
+    *rx = x + 0.5;
+    *ry = y + 0.5;
+    *rz = 1.;
+
+    if (image->common.transform)
+    {
+	pixman_vector_t v;
+
+	/* reference point is the center of the pixel */
+	v.vector[0] = pixman_int_to_fixed (x) + pixman_fixed_1 / 2;
+	v.vector[1] = pixman_int_to_fixed (y) + pixman_fixed_1 / 2;
+	v.vector[2] = pixman_fixed_1;
+
+	if (!pixman_transform_point_3d (image->common.transform, &v))
+	    return FALSE;
+
+	*cx = image->common.transform->matrix[0][0] / 65536.;
+	*cy = image->common.transform->matrix[1][0] / 65536.;
+	*cz = image->common.transform->matrix[2][0] / 65536.;
+
+	*rx = v.vector[0] / 65536.;
+	*ry = v.vector[1] / 65536.;
+	*rz = v.vector[2] / 65536.;
+    }
+
+    return TRUE;
+}
+
+pixman_bool_t
+_pixman_conical_gradient_get_affine_params (pixman_image_t *image,
+					    int             x,
+					    int             y,
+					    double         *rx,
+					    double         *ry,
+					    double         *cx,
+					    double         *cy)
+{
+    double rz, cz;
+
+    if (!conical_gradient_transform (image, x, y, rx, ry, &rz, cx, cy, &cz))
+	return FALSE;
+
+    *rx -= image->conical.center.x / 65536.;
+    *ry -= image->conical.center.y / 65536.;
+
+    return TRUE;
+}
+
 static uint32_t *
 conical_get_scanline (pixman_iter_t                 *iter,
 		      const uint32_t                *mask,
@@ -66,40 +131,16 @@ conical_get_scanline (pixman_iter_t                 *iter,
     conical_gradient_t *conical = (conical_gradient_t *)image;
     uint32_t       *end = buffer + width * (Bpp / 4);
     pixman_gradient_walker_t walker;
-    pixman_bool_t affine = TRUE;
-    double cx = 1.;
-    double cy = 0.;
-    double cz = 0.;
-    double rx = x + 0.5;
-    double ry = y + 0.5;
-    double rz = 1.;
+    pixman_bool_t affine;
+    double cx, cy, cz;
+    double rx, ry, rz;
 
     _pixman_gradient_walker_init (&walker, gradient, image->common.repeat);
 
-    if (image->common.transform)
-    {
-	pixman_vector_t v;
-
-	/* reference point is the center of the pixel */
-	v.vector[0] = pixman_int_to_fixed (x) + pixman_fixed_1 / 2;
-	v.vector[1] = pixman_int_to_fixed (y) + pixman_fixed_1 / 2;
-	v.vector[2] = pixman_fixed_1;
-
-	if (!pixman_transform_point_3d (image->common.transform, &v))
-	    return iter->buffer;
-
-	cx = image->common.transform->matrix[0][0] / 65536.;
-	cy = image->common.transform->matrix[1][0] / 65536.;
-	cz = image->common.transform->matrix[2][0] / 65536.;
-
-	rx = v.vector[0] / 65536.;
-	ry = v.vector[1] / 65536.;
-	rz = v.vector[2] / 65536.;
+    if (!conical_gradient_transform (image, x, y, &rx, &ry, &rz, &cx, &cy, &cz))
+	return iter->buffer;
 
-	affine =
-	    image->common.transform->matrix[2][0] == 0 &&
-	    v.vector[2] == pixman_fixed_1;
-    }
+    affine = cz == 0 && rz == 1.;
 
     if (affine)
     {
@@ -183,7 +224,10 @@ void
 _pixman_conical_gradient_iter_init (pixman_image_t *image, pixman_iter_t *iter)
 {
     if (iter->iter_flags & ITER_NARROW)
+    {
+	_pixman_gradient_prepare_lut (&image->gradient, iter->width, iter->height);
 	iter->get_scanline = conical_get_scanline_narrow;
+    }
     else
 	iter->get_scanline = conical_get_scanline_wide;
 }
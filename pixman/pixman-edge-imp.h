@@ -143,15 +143,23 @@ RASTERIZE_EDGES (pixman_image_t  *image,
 		}
 		else
 		{
+#ifndef ADD_ALPHA_SPAN
 		    int	xi;
+#endif
 
 		    ADD_ALPHA (N_X_FRAC(N_BITS) - lxs);
 		    STEP_ALPHA;
+#ifdef ADD_ALPHA_SPAN
+		    ADD_ALPHA_SPAN (line, lxi + 1, rxi - lxi - 1,
+				    N_X_FRAC(N_BITS));
+		    MOVE_ALPHA (line, rxi);
+#else
 		    for (xi = lxi + 1; xi < rxi; xi++)
 		    {
 			ADD_ALPHA (N_X_FRAC(N_BITS));
 			STEP_ALPHA;
 		    }
+#endif
 		    ADD_ALPHA (rxs);
 		}
 	    }
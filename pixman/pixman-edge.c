@@ -29,34 +29,6 @@
 #include "pixman-private.h"
 #include "pixman-accessor.h"
 
-/*
- * Step across a small sample grid gap
- */
-#define RENDER_EDGE_STEP_SMALL(edge)					\
-    {									\
-	edge->x += edge->stepx_small;					\
-	edge->e += edge->dx_small;					\
-	if (edge->e > 0)						\
-	{								\
-	    edge->e -= edge->dy;					\
-	    edge->x += edge->signdx;					\
-	}								\
-    }
-
-/*
- * Step across a large sample grid gap
- */
-#define RENDER_EDGE_STEP_BIG(edge)					\
-    {									\
-	edge->x += edge->stepx_big;					\
-	edge->e += edge->dx_big;					\
-	if (edge->e > 0)						\
-	{								\
-	    edge->e -= edge->dy;					\
-	    edge->x += edge->signdx;					\
-	}								\
-    }
-
 #ifdef PIXMAN_FB_ACCESSORS
 #define PIXMAN_RASTERIZE_EDGES pixman_rasterize_edges_accessors
 #else
@@ -86,6 +58,9 @@
 
 #define STEP_ALPHA      ((__ap += __ao), (__ao ^= 1))
 
+#define MOVE_ALPHA(line, x)						\
+    ((__ap = (uint8_t *) line + ((x) >> 1)), (__ao = (x) & 1))
+
 #define ADD_ALPHA(a)							\
     {									\
         uint8_t __o = READ (image, __ap);				\
@@ -93,9 +68,84 @@
         WRITE (image, __ap, PUT_4 (__o, __ao, __a | (0 - ((__a) >> 4)))); \
     }
 
+/*
+ * Add v to every nibble of w, saturating at 0xf. The low three bits of
+ * each nibble are added without carrying into the next nibble, and the
+ * carry out of the top bit is then spread over the nibble.
+ */
+static force_inline uint32_t
+add_saturate_nibbles (uint32_t w, uint32_t v)
+{
+    uint32_t t = (w & 0x77777777) + (v & 0x77777777);
+    uint32_t s = t ^ ((w ^ v) & 0x88888888);
+    uint32_t c = ((w & v) | ((w | v) & ~s)) & 0x88888888;
+
+    return s | ((c >> 3) * 0xf);
+}
+
+/*
+ * Add a to the @width pixels starting at pixel x, a whole byte or
+ * word of pixels at a time.
+ */
+static void
+add_saturate_4 (pixman_image_t *image, uint32_t *line, int x, int width, int a)
+{
+    uint32_t v = a * 0x11111111;
+    uint8_t *p;
+    int n;
+
+    if (width <= 0)
+	return;
+
+    if (x & 1)
+    {
+	DEFINE_ALPHA (line, x);
+	ADD_ALPHA (a);
+
+	x++;
+	width--;
+    }
+
+    p = (uint8_t *) line + (x >> 1);
+    n = width >> 1;
+
+    while (n && ((uintptr_t) p & 3))
+    {
+	WRITE (image, p, add_saturate_nibbles (READ (image, p), v));
+	p++;
+	n--;
+    }
+
+    while (n >= 4)
+    {
+	uint32_t *w = (uint32_t *) p;
+
+	WRITE (image, w, add_saturate_nibbles (READ (image, w), v));
+	p += 4;
+	n -= 4;
+    }
+
+    while (n--)
+    {
+	WRITE (image, p, add_saturate_nibbles (READ (image, p), v));
+	p++;
+    }
+
+    if (width & 1)
+    {
+	DEFINE_ALPHA (line, x + width - 1);
+	ADD_ALPHA (a);
+    }
+}
+
+#define ADD_ALPHA_SPAN(line, x, width, a)				\
+    add_saturate_4 (image, line, x, width, a)
+
 #include "pixman-edge-imp.h"
 
+#undef ADD_ALPHA_SPAN
 #undef ADD_ALPHA
+#undef MOVE_ALPHA
 #undef STEP_ALPHA
 #undef DEFINE_ALPHA
 #undef RASTERIZE_EDGES
@@ -127,19 +177,64 @@ clip255 (int x)
     return x;
 }
 
+/*
+ * Add v to every byte of w, saturating at 0xff, the way
+ * add_saturate_nibbles() does for nibbles.
+ */
+static force_inline uint32_t
+add_saturate_bytes (uint32_t w, uint32_t v)
+{
+    uint32_t t = (w & 0x7f7f7f7f) + (v & 0x7f7f7f7f);
+    uint32_t s = t ^ ((w ^ v) & 0x80808080);
+    uint32_t c = ((w & v) | ((w | v) & ~s)) & 0x80808080;
+
+    return s | ((c >> 7) * 0xff);
+}
+
+/*
+ * Add val to the @length pixels at buf. Long spans are handed to the
+ * implementations, which may have SIMD for it; otherwise, and with
+ * accessors, this goes a word of pixels at a time.
+ */
+static void
+add_saturate_8 (pixman_image_t *image, uint8_t *buf, int val, int length)
+{
+    uint32_t v = MIN (val, 0xff) * 0x01010101;
+
+#ifndef PIXMAN_FB_ACCESSORS
+    if (length >= 16 &&
+	_pixman_implementation_add_saturate_8 (
+	    get_implementation (), buf, val, length))
+    {
+	return;
+    }
+#endif
+
+    while (length && ((uintptr_t) buf & 3))
+    {
+	WRITE (image, buf, clip255 (READ (image, buf) + val));
+	buf++;
+	length--;
+    }
+
+    while (length >= 4)
+    {
+	uint32_t *w = (uint32_t *) buf;
+
+	WRITE (image, w, add_saturate_bytes (READ (image, w), v));
+	buf += 4;
+	length -= 4;
+    }
+
+    while (length--)
+    {
+	WRITE (image, buf, clip255 (READ (image, buf) + val));
+	buf++;
+    }
+}
+
 #define ADD_SATURATE_8(buf, val, length)				\
-    do									\
-    {									\
-        int i__ = (length);						\
-        uint8_t *buf__ = (buf);						\
-        int val__ = (val);						\
-									\
-        while (i__--)							\
-        {								\
-            WRITE (image, (buf__), clip255 (READ (image, (buf__)) + (val__))); \
-            (buf__)++;							\
-	}								\
-    } while (0)
+    add_saturate_8 (image, (buf), (val), (length))
 
 /*
  * We want to detect the case where we add the same value to a long
@@ -261,20 +261,44 @@ fast_composite_in_8_8 (pixman_implementation_t *imp,
     }
 }
 
+static force_inline void
+over_n_8_8888_row (uint32_t *dst, const uint8_t *mask, int32_t w, uint32_t src)
+{
+    uint32_t srca = src >> 24;
+    uint32_t d;
+    uint8_t m;
+
+    while (w--)
+    {
+	m = *mask++;
+	if (m == 0xff)
+	{
+	    if (srca == 0xff)
+		*dst = src;
+	    else
+		*dst = over (src, *dst);
+	}
+	else if (m)
+	{
+	    d = in (src, m);
+	    *dst = over (d, *dst);
+	}
+	dst++;
+    }
+}
+
 static void
 fast_composite_over_n_8_8888 (pixman_implementation_t *imp,
                               pixman_composite_info_t *info)
 {
     PIXMAN_COMPOSITE_ARGS (info);
-    uint32_t src, srca;
-    uint32_t    *dst_line, *dst, d;
-    uint8_t     *mask_line, *mask, m;
+    uint32_t src;
+    uint32_t    *dst_line;
+    uint8_t     *mask_line;
     int dst_stride, mask_stride;
-    int32_t w;
 
     src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
 
-    srca = src >> 24;
     if (src == 0)
 	return;
 
@@ -283,29 +307,45 @@ fast_composite_over_n_8_8888 (pixman_implementation_t *imp,
 
     while (height--)
     {
-	dst = dst_line;
+	over_n_8_8888_row (dst_line, mask_line, width, src);
+
 	dst_line += dst_stride;
-	mask = mask_line;
 	mask_line += mask_stride;
-	w = width;
+    }
+}
 
-	while (w--)
+static void
+fast_composite_over_n_8_8888_spans (pixman_implementation_t *imp,
+				    pixman_composite_info_t *info,
+				    const pixman_box32_t *   boxes,
+				    int                      n_boxes)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+    uint32_t    *dst_line;
+    uint8_t     *mask_line;
+    int dst_stride, mask_stride, i;
+    int mask_dx = mask_x - dest_x;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    if (src == 0)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (dest_image, 0, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (mask_image, 0, mask_y, uint8_t, mask_stride, mask_line, 1);
+
+    while (height--)
+    {
+	for (i = 0; i < n_boxes; i++)
 	{
-	    m = *mask++;
-	    if (m == 0xff)
-	    {
-		if (srca == 0xff)
-		    *dst = src;
-		else
-		    *dst = over (src, *dst);
-	    }
-	    else if (m)
-	    {
-		d = in (src, m);
-		*dst = over (d, *dst);
-	    }
-	    dst++;
+	    over_n_8_8888_row (dst_line + boxes[i].x1,
+			       mask_line + (boxes[i].x1 + mask_dx),
+			       boxes[i].x2 - boxes[i].x1, src);
 	}
+
+	dst_line += dst_stride;
+	mask_line += mask_stride;
     }
 }
 
@@ -589,38 +629,71 @@ fast_composite_over_n_8888_0565_ca (pixman_implementation_t *imp,
     }
 }
 
+static force_inline void
+over_8888_8888_row (uint32_t *dst, const uint32_t *src, int32_t w)
+{
+    uint32_t s;
+    uint8_t a;
+
+    while (w--)
+    {
+	s = *src++;
+	a = s >> 24;
+	if (a == 0xff)
+	    *dst = s;
+	else if (s)
+	    *dst = over (s, *dst);
+	dst++;
+    }
+}
+
 static void
 fast_composite_over_8888_8888 (pixman_implementation_t *imp,
                                pixman_composite_info_t *info)
 {
     PIXMAN_COMPOSITE_ARGS (info);
-    uint32_t    *dst_line, *dst;
-    uint32_t    *src_line, *src, s;
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
     int dst_stride, src_stride;
-    uint8_t a;
-    int32_t w;
 
     PIXMAN_IMAGE_GET_LINE (dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
     PIXMAN_IMAGE_GET_LINE (src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
 
     while (height--)
     {
-	dst = dst_line;
+	over_8888_8888_row (dst_line, src_line, width);
+
 	dst_line += dst_stride;
-	src = src_line;
 	src_line += src_stride;
-	w = width;
+    }
+}
 
-	while (w--)
+static void
+fast_composite_over_8888_8888_spans (pixman_implementation_t *imp,
+				     pixman_composite_info_t *info,
+				     const pixman_box32_t *   boxes,
+				     int                      n_boxes)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+    int dst_stride, src_stride, i;
+    int src_dx = src_x - dest_x;
+
+    PIXMAN_IMAGE_GET_LINE (dest_image, 0, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (src_image, 0, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	for (i = 0; i < n_boxes; i++)
 	{
-	    s = *src++;
-	    a = s >> 24;
-	    if (a == 0xff)
-		*dst = s;
-	    else if (s)
-		*dst = over (s, *dst);
-	    dst++;
+	    over_8888_8888_row (dst_line + boxes[i].x1,
+				src_line + (boxes[i].x1 + src_dx),
+				boxes[i].x2 - boxes[i].x1);
 	}
+
+	dst_line += dst_stride;
+	src_line += src_stride;
     }
 }
 
@@ -1156,6 +1229,74 @@ fast_composite_solid_fill (pixman_implementation_t *imp,
                  src);
 }
 
+/* Spans that are narrower than this many bytes are filled here, since
+ * they are too short for pixman_fill() to be worth its overhead.
+ */
+#define SOLID_FILL_SPANS_MIN_FILL	256
+
+static void
+fast_composite_solid_fill_spans (pixman_implementation_t *imp,
+				 pixman_composite_info_t *info,
+				 const pixman_box32_t *   boxes,
+				 int                      n_boxes)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int bpp = PIXMAN_FORMAT_BPP (dest_image->bits.format);
+    int stride = dest_image->bits.rowstride * 4;
+    uint8_t *first_line, *line;
+    uint32_t src;
+    int i, j, h;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    if (dest_image->bits.format == PIXMAN_a8)
+    {
+	src = src >> 24;
+    }
+    else if (dest_image->bits.format == PIXMAN_r5g6b5 ||
+             dest_image->bits.format == PIXMAN_b5g6r5)
+    {
+	src = convert_8888_to_0565 (src);
+    }
+
+    first_line = (uint8_t *)dest_image->bits.bits + dest_y * stride;
+
+    for (i = 0; i < n_boxes; i++)
+    {
+	int x = boxes[i].x1;
+	int w = boxes[i].x2 - x;
+
+	if (w * bpp >= SOLID_FILL_SPANS_MIN_FILL * 8)
+	{
+	    pixman_fill (dest_image->bits.bits, dest_image->bits.rowstride,
+			 bpp, x, dest_y, w, height, src);
+	    continue;
+	}
+
+	for (h = 0, line = first_line; h < height; h++, line += stride)
+	{
+	    if (bpp == 8)
+	    {
+		memset (line + x, src, w);
+	    }
+	    else if (bpp == 16)
+	    {
+		uint16_t *d = (uint16_t *)line + x;
+
+		for (j = 0; j < w; j++)
+		    d[j] = src;
+	    }
+	    else
+	    {
+		uint32_t *d = (uint32_t *)line + x;
+
+		for (j = 0; j < w; j++)
+		    d[j] = src;
+	    }
+	}
+    }
+}
+
 static void
 fast_composite_src_memcpy (pixman_implementation_t *imp,
 			   pixman_composite_info_t *info)
@@ -1182,6 +1323,39 @@ fast_composite_src_memcpy (pixman_implementation_t *imp,
     }
 }
 
+static void
+fast_composite_src_memcpy_spans (pixman_implementation_t *imp,
+				 pixman_composite_info_t *info,
+				 const pixman_box32_t *   boxes,
+				 int                      n_boxes)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int bpp = PIXMAN_FORMAT_BPP (dest_image->bits.format) / 8;
+    int dst_stride, src_stride, i;
+    int src_dx = src_x - dest_x;
+    uint8_t    *dst;
+    uint8_t    *src;
+
+    src_stride = src_image->bits.rowstride * 4;
+    dst_stride = dest_image->bits.rowstride * 4;
+
+    src = (uint8_t *)src_image->bits.bits + src_y * src_stride;
+    dst = (uint8_t *)dest_image->bits.bits + dest_y * dst_stride;
+
+    while (height--)
+    {
+	for (i = 0; i < n_boxes; i++)
+	{
+	    memcpy (dst + boxes[i].x1 * bpp,
+		    src + (boxes[i].x1 + src_dx) * bpp,
+		    (boxes[i].x2 - boxes[i].x1) * bpp);
+	}
+
+	dst += dst_stride;
+	src += src_stride;
+    }
+}
+
 FAST_NEAREST (8888_8888_cover, 8888, 8888, uint32_t, uint32_t, SRC, COVER)
 FAST_NEAREST (8888_8888_none, 8888, 8888, uint32_t, uint32_t, SRC, NONE)
 FAST_NEAREST (8888_8888_pad, 8888, 8888, uint32_t, uint32_t, SRC, PAD)
@@ -1818,10 +1992,10 @@ static const pixman_fast_path_t c_fast_paths[] =
     PIXMAN_STD_FAST_PATH (OVER, solid, a8, b5g6r5, fast_composite_over_n_8_0565),
     PIXMAN_STD_FAST_PATH (OVER, solid, a8, r8g8b8, fast_composite_over_n_8_0888),
     PIXMAN_STD_FAST_PATH (OVER, solid, a8, b8g8r8, fast_composite_over_n_8_0888),
-    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8r8g8b8, fast_composite_over_n_8_8888),
-    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8r8g8b8, fast_composite_over_n_8_8888),
-    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8b8g8r8, fast_composite_over_n_8_8888),
-    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8b8g8r8, fast_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, a8, a8r8g8b8, fast_composite_over_n_8_8888, fast_composite_over_n_8_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, a8, x8r8g8b8, fast_composite_over_n_8_8888, fast_composite_over_n_8_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, a8, a8b8g8r8, fast_composite_over_n_8_8888, fast_composite_over_n_8_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, a8, x8b8g8r8, fast_composite_over_n_8_8888, fast_composite_over_n_8_8888_spans),
     PIXMAN_STD_FAST_PATH (OVER, solid, a1, a8r8g8b8, fast_composite_over_n_1_8888),
     PIXMAN_STD_FAST_PATH (OVER, solid, a1, x8r8g8b8, fast_composite_over_n_1_8888),
     PIXMAN_STD_FAST_PATH (OVER, solid, a1, a8b8g8r8, fast_composite_over_n_1_8888),
@@ -1838,11 +2012,11 @@ static const pixman_fast_path_t c_fast_paths[] =
     PIXMAN_STD_FAST_PATH (OVER, x8r8g8b8, a8, a8r8g8b8, fast_composite_over_x888_8_8888),
     PIXMAN_STD_FAST_PATH (OVER, x8b8g8r8, a8, x8b8g8r8, fast_composite_over_x888_8_8888),
     PIXMAN_STD_FAST_PATH (OVER, x8b8g8r8, a8, a8b8g8r8, fast_composite_over_x888_8_8888),
-    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, a8r8g8b8, fast_composite_over_8888_8888),
-    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, x8r8g8b8, fast_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, a8r8g8b8, null, a8r8g8b8, fast_composite_over_8888_8888, fast_composite_over_8888_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, a8r8g8b8, null, x8r8g8b8, fast_composite_over_8888_8888, fast_composite_over_8888_8888_spans),
     PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, r5g6b5, fast_composite_over_8888_0565),
-    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, a8b8g8r8, fast_composite_over_8888_8888),
-    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, x8b8g8r8, fast_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, a8b8g8r8, null, a8b8g8r8, fast_composite_over_8888_8888, fast_composite_over_8888_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, a8b8g8r8, null, x8b8g8r8, fast_composite_over_8888_8888, fast_composite_over_8888_8888_spans),
     PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, b5g6r5, fast_composite_over_8888_0565),
     PIXMAN_STD_FAST_PATH (ADD, r5g6b5, null, r5g6b5, fast_composite_add_0565_0565),
     PIXMAN_STD_FAST_PATH (ADD, b5g6r5, null, b5g6r5, fast_composite_add_0565_0565),
@@ -1852,31 +2026,31 @@ static const pixman_fast_path_t c_fast_paths[] =
     PIXMAN_STD_FAST_PATH (ADD, a1, null, a1, fast_composite_add_1_1),
     PIXMAN_STD_FAST_PATH_CA (ADD, solid, a8r8g8b8, a8r8g8b8, fast_composite_add_n_8888_8888_ca),
     PIXMAN_STD_FAST_PATH (ADD, solid, a8, a8, fast_composite_add_n_8_8),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, a8r8g8b8, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, x8r8g8b8, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, a8b8g8r8, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, x8b8g8r8, fast_composite_solid_fill),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, solid, null, a8r8g8b8, fast_composite_solid_fill, fast_composite_solid_fill_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, solid, null, x8r8g8b8, fast_composite_solid_fill, fast_composite_solid_fill_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, solid, null, a8b8g8r8, fast_composite_solid_fill, fast_composite_solid_fill_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, solid, null, x8b8g8r8, fast_composite_solid_fill, fast_composite_solid_fill_spans),
     PIXMAN_STD_FAST_PATH (SRC, solid, null, a1, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, a8, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, r5g6b5, fast_composite_solid_fill),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, solid, null, a8, fast_composite_solid_fill, fast_composite_solid_fill_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, solid, null, r5g6b5, fast_composite_solid_fill, fast_composite_solid_fill_spans),
     PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, a8r8g8b8, fast_composite_src_x888_8888),
     PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, a8b8g8r8, fast_composite_src_x888_8888),
-    PIXMAN_STD_FAST_PATH (SRC, a8r8g8b8, null, x8r8g8b8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, a8r8g8b8, null, a8r8g8b8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, x8r8g8b8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, a8b8g8r8, null, x8b8g8r8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, a8b8g8r8, null, a8b8g8r8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, x8b8g8r8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, b8g8r8a8, null, b8g8r8x8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, b8g8r8a8, null, b8g8r8a8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, b8g8r8x8, null, b8g8r8x8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, r5g6b5, null, r5g6b5, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, b5g6r5, null, b5g6r5, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, r8g8b8, null, r8g8b8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, b8g8r8, null, b8g8r8, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, x1r5g5b5, null, x1r5g5b5, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, a1r5g5b5, null, x1r5g5b5, fast_composite_src_memcpy),
-    PIXMAN_STD_FAST_PATH (SRC, a8, null, a8, fast_composite_src_memcpy),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a8r8g8b8, null, x8r8g8b8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a8r8g8b8, null, a8r8g8b8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, x8r8g8b8, null, x8r8g8b8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a8b8g8r8, null, x8b8g8r8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a8b8g8r8, null, a8b8g8r8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, x8b8g8r8, null, x8b8g8r8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, b8g8r8a8, null, b8g8r8x8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, b8g8r8a8, null, b8g8r8a8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, b8g8r8x8, null, b8g8r8x8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, r5g6b5, null, r5g6b5, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, b5g6r5, null, b5g6r5, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, r8g8b8, null, r8g8b8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, b8g8r8, null, b8g8r8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, x1r5g5b5, null, x1r5g5b5, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a1r5g5b5, null, x1r5g5b5, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a8, null, a8, fast_composite_src_memcpy, fast_composite_src_memcpy_spans),
     PIXMAN_STD_FAST_PATH (IN, a8, null, a8, fast_composite_in_8_8),
     PIXMAN_STD_FAST_PATH (IN, solid, a8, a8, fast_composite_in_n_8_8),
 
@@ -2698,8 +2872,6 @@ bits_image_fetch_bilinear_no_repeat_8888 (pixman_iter_t *iter,
     return iter->buffer;
 }
 
-typedef uint32_t (* convert_pixel_t) (const uint8_t *row, int x);
-
 static force_inline void
 bits_image_fetch_separable_convolution_affine (pixman_image_t * image,
 					       int              offset,
@@ -2846,6 +3018,123 @@ bits_image_fetch_separable_convolution_affine (pixman_image_t * image,
 
 static const uint8_t zero[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
 
+static force_inline uint32_t
+bits_image_fetch_bilinear_pixel (bits_image_t *		bits,
+				 pixman_fixed_t		x,
+				 pixman_fixed_t		y,
+
+				 convert_pixel_t	convert_pixel,
+				 pixman_format_code_t	format,
+				 pixman_repeat_t	repeat_mode)
+{
+    int x1, y1, x2, y2;
+    uint32_t tl, tr, bl, br;
+    int32_t distx, disty;
+    int width = bits->width;
+    int height = bits->height;
+    const uint8_t *row1;
+    const uint8_t *row2;
+
+    x1 = x - pixman_fixed_1 / 2;
+    y1 = y - pixman_fixed_1 / 2;
+
+    distx = pixman_fixed_to_bilinear_weight (x1);
+    disty = pixman_fixed_to_bilinear_weight (y1);
+
+    y1 = pixman_fixed_to_int (y1);
+    y2 = y1 + 1;
+    x1 = pixman_fixed_to_int (x1);
+    x2 = x1 + 1;
+
+    if (repeat_mode != PIXMAN_REPEAT_NONE)
+    {
+	uint32_t mask;
+
+	mask = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
+
+	repeat (repeat_mode, &x1, width);
+	repeat (repeat_mode, &y1, height);
+	repeat (repeat_mode, &x2, width);
+	repeat (repeat_mode, &y2, height);
+
+	row1 = (uint8_t *)bits->bits + bits->rowstride * 4 * y1;
+	row2 = (uint8_t *)bits->bits + bits->rowstride * 4 * y2;
+
+	tl = convert_pixel (row1, x1) | mask;
+	tr = convert_pixel (row1, x2) | mask;
+	bl = convert_pixel (row2, x1) | mask;
+	br = convert_pixel (row2, x2) | mask;
+    }
+    else
+    {
+	uint32_t mask1, mask2;
+	int bpp;
+
+	/* Note: PIXMAN_FORMAT_BPP() returns an unsigned value,
+	 * which means if you use it in expressions, those
+	 * expressions become unsigned themselves. Since
+	 * the variables below can be negative in some cases,
+	 * that will lead to crashes on 64 bit architectures.
+	 *
+	 * So this line makes sure bpp is signed
+	 */
+	bpp = PIXMAN_FORMAT_BPP (format);
+
+	if (x1 >= width || x2 < 0 || y1 >= height || y2 < 0)
+	    return 0;
+
+	if (y2 == 0)
+	{
+	    row1 = zero;
+	    mask1 = 0;
+	}
+	else
+	{
+	    row1 = (uint8_t *)bits->bits + bits->rowstride * 4 * y1;
+	    row1 += bpp / 8 * x1;
+
+	    mask1 = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
+	}
+
+	if (y1 == height - 1)
+	{
+	    row2 = zero;
+	    mask2 = 0;
+	}
+	else
+	{
+	    row2 = (uint8_t *)bits->bits + bits->rowstride * 4 * y2;
+	    row2 += bpp / 8 * x1;
+
+	    mask2 = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
+	}
+
+	if (x2 == 0)
+	{
+	    tl = 0;
+	    bl = 0;
+	}
+	else
+	{
+	    tl = convert_pixel (row1, 0) | mask1;
+	    bl = convert_pixel (row2, 0) | mask2;
+	}
+
+	if (x1 == width - 1)
+	{
+	    tr = 0;
+	    br = 0;
+	}
+	else
+	{
+	    tr = convert_pixel (row1, 1) | mask1;
+	    br = convert_pixel (row2, 1) | mask2;
+	}
+    }
+
+    return bilinear_interpolation (tl, tr, bl, br, distx, disty);
+}
+
 static force_inline void
 bits_image_fetch_bilinear_affine (pixman_image_t * image,
 				  int              offset,
@@ -2857,11 +3146,56 @@ bits_image_fetch_bilinear_affine (pixman_image_t * image,
 				  convert_pixel_t	convert_pixel,
 				  pixman_format_code_t	format,
 				  pixman_repeat_t	repeat_mode)
+{
+    pixman_fixed_t x, y;
+    pixman_fixed_t ux, uy;
+    pixman_vector_t v;
+    int i;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (offset) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (line) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	return;
+
+    ux = image->common.transform->matrix[0][0];
+    uy = image->common.transform->matrix[1][0];
+
+    x = v.vector[0];
+    y = v.vector[1];
+
+    for (i = 0; i < width; ++i)
+    {
+	if (!mask || mask[i])
+	{
+	    buffer[i] = bits_image_fetch_bilinear_pixel (
+		&image->bits, x, y, convert_pixel, format, repeat_mode);
+	}
+
+	x += ux;
+	y += uy;
+    }
+}
+
+static force_inline void
+bits_image_fetch_bicubic_affine (pixman_image_t * image,
+				 int              offset,
+				 int              line,
+				 int              width,
+				 uint32_t *       buffer,
+				 const uint32_t * mask,
+
+				 convert_pixel_t	convert_pixel,
+				 pixman_format_code_t	format,
+				 pixman_repeat_t	repeat_mode)
 {
     pixman_fixed_t x, y;
     pixman_fixed_t ux, uy;
     pixman_vector_t v;
     bits_image_t *bits = &image->bits;
+    uint32_t amask = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
     int i;
 
     /* reference point is the center of the pixel */
@@ -2880,13 +3214,11 @@ bits_image_fetch_bilinear_affine (pixman_image_t * image,
 
     for (i = 0; i < width; ++i)
     {
-	int x1, y1, x2, y2;
-	uint32_t tl, tr, bl, br;
-	int32_t distx, disty;
-	int width = image->bits.width;
-	int height = image->bits.height;
-	const uint8_t *row1;
-	const uint8_t *row2;
+	const uint8_t *rows[4];
+	uint32_t pixels[16];
+	int32_t wx[4], wy[4];
+	int xs[4];
+	int x1, y1, j, k;
 
 	if (mask && !mask[i])
 	    goto next;
@@ -2894,105 +3226,52 @@ bits_image_fetch_bilinear_affine (pixman_image_t * image,
 	x1 = x - pixman_fixed_1 / 2;
 	y1 = y - pixman_fixed_1 / 2;
 
-	distx = pixman_fixed_to_bilinear_weight (x1);
-	disty = pixman_fixed_to_bilinear_weight (y1);
+	pixman_fixed_to_bicubic_weights (x1, wx);
+	pixman_fixed_to_bicubic_weights (y1, wy);
 
-	y1 = pixman_fixed_to_int (y1);
-	y2 = y1 + 1;
-	x1 = pixman_fixed_to_int (x1);
-	x2 = x1 + 1;
+	x1 = pixman_fixed_to_int (x1) - 1;
+	y1 = pixman_fixed_to_int (y1) - 1;
 
-	if (repeat_mode != PIXMAN_REPEAT_NONE)
+	if (repeat_mode == PIXMAN_REPEAT_NONE &&
+	    (x1 >= bits->width || x1 + 3 < 0 ||
+	     y1 >= bits->height || y1 + 3 < 0))
 	{
-	    uint32_t mask;
-
-	    mask = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
-
-	    repeat (repeat_mode, &x1, width);
-	    repeat (repeat_mode, &y1, height);
-	    repeat (repeat_mode, &x2, width);
-	    repeat (repeat_mode, &y2, height);
-
-	    row1 = (uint8_t *)bits->bits + bits->rowstride * 4 * y1;
-	    row2 = (uint8_t *)bits->bits + bits->rowstride * 4 * y2;
-
-	    tl = convert_pixel (row1, x1) | mask;
-	    tr = convert_pixel (row1, x2) | mask;
-	    bl = convert_pixel (row2, x1) | mask;
-	    br = convert_pixel (row2, x2) | mask;
+	    buffer[i] = 0;
+	    goto next;
 	}
-	else
-	{
-	    uint32_t mask1, mask2;
-	    int bpp;
-
-	    /* Note: PIXMAN_FORMAT_BPP() returns an unsigned value,
-	     * which means if you use it in expressions, those
-	     * expressions become unsigned themselves. Since
-	     * the variables below can be negative in some cases,
-	     * that will lead to crashes on 64 bit architectures.
-	     *
-	     * So this line makes sure bpp is signed
-	     */
-	    bpp = PIXMAN_FORMAT_BPP (format);
-
-	    if (x1 >= width || x2 < 0 || y1 >= height || y2 < 0)
-	    {
-		buffer[i] = 0;
-		goto next;
-	    }
-
-	    if (y2 == 0)
-	    {
-		row1 = zero;
-		mask1 = 0;
-	    }
-	    else
-	    {
-		row1 = (uint8_t *)bits->bits + bits->rowstride * 4 * y1;
-		row1 += bpp / 8 * x1;
 
-		mask1 = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
-	    }
+	for (j = 0; j < 4; ++j)
+	{
+	    int ry = y1 + j;
 
-	    if (y1 == height - 1)
-	    {
-		row2 = zero;
-		mask2 = 0;
-	    }
-	    else
-	    {
-		row2 = (uint8_t *)bits->bits + bits->rowstride * 4 * y2;
-		row2 += bpp / 8 * x1;
+	    xs[j] = x1 + j;
 
-		mask2 = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
-	    }
+	    if (!repeat (repeat_mode, &xs[j], bits->width))
+		xs[j] = -1;
 
-	    if (x2 == 0)
-	    {
-		tl = 0;
-		bl = 0;
-	    }
+	    if (repeat (repeat_mode, &ry, bits->height))
+		rows[j] = (uint8_t *)bits->bits + bits->rowstride * 4 * ry;
 	    else
-	    {
-		tl = convert_pixel (row1, 0) | mask1;
-		bl = convert_pixel (row2, 0) | mask2;
-	    }
+		rows[j] = NULL;
+	}
 
-	    if (x1 == width - 1)
-	    {
-		tr = 0;
-		br = 0;
-	    }
-	    else
+	for (j = 0; j < 4; ++j)
+	{
+	    for (k = 0; k < 4; ++k)
 	    {
-		tr = convert_pixel (row1, 1) | mask1;
-		br = convert_pixel (row2, 1) | mask2;
+		if (repeat_mode == PIXMAN_REPEAT_NONE &&
+		    (rows[j] == NULL || xs[k] < 0))
+		{
+		    pixels[j * 4 + k] = 0;
+		}
+		else
+		{
+		    pixels[j * 4 + k] = convert_pixel (rows[j], xs[k]) | amask;
+		}
 	    }
 	}
 
-	buffer[i] = bilinear_interpolation (
-	    tl, tr, bl, br, distx, disty);
+	buffer[i] = bicubic_interpolation (pixels, wx, wy);
 
     next:
 	x += ux;
@@ -3000,6 +3279,39 @@ bits_image_fetch_bilinear_affine (pixman_image_t * image,
     }
 }
 
+static force_inline uint32_t
+bits_image_fetch_nearest_pixel (bits_image_t *		bits,
+				pixman_fixed_t		x,
+				pixman_fixed_t		y,
+
+				convert_pixel_t		convert_pixel,
+				pixman_format_code_t	format,
+				pixman_repeat_t		repeat_mode)
+{
+    int width = bits->width;
+    int height = bits->height;
+    int x0 = pixman_fixed_to_int (x - pixman_fixed_e);
+    int y0 = pixman_fixed_to_int (y - pixman_fixed_e);
+    uint32_t mask = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
+    const uint8_t *row;
+
+    if (repeat_mode == PIXMAN_REPEAT_NONE &&
+	(y0 < 0 || y0 >= height || x0 < 0 || x0 >= width))
+    {
+	return 0;
+    }
+
+    if (repeat_mode != PIXMAN_REPEAT_NONE)
+    {
+	repeat (repeat_mode, &x0, width);
+	repeat (repeat_mode, &y0, height);
+    }
+
+    row = (uint8_t *)bits->bits + bits->rowstride * 4 * y0;
+
+    return convert_pixel (row, x0) | mask;
+}
+
 static force_inline void
 bits_image_fetch_nearest_affine (pixman_image_t * image,
 				 int              offset,
@@ -3015,7 +3327,6 @@ bits_image_fetch_nearest_affine (pixman_image_t * image,
     pixman_fixed_t x, y;
     pixman_fixed_t ux, uy;
     pixman_vector_t v;
-    bits_image_t *bits = &image->bits;
     int i;
 
     /* reference point is the center of the pixel */
@@ -3034,65 +3345,112 @@ bits_image_fetch_nearest_affine (pixman_image_t * image,
 
     for (i = 0; i < width; ++i)
     {
-	int width, height, x0, y0;
-	const uint8_t *row;
-
-	if (mask && !mask[i])
-	    goto next;
-	
-	width = image->bits.width;
-	height = image->bits.height;
-	x0 = pixman_fixed_to_int (x - pixman_fixed_e);
-	y0 = pixman_fixed_to_int (y - pixman_fixed_e);
-
-	if (repeat_mode == PIXMAN_REPEAT_NONE &&
-	    (y0 < 0 || y0 >= height || x0 < 0 || x0 >= width))
+	if (!mask || mask[i])
 	{
-	    buffer[i] = 0;
+	    buffer[i] = bits_image_fetch_nearest_pixel (
+		&image->bits, x, y, convert_pixel, format, repeat_mode);
 	}
-	else
-	{
-	    uint32_t mask = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
-
-	    if (repeat_mode != PIXMAN_REPEAT_NONE)
-	    {
-		repeat (repeat_mode, &x0, width);
-		repeat (repeat_mode, &y0, height);
-	    }
-
-	    row = (uint8_t *)bits->bits + bits->rowstride * 4 * y0;
 
-	    buffer[i] = convert_pixel (row, x0) | mask;
-	}
-
-    next:
 	x += ux;
 	y += uy;
     }
 }
 
-static force_inline uint32_t
-convert_a8r8g8b8 (const uint8_t *row, int x)
-{
-    return *(((uint32_t *)row) + x);
-}
+/* Projective transforms are walked with homogeneous coordinates that
+ * are stepped incrementally along the scanline, so each pixel costs a
+ * single reciprocal instead of a full 3x3 transform. The coordinates
+ * are kept in double precision; that represents every 16.16 step exactly
+ * and the divided results are as accurate as those of the general
+ * fetcher.
+ */
+#define PROJECTIVE_COORD_LIMIT	((double)pixman_int_to_fixed (0x7fff))
 
-static force_inline uint32_t
-convert_x8r8g8b8 (const uint8_t *row, int x)
+static force_inline pixman_fixed_t
+projective_to_fixed (double c, double inv_w)
 {
-    return *(((uint32_t *)row) + x);
-}
+    c *= inv_w;
 
-static force_inline uint32_t
-convert_a8 (const uint8_t *row, int x)
-{
-    return (uint32_t) *(row + x) << 24;
+    /* The source can be arbitrarily far away near the horizon; clamp it
+     * to the 16.16 range, less one pixel at either end so that the half
+     * pixel offsets of the filters cannot overflow.
+     */
+    if (c > PROJECTIVE_COORD_LIMIT)
+	return (pixman_fixed_t)PROJECTIVE_COORD_LIMIT;
+    if (c < -PROJECTIVE_COORD_LIMIT)
+	return -(pixman_fixed_t)PROJECTIVE_COORD_LIMIT;
+
+    return (pixman_fixed_t)c;
 }
 
-static force_inline uint32_t
-convert_r5g6b5 (const uint8_t *row, int x)
+static force_inline void
+bits_image_fetch_projective (pixman_image_t *	image,
+			     int		offset,
+			     int		line,
+			     int		width,
+			     uint32_t *		buffer,
+			     const uint32_t *	mask,
+
+			     pixman_bool_t	bilinear,
+			     convert_pixel_t	convert_pixel,
+			     pixman_format_code_t	format,
+			     pixman_repeat_t	repeat_mode)
 {
-    return convert_0565_to_0888 (*((uint16_t *)row + x));
+    pixman_vector_t v;
+    double x, y, w;
+    double ux, uy, uw;
+    int i;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (offset) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (line) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	return;
+
+    ux = image->common.transform->matrix[0][0];
+    uy = image->common.transform->matrix[1][0];
+    uw = image->common.transform->matrix[2][0];
+
+    x = v.vector[0];
+    y = v.vector[1];
+    w = v.vector[2];
+
+    for (i = 0; i < width; ++i)
+    {
+	if (!mask || mask[i])
+	{
+	    pixman_fixed_t x0, y0;
+
+	    if (w != 0)
+	    {
+		double inv_w = pixman_fixed_1 / w;
+
+		x0 = projective_to_fixed (x, inv_w);
+		y0 = projective_to_fixed (y, inv_w);
+	    }
+	    else
+	    {
+		x0 = 0;
+		y0 = 0;
+	    }
+
+	    if (bilinear)
+	    {
+		buffer[i] = bits_image_fetch_bilinear_pixel (
+		    &image->bits, x0, y0, convert_pixel, format, repeat_mode);
+	    }
+	    else
+	    {
+		buffer[i] = bits_image_fetch_nearest_pixel (
+		    &image->bits, x0, y0, convert_pixel, format, repeat_mode);
+	    }
+	}
+
+	x += ux;
+	y += uy;
+	w += uw;
+    }
 }
 
 #define MAKE_SEPARABLE_CONVOLUTION_FETCHER(name, format, repeat_mode)  \
@@ -3127,6 +3485,21 @@ convert_r5g6b5 (const uint8_t *row, int x)
 	return iter->buffer;						\
     }
 
+#define MAKE_BICUBIC_FETCHER(name, format, repeat_mode)			\
+    static uint32_t *							\
+    bits_image_fetch_bicubic_affine_ ## name (pixman_iter_t   *iter,	\
+					      const uint32_t * mask)	\
+    {									\
+	bits_image_fetch_bicubic_affine (iter->image,			\
+					 iter->x, iter->y++,		\
+					 iter->width,			\
+					 iter->buffer, mask,		\
+					 convert_ ## format,		\
+					 PIXMAN_ ## format,		\
+					 repeat_mode);			\
+	return iter->buffer;						\
+    }
+
 #define MAKE_NEAREST_FETCHER(name, format, repeat_mode)			\
     static uint32_t *							\
     bits_image_fetch_nearest_affine_ ## name (pixman_iter_t   *iter,	\
@@ -3142,10 +3515,29 @@ convert_r5g6b5 (const uint8_t *row, int x)
 	return iter->buffer;						\
     }
 
+#define MAKE_PROJECTIVE_FETCHER(name, format, repeat_mode, filter, bilinear) \
+    static uint32_t *							\
+    bits_image_fetch_ ## filter ## _projective_ ## name (pixman_iter_t   *iter, \
+							  const uint32_t * mask) \
+    {									\
+	bits_image_fetch_projective (iter->image,			\
+				     iter->x, iter->y++,		\
+				     iter->width,			\
+				     iter->buffer, mask,		\
+				     bilinear,				\
+				     convert_ ## format,		\
+				     PIXMAN_ ## format,			\
+				     repeat_mode);			\
+	return iter->buffer;						\
+    }
+
 #define MAKE_FETCHERS(name, format, repeat_mode)			\
     MAKE_NEAREST_FETCHER (name, format, repeat_mode)			\
     MAKE_BILINEAR_FETCHER (name, format, repeat_mode)			\
-    MAKE_SEPARABLE_CONVOLUTION_FETCHER (name, format, repeat_mode)
+    MAKE_BICUBIC_FETCHER (name, format, repeat_mode)			\
+    MAKE_SEPARABLE_CONVOLUTION_FETCHER (name, format, repeat_mode)	\
+    MAKE_PROJECTIVE_FETCHER (name, format, repeat_mode, nearest, FALSE) \
+    MAKE_PROJECTIVE_FETCHER (name, format, repeat_mode, bilinear, TRUE)
 
 MAKE_FETCHERS (pad_a8r8g8b8,     a8r8g8b8, PIXMAN_REPEAT_PAD)
 MAKE_FETCHERS (none_a8r8g8b8,    a8r8g8b8, PIXMAN_REPEAT_NONE)
@@ -3229,6 +3621,13 @@ static const pixman_iter_info_t fast_iters[] =
      FAST_PATH_AFFINE_TRANSFORM		|				\
      FAST_PATH_NEAREST_FILTER)
 
+#define GENERAL_BICUBIC_FLAGS						\
+    (FAST_PATH_NO_ALPHA_MAP		|				\
+     FAST_PATH_NO_ACCESSORS		|				\
+     FAST_PATH_HAS_TRANSFORM		|				\
+     FAST_PATH_AFFINE_TRANSFORM		|				\
+     FAST_PATH_BICUBIC_FILTER)
+
 #define GENERAL_SEPARABLE_CONVOLUTION_FLAGS				\
     (FAST_PATH_NO_ALPHA_MAP            |				\
      FAST_PATH_NO_ACCESSORS            |				\
@@ -3250,6 +3649,13 @@ static const pixman_iter_info_t fast_iters[] =
       NULL, bits_image_fetch_bilinear_affine_ ## name, NULL,		\
     },
 
+#define BICUBIC_AFFINE_FAST_PATH(name, format, repeat)			\
+    { PIXMAN_ ## format,						\
+      GENERAL_BICUBIC_FLAGS | FAST_PATH_ ## repeat ## _REPEAT,		\
+      ITER_NARROW | ITER_SRC,						\
+      NULL, bits_image_fetch_bicubic_affine_ ## name, NULL		\
+    },
+
 #define NEAREST_AFFINE_FAST_PATH(name, format, repeat)			\
     { PIXMAN_ ## format,						\
       GENERAL_NEAREST_FLAGS | FAST_PATH_ ## repeat ## _REPEAT,		\
@@ -3260,6 +3666,7 @@ static const pixman_iter_info_t fast_iters[] =
 #define AFFINE_FAST_PATHS(name, format, repeat)				\
     NEAREST_AFFINE_FAST_PATH(name, format, repeat)			\
     BILINEAR_AFFINE_FAST_PATH(name, format, repeat)			\
+    BICUBIC_AFFINE_FAST_PATH(name, format, repeat)			\
     SEPARABLE_CONVOLUTION_AFFINE_FAST_PATH(name, format, repeat)
     
     AFFINE_FAST_PATHS (pad_a8r8g8b8, a8r8g8b8, PAD)
@@ -3279,6 +3686,43 @@ static const pixman_iter_info_t fast_iters[] =
     AFFINE_FAST_PATHS (reflect_r5g6b5, r5g6b5, REFLECT)
     AFFINE_FAST_PATHS (normal_r5g6b5, r5g6b5, NORMAL)
 
+    /* The projective fetchers would also accept affine transforms, so they
+     * must come after all of the affine ones.
+     */
+#define GENERAL_PROJECTIVE_FLAGS					\
+    (FAST_PATH_NO_ALPHA_MAP		|				\
+     FAST_PATH_NO_ACCESSORS		|				\
+     FAST_PATH_HAS_TRANSFORM)
+
+#define PROJECTIVE_FAST_PATH(name, format, repeat, filter, FILTER)	\
+    { PIXMAN_ ## format,						\
+      GENERAL_PROJECTIVE_FLAGS | FAST_PATH_ ## FILTER ## _FILTER |	\
+      FAST_PATH_ ## repeat ## _REPEAT,					\
+      ITER_NARROW | ITER_SRC,						\
+      NULL, bits_image_fetch_ ## filter ## _projective_ ## name, NULL	\
+    },
+
+#define PROJECTIVE_FAST_PATHS(name, format, repeat)			\
+    PROJECTIVE_FAST_PATH(name, format, repeat, nearest, NEAREST)	\
+    PROJECTIVE_FAST_PATH(name, format, repeat, bilinear, BILINEAR)
+
+    PROJECTIVE_FAST_PATHS (pad_a8r8g8b8, a8r8g8b8, PAD)
+    PROJECTIVE_FAST_PATHS (none_a8r8g8b8, a8r8g8b8, NONE)
+    PROJECTIVE_FAST_PATHS (reflect_a8r8g8b8, a8r8g8b8, REFLECT)
+    PROJECTIVE_FAST_PATHS (normal_a8r8g8b8, a8r8g8b8, NORMAL)
+    PROJECTIVE_FAST_PATHS (pad_x8r8g8b8, x8r8g8b8, PAD)
+    PROJECTIVE_FAST_PATHS (none_x8r8g8b8, x8r8g8b8, NONE)
+    PROJECTIVE_FAST_PATHS (reflect_x8r8g8b8, x8r8g8b8, REFLECT)
+    PROJECTIVE_FAST_PATHS (normal_x8r8g8b8, x8r8g8b8, NORMAL)
+    PROJECTIVE_FAST_PATHS (pad_a8, a8, PAD)
+    PROJECTIVE_FAST_PATHS (none_a8, a8, NONE)
+    PROJECTIVE_FAST_PATHS (reflect_a8, a8, REFLECT)
+    PROJECTIVE_FAST_PATHS (normal_a8, a8, NORMAL)
+    PROJECTIVE_FAST_PATHS (pad_r5g6b5, r5g6b5, PAD)
+    PROJECTIVE_FAST_PATHS (none_r5g6b5, r5g6b5, NONE)
+    PROJECTIVE_FAST_PATHS (reflect_r5g6b5, r5g6b5, REFLECT)
+    PROJECTIVE_FAST_PATHS (normal_r5g6b5, r5g6b5, NORMAL)
+
     { PIXMAN_null },
 };
 
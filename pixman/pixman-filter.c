@@ -149,6 +149,26 @@ static const filter_info_t filters[] =
     { PIXMAN_KERNEL_LANCZOS3_STRETCHED, nice_kernel,      8.0 },
 };
 
+/* Evaluate @kernel at @x; the kernel is zero outside of the half-open
+ * interval [-width/2, width/2).
+ */
+double
+_pixman_filter_kernel (pixman_kernel_t kernel, double x)
+{
+    double half = filters[kernel].width / 2.0;
+
+    if (x < -half || x >= half)
+	return 0.0;
+
+    return filters[kernel].func (x);
+}
+
+double
+_pixman_filter_kernel_width (pixman_kernel_t kernel)
+{
+    return filters[kernel].width;
+}
+
 /* This function scales @kernel2 by @scale, then
  * aligns @x1 in @kernel1 with @x2 in @kernel2 and
  * and integrates the product of the kernels across @width.
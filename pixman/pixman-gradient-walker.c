@@ -26,6 +26,7 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
+#include <stdlib.h>
 #include "pixman-private.h"
 
 void
@@ -46,6 +47,7 @@ _pixman_gradient_walker_init (pixman_gradient_walker_t *walker,
     walker->b_s       = 0.0f;
     walker->b_b       = 0.0f;
     walker->repeat    = repeat;
+    walker->lut       = PIXMAN_ATOMIC_LOAD_PTR (&gradient->lut);
 
     walker->need_reset = TRUE;
 }
@@ -195,6 +197,33 @@ pixman_gradient_walker_pixel_32 (pixman_gradient_walker_t *walker,
     argb_t f;
     float y;
 
+    if (walker->lut)
+    {
+	int64_t t = x;
+
+	if (walker->repeat == PIXMAN_REPEAT_NORMAL)
+	{
+	    t = (int32_t)x & 0xffff;
+	}
+	else if (walker->repeat == PIXMAN_REPEAT_REFLECT)
+	{
+	    t = (int32_t)x & 0xffff;
+	    if ((int32_t)x & 0x10000)
+		t = 0x10000 - t;
+	}
+
+	/* Positions outside of the ramp, which only NONE and PAD have,
+	 * are interpolated as usual.
+	 */
+	if (t >= 0 && t < 0x10000)
+	{
+	    int i = t >> (16 - GRADIENT_LUT_BITS);
+
+	    if (!(walker->lut[GRADIENT_LUT_SIZE + (i >> 5)] & (1U << (i & 31))))
+		return walker->lut[i];
+	}
+    }
+
     if (walker->need_reset || x < walker->left_x || x >= walker->right_x)
 	gradient_walker_reset (walker, x);
 
@@ -262,3 +291,106 @@ _pixman_gradient_walker_fill_wide (pixman_gradient_walker_t *walker,
     while (buffer_wide < end_wide)
 	*buffer_wide++ = color;
 }
+
+/* Gradients that are drawn over and over spend most of their time in
+ * the walker. Once a gradient has produced as many narrow pixels as its
+ * colour ramp has entries, the ramp is sampled once into a table, which
+ * the walker then indexes instead of interpolating. Each entry is the
+ * colour at the center of its interval.
+ *
+ * Several threads may composite the same gradient, so the pixel count
+ * is updated atomically, and the table is published with a compare and
+ * swap. A thread that loses the race frees its own copy. Only
+ * validation, in gradient_property_changed(), drops the table.
+ *
+ * Positions in intervals that the entry does not reproduce within one
+ * unit are interpolated as usual. A bitmap after the table marks them:
+ * the intervals that contain a stop, where the colour may jump, and all
+ * intervals of a segment between two stops that is so steep that the
+ * colour changes by a unit or more over half an interval.
+ */
+static void
+gradient_lut_mark (uint32_t *bitmap, int64_t x1, int64_t x2)
+{
+    int i;
+
+    x1 = MAX (x1, 0);
+    x2 = MIN (x2, pixman_fixed_1);
+
+    if (x1 >= x2)
+	return;
+
+    for (i = x1 >> (16 - GRADIENT_LUT_BITS);
+	 i <= (x2 - 1) >> (16 - GRADIENT_LUT_BITS); ++i)
+    {
+	bitmap[i >> 5] |= 1U << (i & 31);
+    }
+}
+
+static pixman_bool_t
+gradient_segment_is_steep (const pixman_gradient_stop_t *left,
+			   const pixman_gradient_stop_t *right)
+{
+    int da = abs (right->color.alpha - left->color.alpha);
+    int dr = abs (right->color.red - left->color.red);
+    int dg = abs (right->color.green - left->color.green);
+    int db = abs (right->color.blue - left->color.blue);
+    int64_t width = (int64_t)right->x - left->x;
+
+    /* A premultiplied channel a * c changes by at most |da| + |dc| over
+     * the segment, in units of 65535.
+     */
+    return (int64_t)(da + MAX (MAX (dr, dg), db)) * 255 *
+	(1 << (15 - GRADIENT_LUT_BITS)) >= width * 65535;
+}
+
+void
+_pixman_gradient_prepare_lut (gradient_t *gradient, int width, int height)
+{
+    pixman_gradient_stop_t *stops = gradient->stops;
+    pixman_gradient_walker_t walker;
+    uint32_t *lut, *bitmap;
+    int i;
+
+    if (PIXMAN_ATOMIC_LOAD_PTR (&gradient->lut))
+	return;
+
+    if (height > 0 && width > GRADIENT_LUT_SIZE / height)
+	i = GRADIENT_LUT_SIZE;
+    else
+	i = MAX (width * height, 0);
+
+    if (PIXMAN_ATOMIC_ADD (&gradient->lut_pixels, i) < GRADIENT_LUT_SIZE)
+	return;
+
+    lut = pixman_malloc_ab (GRADIENT_LUT_SIZE + GRADIENT_LUT_SIZE / 32,
+			    sizeof (uint32_t));
+    if (!lut)
+	return;
+
+    _pixman_gradient_walker_init (&walker, gradient, gradient->common.repeat);
+
+    for (i = 0; i < GRADIENT_LUT_SIZE; ++i)
+    {
+	lut[i] = pixman_gradient_walker_pixel_32 (
+	    &walker, (i << (16 - GRADIENT_LUT_BITS)) + (1 << (15 - GRADIENT_LUT_BITS)));
+    }
+
+    bitmap = lut + GRADIENT_LUT_SIZE;
+    memset (bitmap, 0, GRADIENT_LUT_SIZE / 32 * sizeof (uint32_t));
+
+    /* The segments include the ones to the stops that the repeat mode
+     * adds before the first and after the last stop.
+     */
+    for (i = -1; i < gradient->n_stops; ++i)
+    {
+	if (i >= 0)
+	    gradient_lut_mark (bitmap, stops[i].x & 0xffff, (stops[i].x & 0xffff) + 1);
+
+	if (gradient_segment_is_steep (&stops[i], &stops[i + 1]))
+	    gradient_lut_mark (bitmap, stops[i].x, stops[i + 1].x);
+    }
+
+    if (!PIXMAN_ATOMIC_PUBLISH_PTR (&gradient->lut, lut))
+	free (lut);
+}
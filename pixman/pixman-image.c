@@ -73,6 +73,18 @@ gradient_property_changed (pixman_image_t *image)
 	end->color = stops[n - 1].color;
 	break;
     }
+
+    /* The colour ramp only depends on the stops and the repeat mode.
+     * Validation is the only place that drops the table; compositing
+     * only ever publishes a new one.
+     */
+    if (gradient->lut_repeat != gradient->common.repeat)
+    {
+	free (gradient->lut);
+	gradient->lut = NULL;
+	gradient->lut_pixels = 0;
+	gradient->lut_repeat = gradient->common.repeat;
+    }
 }
 
 pixman_bool_t
@@ -101,11 +113,49 @@ _pixman_init_gradient (gradient_t *                  gradient,
     memcpy (gradient->stops, stops, n_stops * sizeof (pixman_gradient_stop_t));
     gradient->n_stops = n_stops;
 
+    gradient->lut = NULL;
+    gradient->lut_repeat = gradient->common.repeat;
+    gradient->lut_pixels = 0;
+
     gradient->common.property_changed = gradient_property_changed;
 
     return TRUE;
 }
 
+/* Transform the center of pixel (x, y) into gradient space, along with
+ * the step from one pixel to the next.
+ */
+pixman_bool_t
+_pixman_gradient_transform (pixman_image_t  *image,
+			    int              x,
+			    int              y,
+			    pixman_vector_t *v,
+			    pixman_vector_t *unit)
+{
+    /* reference point is the center of the pixel */
+    v->vector[0] = pixman_int_to_fixed (x) + pixman_fixed_1 / 2;
+    v->vector[1] = pixman_int_to_fixed (y) + pixman_fixed_1 / 2;
+    v->vector[2] = pixman_fixed_1;
+
+    if (image->common.transform)
+    {
+	if (!pixman_transform_point_3d (image->common.transform, v))
+	    return FALSE;
+
+	unit->vector[0] = image->common.transform->matrix[0][0];
+	unit->vector[1] = image->common.transform->matrix[1][0];
+	unit->vector[2] = image->common.transform->matrix[2][0];
+    }
+    else
+    {
+	unit->vector[0] = pixman_fixed_1;
+	unit->vector[1] = 0;
+	unit->vector[2] = 0;
+    }
+
+    return TRUE;
+}
+
 void
 _pixman_image_init (pixman_image_t *image)
 {
@@ -161,6 +211,8 @@ _pixman_image_fini (pixman_image_t *image)
 		free (image->gradient.stops - 1);
 	    }
 
+	    free (image->gradient.lut);
+
 	    /* This will trigger if someone adds a property_changed
 	     * method to the linear/radial/conical gradient overwriting
 	     * the general one.
@@ -387,6 +439,10 @@ compute_image_info (pixman_image_t *image)
 	flags |= FAST_PATH_SEPARABLE_CONVOLUTION_FILTER;
 	break;
 
+    case PIXMAN_FILTER_BICUBIC:
+	flags |= FAST_PATH_BICUBIC_FILTER;
+	break;
+
     default:
 	flags |= FAST_PATH_NO_CONVOLUTION_FILTER;
 	break;
@@ -473,7 +529,7 @@ compute_image_info (pixman_image_t *image)
 	break;
 
     case RADIAL:
-	code = PIXMAN_unknown;
+	code = PIXMAN_radial_gradient;
 
 	/*
 	 * As explained in pixman-radial-gradient.c, every point of
@@ -489,7 +545,10 @@ compute_image_info (pixman_image_t *image)
 
     case CONICAL:
     case LINEAR:
-	code = PIXMAN_unknown;
+	if (image->type == LINEAR)
+	    code = PIXMAN_linear_gradient;
+	else if (image->type == CONICAL)
+	    code = PIXMAN_conical_gradient;
 
 	if (image->common.repeat != PIXMAN_REPEAT_NONE)
 	{
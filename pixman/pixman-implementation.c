@@ -71,17 +71,22 @@ dummy_composite_rect (pixman_implementation_t *imp,
 {
 }
 
+/* Like _pixman_implementation_lookup_composite(), but also return the
+ * function that composites a band at a time, or NULL if the fast path
+ * doesn't have one.
+ */
 void
-_pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
-					 pixman_op_t               op,
-					 pixman_format_code_t      src_format,
-					 uint32_t                  src_flags,
-					 pixman_format_code_t      mask_format,
-					 uint32_t                  mask_flags,
-					 pixman_format_code_t      dest_format,
-					 uint32_t                  dest_flags,
-					 pixman_implementation_t **out_imp,
-					 pixman_composite_func_t  *out_func)
+_pixman_implementation_lookup_composite_spans (pixman_implementation_t       *toplevel,
+					       pixman_op_t                    op,
+					       pixman_format_code_t           src_format,
+					       uint32_t                       src_flags,
+					       pixman_format_code_t           mask_format,
+					       uint32_t                       mask_flags,
+					       pixman_format_code_t           dest_format,
+					       uint32_t                       dest_flags,
+					       pixman_implementation_t      **out_imp,
+					       pixman_composite_func_t       *out_func,
+					       pixman_composite_spans_func_t *out_spans)
 {
     pixman_implementation_t *imp;
     cache_t *cache;
@@ -110,6 +115,7 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 	{
 	    *out_imp = cache->cache[i].imp;
 	    *out_func = cache->cache[i].fast_path.func;
+	    *out_spans = cache->cache[i].fast_path.spans;
 
 	    goto update_cache;
 	}
@@ -136,6 +142,7 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 	    {
 		*out_imp = imp;
 		*out_func = info->func;
+		*out_spans = info->spans;
 
 		/* Set i to the last spot in the cache so that the
 		 * move-to-front code below will work
@@ -159,6 +166,7 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 
     *out_imp = NULL;
     *out_func = dummy_composite_rect;
+    *out_spans = NULL;
     return;
 
 update_cache:
@@ -176,9 +184,30 @@ update_cache:
 	cache->cache[0].fast_path.dest_format = dest_format;
 	cache->cache[0].fast_path.dest_flags = dest_flags;
 	cache->cache[0].fast_path.func = *out_func;
+	cache->cache[0].fast_path.spans = *out_spans;
     }
 }
 
+void
+_pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
+					 pixman_op_t               op,
+					 pixman_format_code_t      src_format,
+					 uint32_t                  src_flags,
+					 pixman_format_code_t      mask_format,
+					 uint32_t                  mask_flags,
+					 pixman_format_code_t      dest_format,
+					 uint32_t                  dest_flags,
+					 pixman_implementation_t **out_imp,
+					 pixman_composite_func_t  *out_func)
+{
+    pixman_composite_spans_func_t spans;
+
+    _pixman_implementation_lookup_composite_spans (
+	toplevel, op,
+	src_format, src_flags, mask_format, mask_flags, dest_format, dest_flags,
+	out_imp, out_func, &spans);
+}
+
 static void
 dummy_combine (pixman_implementation_t *imp,
 	       pixman_op_t              op,
@@ -285,6 +314,26 @@ _pixman_implementation_fill (pixman_implementation_t *imp,
     return FALSE;
 }
 
+pixman_bool_t
+_pixman_implementation_add_saturate_8 (pixman_implementation_t *imp,
+                                       uint8_t *                dst,
+                                       int                      value,
+                                       int                      width)
+{
+    while (imp)
+    {
+	if (imp->add_saturate_8 &&
+	    ((*imp->add_saturate_8) (imp, dst, value, width)))
+	{
+	    return TRUE;
+	}
+
+	imp = imp->fallback;
+    }
+
+    return FALSE;
+}
+
 static uint32_t *
 get_scanline_null (pixman_iter_t *iter, const uint32_t *mask)
 {
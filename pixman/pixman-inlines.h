@@ -26,6 +26,7 @@
 #ifndef PIXMAN_FAST_PATH_H__
 #define PIXMAN_FAST_PATH_H__
 
+#include <stdlib.h>
 #include "pixman-private.h"
 
 #define PIXMAN_REPEAT_COVER -1
@@ -53,6 +54,13 @@
  */
 #define REPEAT_NORMAL_MIN_WIDTH			64
 
+/* Narrow NORMAL repeat sources are expanded to cover a whole destination
+ * row when that takes at most this many pixels. Rows up to the first limit
+ * are expanded on the stack.
+ */
+#define REPEAT_NORMAL_EXPANDED_STACK_WIDTH	512
+#define REPEAT_NORMAL_EXPANDED_MAX_WIDTH	16384
+
 static force_inline pixman_bool_t
 repeat (pixman_repeat_t repeat, int *c, int size)
 {
@@ -81,6 +89,57 @@ repeat (pixman_repeat_t repeat, int *c, int size)
     return TRUE;
 }
 
+/* Fill the first dst_size bytes of dst with copies of the src_size bytes
+ * at src. The copies double in size, so this takes only a few memcpy ()
+ * calls even for narrow rows.
+ */
+static force_inline void
+repeat_normal_expand_line (void *dst, size_t dst_size,
+			   const void *src, size_t src_size)
+{
+    size_t done = MIN (src_size, dst_size);
+
+    memcpy (dst, src, done);
+
+    while (done < dst_size)
+    {
+	size_t n = MIN (done, dst_size - done);
+
+	memcpy ((uint8_t *)dst + done, dst, n);
+	done += n;
+    }
+}
+
+/* Read pixel x of a scanline of one of the formats that have transformed
+ * fast path fetchers. The alpha channel of x8r8g8b8 and r5g6b5 is left
+ * undefined or zero; callers or in 0xff000000 for formats without alpha.
+ */
+typedef uint32_t (* convert_pixel_t) (const uint8_t *row, int x);
+
+static force_inline uint32_t
+convert_a8r8g8b8 (const uint8_t *row, int x)
+{
+    return *(((uint32_t *)row) + x);
+}
+
+static force_inline uint32_t
+convert_x8r8g8b8 (const uint8_t *row, int x)
+{
+    return *(((uint32_t *)row) + x);
+}
+
+static force_inline uint32_t
+convert_a8 (const uint8_t *row, int x)
+{
+    return (uint32_t) *(row + x) << 24;
+}
+
+static force_inline uint32_t
+convert_r5g6b5 (const uint8_t *row, int x)
+{
+    return convert_0565_to_0888 (*((uint16_t *)row + x));
+}
+
 static force_inline int
 pixman_fixed_to_bilinear_weight (pixman_fixed_t x)
 {
@@ -247,6 +306,117 @@ bilinear_interpolation_float (argb_t tl, argb_t tr,
     return r;
 }
 
+/* Weights of the four taps of the BICUBIC filter for the fractional
+ * position of x relative to the second tap. This is the Mitchell-Netravali
+ * cubic (B = C = 1/3) used for PIXMAN_KERNEL_CUBIC, expanded into one
+ * polynomial per tap. The weights are scaled by 18 * 2^24 before they are
+ * rounded down to BICUBIC_WEIGHT_BITS; the last one absorbs the rounding
+ * error so that they always sum to exactly 1 << BICUBIC_WEIGHT_BITS.
+ */
+#define BICUBIC_WEIGHT_BITS 12
+
+static force_inline int32_t
+bicubic_round_weight (int32_t n)
+{
+    const int32_t d = 18 << (24 - BICUBIC_WEIGHT_BITS);
+
+    return (n >= 0)? (n + d / 2) / d : (n - d / 2) / d;
+}
+
+static force_inline void
+pixman_fixed_to_bicubic_weights (pixman_fixed_t x, int32_t *w)
+{
+    int32_t t = pixman_fixed_frac (x) >> 8;
+    int32_t t2 = t * t;
+    int32_t t3 = t2 * t;
+
+    w[0] = bicubic_round_weight ((1 << 24) - 9 * (t << 16) + 15 * (t2 << 8) - 7 * t3);
+    w[1] = bicubic_round_weight ((16 << 24) - 36 * (t2 << 8) + 21 * t3);
+    w[3] = bicubic_round_weight (7 * t3 - 6 * (t2 << 8));
+    w[2] = (1 << BICUBIC_WEIGHT_BITS) - w[0] - w[1] - w[3];
+}
+
+static force_inline void
+pixman_fixed_to_bicubic_weights_float (pixman_fixed_t x, float *w)
+{
+    float t = ((float)pixman_fixed_fraction (x)) / 65536.f;
+    float t2 = t * t;
+    float t3 = t2 * t;
+
+    w[0] = (1.f - 9.f * t + 15.f * t2 - 7.f * t3) / 18.f;
+    w[1] = (16.f - 36.f * t2 + 21.f * t3) / 18.f;
+    w[2] = (1.f + 9.f * t + 27.f * t2 - 21.f * t3) / 18.f;
+    w[3] = (7.f * t3 - 6.f * t2) / 18.f;
+}
+
+/* Interpolate the 4x4 block of pixels p (four rows of four pixels) with
+ * the horizontal weights wx and the vertical weights wy. The columns are
+ * filtered first and kept with 8 fractional bits, which is enough to
+ * reproduce flat areas exactly. The cubic has negative lobes, so the
+ * result is clamped, and the colour channels are clamped to alpha to
+ * keep the pixel premultiplied.
+ */
+static force_inline uint32_t
+bicubic_interpolation (const uint32_t *p, const int32_t *wx, const int32_t *wy)
+{
+    int32_t c[4];
+    int i, j;
+
+    for (i = 0; i < 4; ++i)
+    {
+	int shift = 24 - 8 * i;
+	int32_t acc = 0;
+
+	for (j = 0; j < 4; ++j)
+	{
+	    int32_t col =
+		wy[0] * (int32_t)((p[j +  0] >> shift) & 0xff) +
+		wy[1] * (int32_t)((p[j +  4] >> shift) & 0xff) +
+		wy[2] * (int32_t)((p[j +  8] >> shift) & 0xff) +
+		wy[3] * (int32_t)((p[j + 12] >> shift) & 0xff);
+
+	    acc += wx[j] * (col >> (BICUBIC_WEIGHT_BITS - 8));
+	}
+
+	acc = (acc + (1 << (BICUBIC_WEIGHT_BITS + 7))) >> (BICUBIC_WEIGHT_BITS + 8);
+
+	c[i] = CLIP (acc, 0, 0xff);
+    }
+
+    c[1] = MIN (c[1], c[0]);
+    c[2] = MIN (c[2], c[0]);
+    c[3] = MIN (c[3], c[0]);
+
+    return (c[0] << 24) | (c[1] << 16) | (c[2] << 8) | c[3];
+}
+
+static force_inline argb_t
+bicubic_interpolation_float (const argb_t *p, const float *wx, const float *wy)
+{
+    argb_t r = { 0.f, 0.f, 0.f, 0.f };
+    int i, j;
+
+    for (i = 0; i < 4; ++i)
+    {
+	for (j = 0; j < 4; ++j)
+	{
+	    float f = wx[j] * wy[i];
+
+	    r.a += p[i * 4 + j].a * f;
+	    r.r += p[i * 4 + j].r * f;
+	    r.g += p[i * 4 + j].g * f;
+	    r.b += p[i * 4 + j].b * f;
+	}
+    }
+
+    r.a = CLIP (r.a, 0.f, 1.f);
+    r.r = CLIP (r.r, 0.f, r.a);
+    r.g = CLIP (r.g, 0.f, r.a);
+    r.b = CLIP (r.b, 0.f, r.a);
+
+    return r;
+}
+
 /*
  * For each scanline fetched from source image with PAD repeat:
  * - calculate how many pixels need to be padded on the left side
@@ -876,6 +1046,11 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
     pixman_fixed_t src_width_fixed;								\
     int max_x;											\
     pixman_bool_t need_src_extension;								\
+    src_type_t expanded_buf[PIXMAN_REPEAT_ ## repeat_mode == PIXMAN_REPEAT_NORMAL ?		\
+			    REPEAT_NORMAL_EXPANDED_STACK_WIDTH * 2 : 1];			\
+    src_type_t *expanded_line = NULL;								\
+    int expanded_width = 0;									\
+    int expanded_y1 = -1, expanded_y2 = -1;							\
 												\
     PIXMAN_IMAGE_GET_LINE (dest_image, dest_x, dest_y, dst_type_t, dst_stride, dst_line, 1);	\
     if (flags & FLAG_HAVE_SOLID_MASK)								\
@@ -947,6 +1122,26 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
 	}											\
 												\
 	src_width_fixed = pixman_int_to_fixed (src_width);					\
+												\
+	/* A narrow tile would need many short scanline calls and wrap-around			\
+	 * spans per row. Expand the two source rows to cover the whole row			\
+	 * instead, so that the row can be done in one call, as with COVER.			\
+	 * The expanded rows are reused for as long as the rows don't change.			\
+	 */											\
+	if (need_src_extension)									\
+	{											\
+	    expanded_width = max_x + 1;								\
+												\
+	    if (expanded_width <= REPEAT_NORMAL_EXPANDED_STACK_WIDTH)				\
+	    {											\
+		expanded_line = expanded_buf;							\
+	    }											\
+	    else if (expanded_width <= REPEAT_NORMAL_EXPANDED_MAX_WIDTH)			\
+	    {											\
+		expanded_line = pixman_malloc_ab (						\
+		    expanded_width, 2 * sizeof (src_type_t));					\
+	    }											\
+	}											\
     }												\
 												\
     while (--height >= 0)									\
@@ -1095,6 +1290,31 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
 			       buf1, buf2, right_pad, weight1, weight2, 0, 0, 0, TRUE);		\
 	    }											\
 	}											\
+	else if (PIXMAN_REPEAT_ ## repeat_mode == PIXMAN_REPEAT_NORMAL && expanded_line)	\
+	{											\
+	    src_type_t *line0 = expanded_line;							\
+	    src_type_t *line1 = expanded_line + expanded_width;					\
+												\
+	    repeat (PIXMAN_REPEAT_NORMAL, &y1, src_image->bits.height);				\
+	    repeat (PIXMAN_REPEAT_NORMAL, &y2, src_image->bits.height);				\
+												\
+	    if (y1 != expanded_y1 || y2 != expanded_y2)						\
+	    {											\
+		repeat_normal_expand_line (line0, expanded_width * sizeof (src_type_t),		\
+					   src_first_line + src_stride * y1,			\
+					   src_image->bits.width * sizeof (src_type_t));	\
+		repeat_normal_expand_line (line1, expanded_width * sizeof (src_type_t),		\
+					   src_first_line + src_stride * y2,			\
+					   src_image->bits.width * sizeof (src_type_t));	\
+		expanded_y1 = y1;								\
+		expanded_y2 = y2;								\
+	    }											\
+												\
+	    repeat (PIXMAN_REPEAT_NORMAL, &vx, pixman_int_to_fixed (src_image->bits.width));	\
+												\
+	    scanline_func (dst, mask, line0, line1, width, weight1, weight2,			\
+			   vx, unit_x, pixman_int_to_fixed (expanded_width), FALSE);		\
+	}											\
 	else if (PIXMAN_REPEAT_ ## repeat_mode == PIXMAN_REPEAT_NORMAL)				\
 	{											\
 	    int32_t	    num_pixels;								\
@@ -1202,6 +1422,9 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
 			   weight1, weight2, vx, unit_x, max_vx, FALSE);			\
 	}											\
     }												\
+												\
+    if (expanded_line && expanded_line != expanded_buf)						\
+	free (expanded_line);									\
 }
 
 /* A workaround for old sun studio, see: https://bugs.freedesktop.org/show_bug.cgi?id=32764 */
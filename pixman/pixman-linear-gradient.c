@@ -88,6 +88,59 @@ linear_gradient_is_horizontal (pixman_image_t *image,
     return FALSE;
 }
 
+/* The gradient parameter t at @v, in 16.16, and its increment per
+ * pixel. Only valid when the transformation is affine.
+ */
+static void
+linear_gradient_affine_params (linear_gradient_t     *linear,
+			       const pixman_vector_t *v,
+			       const pixman_vector_t *unit,
+			       pixman_fixed_32_32_t  *t,
+			       double                *inc)
+{
+    pixman_fixed_32_32_t l;
+    pixman_fixed_48_16_t dx, dy;
+
+    dx = linear->p2.x - linear->p1.x;
+    dy = linear->p2.y - linear->p1.y;
+
+    l = dx * dx + dy * dy;
+
+    if (l == 0 || v->vector[2] == 0)
+    {
+	*t = 0;
+	*inc = 0;
+    }
+    else
+    {
+	double invden, v2;
+
+	invden = pixman_fixed_1 * (double) pixman_fixed_1 /
+	    (l * (double) v->vector[2]);
+	v2 = v->vector[2] * (1. / pixman_fixed_1);
+	*t = ((dx * v->vector[0] + dy * v->vector[1]) -
+	      (dx * linear->p1.x + dy * linear->p1.y) * v2) * invden;
+	*inc = (dx * unit->vector[0] + dy * unit->vector[1]) * invden;
+    }
+}
+
+pixman_bool_t
+_pixman_linear_gradient_get_affine_params (pixman_image_t       *image,
+					   int                   x,
+					   int                   y,
+					   pixman_fixed_32_32_t *t,
+					   double               *inc)
+{
+    pixman_vector_t v, unit;
+
+    if (!_pixman_gradient_transform (image, x, y, &v, &unit))
+	return FALSE;
+
+    linear_gradient_affine_params (&image->linear, &v, &unit, t, inc);
+
+    return TRUE;
+}
+
 static uint32_t *
 linear_get_scanline (pixman_iter_t                 *iter,
 		     const uint32_t                *mask,
@@ -111,26 +164,8 @@ linear_get_scanline (pixman_iter_t                 *iter,
 
     _pixman_gradient_walker_init (&walker, gradient, image->common.repeat);
 
-    /* reference point is the center of the pixel */
-    v.vector[0] = pixman_int_to_fixed (x) + pixman_fixed_1 / 2;
-    v.vector[1] = pixman_int_to_fixed (y) + pixman_fixed_1 / 2;
-    v.vector[2] = pixman_fixed_1;
-
-    if (image->common.transform)
-    {
-	if (!pixman_transform_point_3d (image->common.transform, &v))
-	    return iter->buffer;
-
-	unit.vector[0] = image->common.transform->matrix[0][0];
-	unit.vector[1] = image->common.transform->matrix[1][0];
-	unit.vector[2] = image->common.transform->matrix[2][0];
-    }
-    else
-    {
-	unit.vector[0] = pixman_fixed_1;
-	unit.vector[1] = 0;
-	unit.vector[2] = 0;
-    }
+    if (!_pixman_gradient_transform (image, x, y, &v, &unit))
+	return iter->buffer;
 
     dx = linear->p2.x - linear->p1.x;
     dy = linear->p2.y - linear->p1.y;
@@ -143,22 +178,7 @@ linear_get_scanline (pixman_iter_t                 *iter,
 	pixman_fixed_32_32_t t, next_inc;
 	double inc;
 
-	if (l == 0 || v.vector[2] == 0)
-	{
-	    t = 0;
-	    inc = 0;
-	}
-	else
-	{
-	    double invden, v2;
-
-	    invden = pixman_fixed_1 * (double) pixman_fixed_1 /
-		(l * (double) v.vector[2]);
-	    v2 = v.vector[2] * (1. / pixman_fixed_1);
-	    t = ((dx * v.vector[0] + dy * v.vector[1]) -
-		 (dx * linear->p1.x + dy * linear->p1.y) * v2) * invden;
-	    inc = (dx * unit.vector[0] + dy * unit.vector[1]) * invden;
-	}
+	linear_gradient_affine_params (linear, &v, &unit, &t, &inc);
 	next_inc = 0;
 
 	if (((pixman_fixed_32_32_t )(inc * width)) == 0)
@@ -241,6 +261,9 @@ linear_get_scanline_wide (pixman_iter_t *iter, const uint32_t *mask)
 void
 _pixman_linear_gradient_iter_init (pixman_image_t *image, pixman_iter_t  *iter)
 {
+    if (iter->iter_flags & ITER_NARROW)
+	_pixman_gradient_prepare_lut (&image->gradient, iter->width, iter->height);
+
     if (linear_gradient_is_horizontal (
 	    iter->image, iter->x, iter->y, iter->width, iter->height))
     {
@@ -0,0 +1,815 @@
+/*
+ * Copyright © 2026 The pixman authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "pixman-private.h"
+
+/* Polygon rasterization with exact area coverage
+ *
+ * This is the signed area accumulation used by the FreeType "smooth"
+ * rasterizer. Every edge is cut into pieces that lie within a single
+ * pixel, and each piece adds to the cell of that pixel
+ *
+ *    cover: the height of the piece, signed by its direction
+ *    area:  the height times twice the average distance of the piece
+ *           from the left side of the pixel
+ *
+ * Cells are kept in a sorted list per row, so only pixels that edges go
+ * through take memory. A row is then swept from left to right: the
+ * running sum of the covers is the winding number of the pixels between
+ * cells, in units of 1/256 pixel, and a cell itself is covered by the
+ * running sum minus the area of its own pieces.
+ */
+
+#define POLYGON_BITS		8
+#define POLYGON_ONE		(1 << POLYGON_BITS)
+
+typedef struct
+{
+    int		x;
+    int		cover;
+    int		area;
+    int		next;
+} polygon_cell_t;
+
+typedef struct
+{
+    int			width;
+    int			height;
+    int *		rows;		/* First cell of each row, or -1 */
+    polygon_cell_t *	cells;
+    int			n_cells;
+    int			size;
+    int			last;		/* Last cell that was found */
+    int			last_y;		/* and its row */
+    pixman_bool_t	oom;
+} polygon_rasterizer_t;
+
+static pixman_bool_t
+polygon_rasterizer_init (polygon_rasterizer_t *rast, int width, int height)
+{
+    int i;
+
+    rast->width = width;
+    rast->height = height;
+    rast->cells = NULL;
+    rast->n_cells = 0;
+    rast->size = 0;
+    rast->last = -1;
+    rast->last_y = -1;
+    rast->oom = FALSE;
+
+    if (!(rast->rows = pixman_malloc_ab (height, sizeof (int))))
+	return FALSE;
+
+    for (i = 0; i < height; ++i)
+	rast->rows[i] = -1;
+
+    return TRUE;
+}
+
+static void
+polygon_rasterizer_fini (polygon_rasterizer_t *rast)
+{
+    free (rast->rows);
+    free (rast->cells);
+}
+
+/* Find or insert the cell of pixel (x, y). Pixels left of the raster
+ * all share the cell at x = -1, since only their cover matters.
+ */
+static polygon_cell_t *
+polygon_find_cell (polygon_rasterizer_t *rast, int x, int y)
+{
+    polygon_cell_t *cells = rast->cells;
+    int prev, idx;
+
+    if (x < 0)
+	x = -1;
+
+    /* Edges are walked one pixel at a time, so the search can usually
+     * start at the cell that was found last.
+     */
+    if (rast->last_y == y && cells[rast->last].x <= x)
+    {
+	prev = rast->last;
+
+	if (cells[prev].x == x)
+	    return &cells[prev];
+    }
+    else
+    {
+	prev = -1;
+    }
+
+    idx = (prev < 0)? rast->rows[y] : cells[prev].next;
+
+    while (idx >= 0 && cells[idx].x < x)
+    {
+	prev = idx;
+	idx = cells[idx].next;
+    }
+
+    if (idx < 0 || cells[idx].x != x)
+    {
+	if (rast->n_cells == rast->size)
+	{
+	    int size = rast->size ? 2 * rast->size : 256;
+
+	    if (size > INT32_MAX / (int)sizeof (polygon_cell_t) ||
+		!(cells = realloc (cells, size * sizeof (polygon_cell_t))))
+	    {
+		rast->oom = TRUE;
+		return NULL;
+	    }
+
+	    rast->cells = cells;
+	    rast->size = size;
+	}
+
+	cells[rast->n_cells].x = x;
+	cells[rast->n_cells].cover = 0;
+	cells[rast->n_cells].area = 0;
+	cells[rast->n_cells].next = idx;
+
+	idx = rast->n_cells++;
+
+	if (prev < 0)
+	    rast->rows[y] = idx;
+	else
+	    cells[prev].next = idx;
+    }
+
+    rast->last = idx;
+    rast->last_y = y;
+
+    return &cells[idx];
+}
+
+static force_inline void
+polygon_add_cell (polygon_rasterizer_t *rast,
+		  int                   ex,
+		  int                   ey,
+		  int                   cover,
+		  int                   area)
+{
+    polygon_cell_t *cell;
+
+    /* Cells right of the raster never affect a pixel in it */
+    if (cover == 0 || ex >= rast->width)
+	return;
+
+    if ((cell = polygon_find_cell (rast, ex, ey)))
+    {
+	cell->cover += cover;
+	cell->area += area;
+    }
+}
+
+/* Add the piece of an edge from (x1, y1) to (x2, y2) that lies within
+ * row ey. The y coordinates are relative to the top of the row, and the
+ * x coordinates are within [0, width].
+ */
+static void
+polygon_render_row (polygon_rasterizer_t *rast,
+		    int                   ey,
+		    int                   x1,
+		    int                   y1,
+		    int                   x2,
+		    int                   y2)
+{
+    int ex1 = x1 >> POLYGON_BITS;
+    int ex2 = x2 >> POLYGON_BITS;
+    int fx1 = x1 & (POLYGON_ONE - 1);
+    int fx2 = x2 & (POLYGON_ONE - 1);
+    int64_t dx, dy;
+    int x0, y0, first, incr, y;
+
+    if (ex1 == ex2)
+    {
+	polygon_add_cell (rast, ex1, ey, y2 - y1, (fx1 + fx2) * (y2 - y1));
+	return;
+    }
+
+    x0 = x1;
+    y0 = y1;
+    dx = x2 - x1;
+    dy = y2 - y1;
+
+    if (dx > 0)
+    {
+	first = POLYGON_ONE;
+	incr = 1;
+    }
+    else
+    {
+	first = 0;
+	incr = -1;
+    }
+
+    /* Cut the piece at every pixel boundary it crosses. The crossings
+     * are computed from the end points so that no error accumulates.
+     */
+    while (ex1 != ex2)
+    {
+	int bx = (ex1 << POLYGON_BITS) + first;
+
+	y = y0 + (int)((bx - x0) * dy / dx);
+
+	polygon_add_cell (rast, ex1, ey, y - y1, (fx1 + first) * (y - y1));
+
+	y1 = y;
+	fx1 = POLYGON_ONE - first;
+	ex1 += incr;
+    }
+
+    polygon_add_cell (rast, ex2, ey, y2 - y1, (fx1 + fx2) * (y2 - y1));
+}
+
+/* Add an edge, in 1/256 pixels relative to the raster */
+static void
+polygon_render_line (polygon_rasterizer_t *rast,
+		     int64_t               x1,
+		     int64_t               y1,
+		     int64_t               x2,
+		     int64_t               y2)
+{
+    int64_t xmax = (int64_t)rast->width << POLYGON_BITS;
+    int64_t ymax = (int64_t)rast->height << POLYGON_BITS;
+    int64_t top, bottom;
+    int ey1, ey2, ey;
+
+    if (y1 == y2)
+	return;
+
+    /* Split the edge where it crosses the left or the right side of the
+     * raster. Then each part is either entirely within the raster, left
+     * of it, where it only contributes cover, or right of it, where it
+     * contributes nothing.
+     */
+#define SPLIT_AT(bx)							\
+    if ((x1 < (bx) && x2 > (bx)) || (x1 > (bx) && x2 < (bx)))		\
+    {									\
+	int64_t by = y1 + ((bx) - x1) * (y2 - y1) / (x2 - x1);		\
+									\
+	polygon_render_line (rast, x1, y1, (bx), by);			\
+	polygon_render_line (rast, (bx), by, x2, y2);			\
+	return;								\
+    }
+
+    SPLIT_AT (0);
+    SPLIT_AT (xmax);
+
+#undef SPLIT_AT
+
+    if (x1 >= xmax && x2 >= xmax)
+	return;
+
+    /* Rows are independent, so whatever is above or below the raster
+     * is simply dropped.
+     */
+    top = MAX (MIN (y1, y2), 0);
+    bottom = MIN (MAX (y1, y2), ymax);
+
+    if (top >= bottom)
+	return;
+
+    ey1 = top >> POLYGON_BITS;
+    ey2 = (bottom - 1) >> POLYGON_BITS;
+
+    for (ey = ey1; ey <= ey2; ++ey)
+    {
+	int64_t ya = MAX ((int64_t)ey << POLYGON_BITS, top);
+	int64_t yb = MIN ((int64_t)(ey + 1) << POLYGON_BITS, bottom);
+	int64_t xa, xb;
+	int ry = ey << POLYGON_BITS;
+
+	if (x1 <= 0 && x2 <= 0)
+	{
+	    int cover = (int)(yb - ya);
+
+	    polygon_add_cell (rast, -1, ey, y1 < y2 ? cover : -cover, 0);
+	    continue;
+	}
+
+	xa = x1 + (ya - y1) * (x2 - x1) / (y2 - y1);
+	xb = x1 + (yb - y1) * (x2 - x1) / (y2 - y1);
+
+	if (y1 < y2)
+	    polygon_render_row (rast, ey, xa, ya - ry, xb, yb - ry);
+	else
+	    polygon_render_row (rast, ey, xb, yb - ry, xa, ya - ry);
+    }
+}
+
+static force_inline uint32_t
+polygon_coverage (int area, pixman_fill_rule_t fill_rule)
+{
+    /* The winding number is in units of 2 * POLYGON_ONE * POLYGON_ONE */
+    int c = abs (area) >> (POLYGON_BITS + 1);
+
+    if (fill_rule == PIXMAN_FILL_RULE_EVEN_ODD)
+    {
+	c &= 2 * POLYGON_ONE - 1;
+	if (c > POLYGON_ONE)
+	    c = 2 * POLYGON_ONE - c;
+    }
+
+    return MIN (c, 255);
+}
+
+/* Sweep row y of the raster from left to right and write the coverage
+ * of every pixel to @buffer.
+ */
+static void
+polygon_sweep_row (polygon_rasterizer_t *rast,
+		   int                   y,
+		   pixman_fill_rule_t    fill_rule,
+		   uint8_t *             buffer)
+{
+    int idx = rast->rows[y];
+    int cover = 0;
+    int x = 0;
+
+    while (idx >= 0)
+    {
+	const polygon_cell_t *cell = &rast->cells[idx];
+
+	if (cell->x > x)
+	{
+	    memset (buffer + x,
+		    polygon_coverage (cover * 2 * POLYGON_ONE, fill_rule),
+		    cell->x - x);
+	}
+
+	if (cell->x >= 0)
+	{
+	    buffer[cell->x] = polygon_coverage (
+		(cover + cell->cover) * 2 * POLYGON_ONE - cell->area,
+		fill_rule);
+	}
+
+	cover += cell->cover;
+	x = cell->x + 1;
+	idx = cell->next;
+    }
+
+    if (x < rast->width)
+    {
+	memset (buffer + x,
+		polygon_coverage (cover * 2 * POLYGON_ONE, fill_rule),
+		rast->width - x);
+    }
+}
+
+static pixman_bool_t
+get_polygon_extents (pixman_op_t                 op,
+		     pixman_image_t *            dest,
+		     int                         x_dst,
+		     int                         y_dst,
+		     int                         n_points,
+		     const pixman_point_fixed_t *points,
+		     pixman_box32_t *            box)
+{
+    int i;
+
+    /* The destination, in the coordinates of the polygon */
+    box->x1 = - x_dst;
+    box->y1 = - y_dst;
+    box->x2 = dest->bits.width - x_dst;
+    box->y2 = dest->bits.height - y_dst;
+
+    /* When the operator is such that a zero source has an
+     * effect on the underlying image, we have to
+     * composite across the entire destination
+     */
+    if (_pixman_zero_src_has_no_effect[op])
+    {
+	pixman_fixed_t x1, y1, x2, y2;
+
+	x1 = x2 = points[0].x;
+	y1 = y2 = points[0].y;
+
+	for (i = 1; i < n_points; ++i)
+	{
+	    x1 = MIN (x1, points[i].x);
+	    y1 = MIN (y1, points[i].y);
+	    x2 = MAX (x2, points[i].x);
+	    y2 = MAX (y2, points[i].y);
+	}
+
+	box->x1 = MAX (box->x1, pixman_fixed_to_int (x1));
+	box->y1 = MAX (box->y1, pixman_fixed_to_int (y1));
+	box->x2 = MIN (box->x2, pixman_fixed_to_int (pixman_fixed_ceil (x2)));
+	box->y2 = MIN (box->y2, pixman_fixed_to_int (pixman_fixed_ceil (y2)));
+    }
+
+    return box->x1 < box->x2 && box->y1 < box->y2;
+}
+
+/* Sweep the raster into a mask of @mask_format and composite it over
+ * @box of the destination, in the coordinates of the polygon.
+ */
+static void
+polygon_composite (polygon_rasterizer_t *	rast,
+		   pixman_fill_rule_t		fill_rule,
+		   pixman_op_t			op,
+		   pixman_image_t *		src,
+		   pixman_image_t *		dst,
+		   pixman_format_code_t		mask_format,
+		   int				x_src,
+		   int				y_src,
+		   int				x_dst,
+		   int				y_dst,
+		   const pixman_box32_t *	box)
+{
+    pixman_image_t *tmp;
+    uint8_t *row;
+    uint32_t *pixels;
+    int width = rast->width;
+    int height = rast->height;
+    int i, y;
+
+    if (rast->oom)
+	return;
+
+    if (!(tmp = pixman_image_create_bits (mask_format, width, height, NULL, -1)))
+	return;
+
+    if (mask_format == PIXMAN_a8)
+    {
+	uint8_t *bits = (uint8_t *)tmp->bits.bits;
+	int stride = tmp->bits.rowstride * 4;
+
+	for (y = 0; y < height; ++y)
+	    polygon_sweep_row (rast, y, fill_rule, bits + y * stride);
+    }
+    else
+    {
+	row = malloc (width);
+	pixels = pixman_malloc_ab (width, sizeof (uint32_t));
+
+	if (!row || !pixels)
+	{
+	    free (row);
+	    free (pixels);
+	    pixman_image_unref (tmp);
+	    return;
+	}
+
+	/* Other formats go through the regular a8r8g8b8 store */
+	_pixman_image_validate (tmp);
+
+	for (y = 0; y < height; ++y)
+	{
+	    polygon_sweep_row (rast, y, fill_rule, row);
+
+	    for (i = 0; i < width; ++i)
+		pixels[i] = (uint32_t)row[i] << 24;
+
+	    tmp->bits.store_scanline_32 (&tmp->bits, 0, y, width, pixels);
+	}
+
+	free (row);
+	free (pixels);
+    }
+
+    pixman_image_composite (op, src, tmp, dst,
+			    x_src + box->x1, y_src + box->y1,
+			    0, 0,
+			    x_dst + box->x1, y_dst + box->y1,
+			    width, height);
+
+    pixman_image_unref (tmp);
+}
+
+/*
+ * pixman_composite_polygon()
+ *
+ * The polygon is rendered to an infinitely big image, with each pixel
+ * covered by the exact fraction of its area that is inside according to
+ * @fill_rule. The points are joined in order, and the last point is
+ * joined to the first. Then the image is composited like the mask of
+ * pixman_composite_trapezoids().
+ */
+PIXMAN_EXPORT void
+pixman_composite_polygon (pixman_op_t			op,
+			  pixman_image_t *		src,
+			  pixman_image_t *		dst,
+			  pixman_format_code_t		mask_format,
+			  int				x_src,
+			  int				y_src,
+			  int				x_dst,
+			  int				y_dst,
+			  int				n_points,
+			  const pixman_point_fixed_t *	points,
+			  pixman_fill_rule_t		fill_rule)
+{
+    polygon_rasterizer_t rast;
+    pixman_box32_t box;
+    int64_t ox, oy;
+    int i;
+
+    return_if_fail (PIXMAN_FORMAT_TYPE (mask_format) == PIXMAN_TYPE_A);
+    return_if_fail (dst->type == BITS);
+
+    if (n_points < 3)
+	return;
+
+    if (!get_polygon_extents (op, dst, x_dst, y_dst, n_points, points, &box))
+	return;
+
+    if (!polygon_rasterizer_init (&rast, box.x2 - box.x1, box.y2 - box.y1))
+	return;
+
+    /* Edges are rendered in 1/256 pixels relative to the mask */
+    ox = (int64_t)box.x1 * pixman_fixed_1;
+    oy = (int64_t)box.y1 * pixman_fixed_1;
+
+    for (i = 0; i < n_points; ++i)
+    {
+	const pixman_point_fixed_t *p1 = &points[i];
+	const pixman_point_fixed_t *p2 = &points[(i + 1) % n_points];
+
+	polygon_render_line (&rast,
+			     (p1->x - ox) >> 8, (p1->y - oy) >> 8,
+			     (p2->x - ox) >> 8, (p2->y - oy) >> 8);
+    }
+
+    polygon_composite (&rast, fill_rule, op, src, dst, mask_format,
+		       x_src, y_src, x_dst, y_dst, &box);
+
+    polygon_rasterizer_fini (&rast);
+}
+
+/* Triangle strips and fans
+ *
+ * Every triangle is rendered with its edges turning counterclockwise,
+ * so that the covers of all triangles have the same sign and add up
+ * like pixman_add_triangles() would add them. An edge shared by two
+ * adjacent triangles is then walked in opposite directions by the two
+ * of them, as long as they lie on opposite sides of it, and the two
+ * walks cancel exactly. Such edges are skipped altogether, which leaves
+ * only the outline of the mesh to rasterize.
+ */
+
+typedef struct
+{
+    int64_t	x;
+    int64_t	y;
+} polygon_point_t;
+
+#define TRIANGLE_SKIP_AB	(1 << 0)
+#define TRIANGLE_SKIP_BC	(1 << 1)
+#define TRIANGLE_SKIP_CA	(1 << 2)
+
+static force_inline void
+polygon_point (polygon_point_t *           p,
+	       const pixman_point_fixed_t *point,
+	       int64_t                     ox,
+	       int64_t                     oy)
+{
+    p->x = (point->x - ox) >> 8;
+    p->y = (point->y - oy) >> 8;
+}
+
+/* The sign of the signed area of abc. The coordinates are in 1/256
+ * pixels, so the products fit comfortably in 64 bits.
+ */
+static force_inline int
+polygon_orientation (const polygon_point_t *a,
+		     const polygon_point_t *b,
+		     const polygon_point_t *c)
+{
+    int64_t d = (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
+
+    return (d > 0) - (d < 0);
+}
+
+static void
+polygon_render_triangle (polygon_rasterizer_t *  rast,
+			 const polygon_point_t * a,
+			 const polygon_point_t * b,
+			 const polygon_point_t * c,
+			 int                     orientation,
+			 int                     skip)
+{
+    if (orientation < 0)
+    {
+	const polygon_point_t *t = b;
+
+	b = c;
+	c = t;
+	skip = (skip & TRIANGLE_SKIP_BC) |
+	    ((skip & TRIANGLE_SKIP_AB) << 2) | ((skip & TRIANGLE_SKIP_CA) >> 2);
+    }
+
+    if (!(skip & TRIANGLE_SKIP_AB))
+	polygon_render_line (rast, a->x, a->y, b->x, b->y);
+    if (!(skip & TRIANGLE_SKIP_BC))
+	polygon_render_line (rast, b->x, b->y, c->x, c->y);
+    if (!(skip & TRIANGLE_SKIP_CA))
+	polygon_render_line (rast, c->x, c->y, a->x, a->y);
+}
+
+/*
+ * pixman_composite_tri_strip()
+ *
+ * Triangle i of the strip has the points i, i + 1 and i + 2. The
+ * triangles are added into a mask with exact area coverage, which is
+ * composited like the mask of pixman_composite_triangles().
+ */
+PIXMAN_EXPORT void
+pixman_composite_tri_strip (pixman_op_t			op,
+			    pixman_image_t *		src,
+			    pixman_image_t *		dst,
+			    pixman_format_code_t	mask_format,
+			    int				x_src,
+			    int				y_src,
+			    int				x_dst,
+			    int				y_dst,
+			    int				n_points,
+			    const pixman_point_fixed_t *points)
+{
+    polygon_rasterizer_t rast;
+    polygon_point_t p[3];
+    pixman_box32_t box;
+    int64_t ox, oy;
+    int prev, cur, next, i;
+
+    return_if_fail (PIXMAN_FORMAT_TYPE (mask_format) == PIXMAN_TYPE_A);
+    return_if_fail (dst->type == BITS);
+
+    if (n_points < 3)
+	return;
+
+    if (!get_polygon_extents (op, dst, x_dst, y_dst, n_points, points, &box))
+	return;
+
+    if (!polygon_rasterizer_init (&rast, box.x2 - box.x1, box.y2 - box.y1))
+	return;
+
+    ox = (int64_t)box.x1 * pixman_fixed_1;
+    oy = (int64_t)box.y1 * pixman_fixed_1;
+
+    polygon_point (&p[0], &points[0], ox, oy);
+    polygon_point (&p[1], &points[1], ox, oy);
+    polygon_point (&p[2], &points[2], ox, oy);
+
+    prev = 0;
+    cur = polygon_orientation (&p[0], &p[1], &p[2]);
+
+    for (i = 0; i < n_points - 2; ++i)
+    {
+	const polygon_point_t *a = &p[i % 3];
+	const polygon_point_t *b = &p[(i + 1) % 3];
+	const polygon_point_t *c = &p[(i + 2) % 3];
+	polygon_point_t d;
+	int skip = 0;
+
+	next = 0;
+
+	if (i + 3 < n_points)
+	{
+	    polygon_point (&d, &points[i + 3], ox, oy);
+	    next = polygon_orientation (b, c, &d);
+	}
+
+	/* The next triangle shares bc and the previous one shares ab.
+	 * Adjacent triangles of a strip are on opposite sides of the
+	 * edge they share when their points turn the other way.
+	 */
+	if (cur)
+	{
+	    if (cur * prev < 0)
+		skip |= TRIANGLE_SKIP_AB;
+	    if (cur * next < 0)
+		skip |= TRIANGLE_SKIP_BC;
+
+	    polygon_render_triangle (&rast, a, b, c, cur, skip);
+	}
+
+	/* d takes the place of a, which is not needed any more */
+	if (i + 3 < n_points)
+	    p[i % 3] = d;
+
+	prev = cur;
+	cur = next;
+    }
+
+    polygon_composite (&rast, PIXMAN_FILL_RULE_NONZERO, op, src, dst,
+		       mask_format, x_src, y_src, x_dst, y_dst, &box);
+
+    polygon_rasterizer_fini (&rast);
+}
+
+/*
+ * pixman_composite_tri_fan()
+ *
+ * Triangle i of the fan has the points 0, i + 1 and i + 2, and is
+ * otherwise composited like the triangles of a strip.
+ */
+PIXMAN_EXPORT void
+pixman_composite_tri_fan (pixman_op_t			op,
+			  pixman_image_t *		src,
+			  pixman_image_t *		dst,
+			  pixman_format_code_t		mask_format,
+			  int				x_src,
+			  int				y_src,
+			  int				x_dst,
+			  int				y_dst,
+			  int				n_points,
+			  const pixman_point_fixed_t *	points)
+{
+    polygon_rasterizer_t rast;
+    polygon_point_t center, b, c, d;
+    pixman_box32_t box;
+    int64_t ox, oy;
+    int prev, cur, next, i;
+
+    return_if_fail (PIXMAN_FORMAT_TYPE (mask_format) == PIXMAN_TYPE_A);
+    return_if_fail (dst->type == BITS);
+
+    if (n_points < 3)
+	return;
+
+    if (!get_polygon_extents (op, dst, x_dst, y_dst, n_points, points, &box))
+	return;
+
+    if (!polygon_rasterizer_init (&rast, box.x2 - box.x1, box.y2 - box.y1))
+	return;
+
+    ox = (int64_t)box.x1 * pixman_fixed_1;
+    oy = (int64_t)box.y1 * pixman_fixed_1;
+
+    polygon_point (&center, &points[0], ox, oy);
+    polygon_point (&b, &points[1], ox, oy);
+    polygon_point (&c, &points[2], ox, oy);
+
+    prev = 0;
+    cur = polygon_orientation (&center, &b, &c);
+
+    for (i = 0; i < n_points - 2; ++i)
+    {
+	int skip = 0;
+
+	next = 0;
+
+	if (i + 3 < n_points)
+	{
+	    polygon_point (&d, &points[i + 3], ox, oy);
+	    next = polygon_orientation (&center, &c, &d);
+	}
+
+	/* Adjacent triangles of a fan are on opposite sides of the
+	 * edge they share when their points turn the same way.
+	 */
+	if (cur)
+	{
+	    if (cur * prev > 0)
+		skip |= TRIANGLE_SKIP_AB;
+	    if (cur * next > 0)
+		skip |= TRIANGLE_SKIP_CA;
+
+	    polygon_render_triangle (&rast, &center, &b, &c, cur, skip);
+	}
+
+	if (i + 3 < n_points)
+	{
+	    b = c;
+	    c = d;
+	}
+
+	prev = cur;
+	cur = next;
+    }
+
+    polygon_composite (&rast, PIXMAN_FILL_RULE_NONZERO, op, src, dst,
+		       mask_format, x_src, y_src, x_dst, y_dst, &box);
+
+    polygon_rasterizer_fini (&rast);
+}
@@ -133,6 +133,11 @@ struct gradient
     image_common_t	    common;
     int                     n_stops;
     pixman_gradient_stop_t *stops;
+
+    /* Colour ramp for the narrow iterators, see pixman-gradient-walker.c */
+    uint32_t *		    lut;
+    pixman_repeat_t	    lut_repeat;
+    int			    lut_pixels;
 };
 
 struct linear_gradient
@@ -292,12 +297,38 @@ _pixman_bits_image_dest_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 void
 _pixman_linear_gradient_iter_init (pixman_image_t *image, pixman_iter_t  *iter);
 
+pixman_bool_t
+_pixman_linear_gradient_get_affine_params (pixman_image_t       *image,
+					   int                   x,
+					   int                   y,
+					   pixman_fixed_32_32_t *t,
+					   double               *inc);
+
 void
 _pixman_radial_gradient_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 
+pixman_bool_t
+_pixman_radial_gradient_get_affine_params (pixman_image_t       *image,
+					   int                   x,
+					   int                   y,
+					   pixman_fixed_32_32_t *b,
+					   pixman_fixed_32_32_t *db,
+					   pixman_fixed_32_32_t *c,
+					   pixman_fixed_32_32_t *dc,
+					   pixman_fixed_32_32_t *ddc);
+
 void
 _pixman_conical_gradient_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 
+pixman_bool_t
+_pixman_conical_gradient_get_affine_params (pixman_image_t *image,
+					    int             x,
+					    int             y,
+					    double         *rx,
+					    double         *ry,
+					    double         *cx,
+					    double         *cy);
+
 void
 _pixman_image_init (pixman_image_t *image);
 
@@ -319,6 +350,14 @@ pixman_bool_t
 _pixman_init_gradient (gradient_t *                  gradient,
                        const pixman_gradient_stop_t *stops,
                        int                           n_stops);
+
+pixman_bool_t
+_pixman_gradient_transform (pixman_image_t  *image,
+			    int              x,
+			    int              y,
+			    pixman_vector_t *v,
+			    pixman_vector_t *unit);
+
 void
 _pixman_image_reset_clip_region (pixman_image_t *image);
 
@@ -354,10 +393,17 @@ typedef struct
     pixman_gradient_stop_t *stops;
     int                     num_stops;
     pixman_repeat_t	    repeat;
+    const uint32_t *	    lut;
 
     pixman_bool_t           need_reset;
 } pixman_gradient_walker_t;
 
+#define GRADIENT_LUT_BITS	12
+#define GRADIENT_LUT_SIZE	(1 << GRADIENT_LUT_BITS)
+
+void
+_pixman_gradient_prepare_lut (gradient_t *gradient, int width, int height);
+
 void
 _pixman_gradient_walker_init (pixman_gradient_walker_t *walker,
                               gradient_t *              gradient,
@@ -424,6 +470,34 @@ _pixman_gradient_walker_fill_wide(pixman_gradient_walker_t *walker,
     ((n) == 1? 0 : (pixman_fixed_frac (x) +				\
 		    X_FRAC_FIRST (n)) / STEP_X_SMALL (n))
 
+/*
+ * Step across a small sample grid gap
+ */
+#define RENDER_EDGE_STEP_SMALL(edge)					\
+    {									\
+	edge->x += edge->stepx_small;					\
+	edge->e += edge->dx_small;					\
+	if (edge->e > 0)						\
+	{								\
+	    edge->e -= edge->dy;					\
+	    edge->x += edge->signdx;					\
+	}								\
+    }
+
+/*
+ * Step across a large sample grid gap
+ */
+#define RENDER_EDGE_STEP_BIG(edge)					\
+    {									\
+	edge->x += edge->stepx_big;					\
+	edge->e += edge->dx_big;					\
+	if (edge->e > 0)						\
+	{								\
+	    edge->e -= edge->dy;					\
+	    edge->x += edge->signdx;					\
+	}								\
+    }
+
 void
 pixman_rasterize_edges_accessors (pixman_image_t *image,
                                   pixman_edge_t * l,
@@ -486,6 +560,15 @@ typedef void (*pixman_combine_float_func_t) (pixman_implementation_t *imp,
 
 typedef void (*pixman_composite_func_t) (pixman_implementation_t *imp,
 					 pixman_composite_info_t *info);
+
+/* Composite several boxes of the same band, which all have the same y1
+ * and y2, in one call. @info describes the first box; the source and
+ * mask of the other boxes are at the same offsets from the destination.
+ */
+typedef void (*pixman_composite_spans_func_t) (pixman_implementation_t *imp,
+					       pixman_composite_info_t *info,
+					       const pixman_box32_t *   boxes,
+					       int                      n_boxes);
 typedef pixman_bool_t (*pixman_blt_func_t) (pixman_implementation_t *imp,
 					    uint32_t *               src_bits,
 					    uint32_t *               dst_bits,
@@ -509,6 +592,14 @@ typedef pixman_bool_t (*pixman_fill_func_t) (pixman_implementation_t *imp,
 					     int                      height,
 					     uint32_t                 filler);
 
+/* Add @value to the @width a8 pixels at @dst, saturating at 0xff. Used
+ * by the edge rasterizer for the fully covered middle of spans.
+ */
+typedef pixman_bool_t (*pixman_add_saturate_8_func_t) (pixman_implementation_t *imp,
+						       uint8_t *                dst,
+						       int                      value,
+						       int                      width);
+
 void _pixman_setup_combiner_functions_32 (pixman_implementation_t *imp);
 void _pixman_setup_combiner_functions_float (pixman_implementation_t *imp);
 
@@ -522,6 +613,7 @@ typedef struct
     pixman_format_code_t    dest_format;
     uint32_t		    dest_flags;
     pixman_composite_func_t func;
+    pixman_composite_spans_func_t spans;	/* Optional */
 } pixman_fast_path_t;
 
 struct pixman_implementation_t
@@ -533,6 +625,7 @@ struct pixman_implementation_t
 
     pixman_blt_func_t		blt;
     pixman_fill_func_t		fill;
+    pixman_add_saturate_8_func_t add_saturate_8;
 
     pixman_combine_32_func_t	combine_32[PIXMAN_N_OPERATORS];
     pixman_combine_32_func_t	combine_32_ca[PIXMAN_N_OPERATORS];
@@ -561,6 +654,19 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 					 pixman_implementation_t **out_imp,
 					 pixman_composite_func_t  *out_func);
 
+void
+_pixman_implementation_lookup_composite_spans (pixman_implementation_t       *toplevel,
+					       pixman_op_t                    op,
+					       pixman_format_code_t           src_format,
+					       uint32_t                       src_flags,
+					       pixman_format_code_t           mask_format,
+					       uint32_t                       mask_flags,
+					       pixman_format_code_t           dest_format,
+					       uint32_t                       dest_flags,
+					       pixman_implementation_t      **out_imp,
+					       pixman_composite_func_t       *out_func,
+					       pixman_composite_spans_func_t *out_spans);
+
 pixman_combine_32_func_t
 _pixman_implementation_lookup_combiner (pixman_implementation_t *imp,
 					pixman_op_t		 op,
@@ -593,6 +699,12 @@ _pixman_implementation_fill (pixman_implementation_t *imp,
                              int                      height,
                              uint32_t                 filler);
 
+pixman_bool_t
+_pixman_implementation_add_saturate_8 (pixman_implementation_t *imp,
+                                       uint8_t *                dst,
+                                       int                      value,
+                                       int                      width);
+
 void
 _pixman_implementation_iter_init (pixman_implementation_t       *imp,
                                   pixman_iter_t                 *iter,
@@ -694,6 +806,12 @@ _pixman_iter_get_scanline_noop (pixman_iter_t *iter, const uint32_t *mask);
 void
 _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *info);
 
+double
+_pixman_filter_kernel (pixman_kernel_t kernel, double x);
+
+double
+_pixman_filter_kernel_width (pixman_kernel_t kernel);
+
 /* These "formats" all have depth 0, so they
  * will never clash with any real ones
  */
@@ -703,6 +821,9 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 #define PIXMAN_rpixbuf		PIXMAN_FORMAT (0, 3, 0, 0, 0, 0)
 #define PIXMAN_unknown		PIXMAN_FORMAT (0, 4, 0, 0, 0, 0)
 #define PIXMAN_any		PIXMAN_FORMAT (0, 5, 0, 0, 0, 0)
+#define PIXMAN_linear_gradient	PIXMAN_FORMAT (0, 6, 0, 0, 0, 0)
+#define PIXMAN_radial_gradient	PIXMAN_FORMAT (0, 7, 0, 0, 0, 0)
+#define PIXMAN_conical_gradient	PIXMAN_FORMAT (0, 8, 0, 0, 0, 0)
 
 #define PIXMAN_OP_any		(PIXMAN_N_OPERATORS + 1)
 
@@ -733,6 +854,7 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 #define FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR	(1 << 24)
 #define FAST_PATH_BITS_IMAGE			(1 << 25)
 #define FAST_PATH_SEPARABLE_CONVOLUTION_FILTER  (1 << 26)
+#define FAST_PATH_BICUBIC_FILTER		(1 << 27)
 
 #define FAST_PATH_PAD_REPEAT						\
     (FAST_PATH_NO_NONE_REPEAT		|				\
@@ -791,6 +913,14 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 	    dest, FAST_PATH_STD_DEST_FLAGS,				\
 	    func) }
 
+#define PIXMAN_STD_FAST_PATH_SPANS(op, src, mask, dest, func, spans)	\
+    { FAST_PATH (							\
+	    op,								\
+	    src,  SOURCE_FLAGS (src),					\
+	    mask, MASK_FLAGS (mask, FAST_PATH_UNIFIED_ALPHA),		\
+	    dest, FAST_PATH_STD_DEST_FLAGS,				\
+	    func), spans }
+
 #define PIXMAN_STD_FAST_PATH_CA(op, src, mask, dest, func)		\
     { FAST_PATH (							\
 	    op,								\
@@ -848,6 +978,8 @@ pixman_contract_from_float (uint32_t     *dst,
 			    const argb_t *src,
 			    int           width);
 
+extern const pixman_bool_t _pixman_zero_src_has_no_effect[PIXMAN_N_OPERATORS];
+
 /* Region Helpers */
 pixman_bool_t
 pixman_region32_copy_from_region16 (pixman_region32_t *dst,
@@ -181,6 +181,68 @@ radial_write_color (double                         a,
     return;
 }
 
+/* B and C of the quadratic at @v and their forward differences along
+ * @unit, for affine transformations; see radial_get_scanline().
+ */
+static void
+radial_gradient_differences (radial_gradient_t     *radial,
+			     pixman_vector_t       *v,
+			     const pixman_vector_t *unit,
+			     pixman_fixed_32_32_t  *b,
+			     pixman_fixed_32_32_t  *db,
+			     pixman_fixed_32_32_t  *c,
+			     pixman_fixed_32_32_t  *dc,
+			     pixman_fixed_32_32_t  *ddc)
+{
+    /* warning: this computation may overflow */
+    v->vector[0] -= radial->c1.x;
+    v->vector[1] -= radial->c1.y;
+
+    /*
+     * B and C are computed and updated exactly.
+     * If fdot was used instead of dot, in the worst case it would
+     * lose 11 bits of precision in each of the multiplication and
+     * summing up would zero out all the bit that were preserved,
+     * thus making the result 0 instead of the correct one.
+     * This would mean a worst case of unbound relative error or
+     * about 2^10 absolute error
+     */
+    *b = dot (v->vector[0], v->vector[1], radial->c1.radius,
+	      radial->delta.x, radial->delta.y, radial->delta.radius);
+    *db = dot (unit->vector[0], unit->vector[1], 0,
+	       radial->delta.x, radial->delta.y, 0);
+
+    *c = dot (v->vector[0], v->vector[1],
+	      -((pixman_fixed_48_16_t) radial->c1.radius),
+	      v->vector[0], v->vector[1], radial->c1.radius);
+    *dc = dot (2 * (pixman_fixed_48_16_t) v->vector[0] + unit->vector[0],
+	       2 * (pixman_fixed_48_16_t) v->vector[1] + unit->vector[1],
+	       0,
+	       unit->vector[0], unit->vector[1], 0);
+    *ddc = 2 * dot (unit->vector[0], unit->vector[1], 0,
+		    unit->vector[0], unit->vector[1], 0);
+}
+
+pixman_bool_t
+_pixman_radial_gradient_get_affine_params (pixman_image_t       *image,
+					   int                   x,
+					   int                   y,
+					   pixman_fixed_32_32_t *b,
+					   pixman_fixed_32_32_t *db,
+					   pixman_fixed_32_32_t *c,
+					   pixman_fixed_32_32_t *dc,
+					   pixman_fixed_32_32_t *ddc)
+{
+    pixman_vector_t v, unit;
+
+    if (!_pixman_gradient_transform (image, x, y, &v, &unit))
+	return FALSE;
+
+    radial_gradient_differences (&image->radial, &v, &unit, b, db, c, dc, ddc);
+
+    return TRUE;
+}
+
 static uint32_t *
 radial_get_scanline (pixman_iter_t                 *iter,
 		     const uint32_t                *mask,
@@ -280,28 +342,10 @@ radial_get_scanline (pixman_iter_t                 *iter,
     pixman_gradient_walker_t walker;
     pixman_vector_t v, unit;
 
-    /* reference point is the center of the pixel */
-    v.vector[0] = pixman_int_to_fixed (x) + pixman_fixed_1 / 2;
-    v.vector[1] = pixman_int_to_fixed (y) + pixman_fixed_1 / 2;
-    v.vector[2] = pixman_fixed_1;
-
     _pixman_gradient_walker_init (&walker, gradient, image->common.repeat);
 
-    if (image->common.transform)
-    {
-	if (!pixman_transform_point_3d (image->common.transform, &v))
-	    return iter->buffer;
-
-	unit.vector[0] = image->common.transform->matrix[0][0];
-	unit.vector[1] = image->common.transform->matrix[1][0];
-	unit.vector[2] = image->common.transform->matrix[2][0];
-    }
-    else
-    {
-	unit.vector[0] = pixman_fixed_1;
-	unit.vector[1] = 0;
-	unit.vector[2] = 0;
-    }
+    if (!_pixman_gradient_transform (image, x, y, &v, &unit))
+	return iter->buffer;
 
     if (unit.vector[2] == 0 && v.vector[2] == pixman_fixed_1)
     {
@@ -327,33 +371,7 @@ radial_get_scanline (pixman_iter_t                 *iter,
 	 */
 	pixman_fixed_32_32_t b, db, c, dc, ddc;
 
-	/* warning: this computation may overflow */
-	v.vector[0] -= radial->c1.x;
-	v.vector[1] -= radial->c1.y;
-
-	/*
-	 * B and C are computed and updated exactly.
-	 * If fdot was used instead of dot, in the worst case it would
-	 * lose 11 bits of precision in each of the multiplication and
-	 * summing up would zero out all the bit that were preserved,
-	 * thus making the result 0 instead of the correct one.
-	 * This would mean a worst case of unbound relative error or
-	 * about 2^10 absolute error
-	 */
-	b = dot (v.vector[0], v.vector[1], radial->c1.radius,
-		 radial->delta.x, radial->delta.y, radial->delta.radius);
-	db = dot (unit.vector[0], unit.vector[1], 0,
-		  radial->delta.x, radial->delta.y, 0);
-
-	c = dot (v.vector[0], v.vector[1],
-		 -((pixman_fixed_48_16_t) radial->c1.radius),
-		 v.vector[0], v.vector[1], radial->c1.radius);
-	dc = dot (2 * (pixman_fixed_48_16_t) v.vector[0] + unit.vector[0],
-		  2 * (pixman_fixed_48_16_t) v.vector[1] + unit.vector[1],
-		  0,
-		  unit.vector[0], unit.vector[1], 0);
-	ddc = 2 * dot (unit.vector[0], unit.vector[1], 0,
-		       unit.vector[0], unit.vector[1], 0);
+	radial_gradient_differences (radial, &v, &unit, &b, &db, &c, &dc, &ddc);
 
 	while (buffer < end)
 	{
@@ -453,7 +471,10 @@ void
 _pixman_radial_gradient_iter_init (pixman_image_t *image, pixman_iter_t *iter)
 {
     if (iter->iter_flags & ITER_NARROW)
+    {
+	_pixman_gradient_prepare_lut (&image->gradient, iter->width, iter->height);
 	iter->get_scanline = radial_get_scanline_narrow;
+    }
     else
 	iter->get_scanline = radial_get_scanline_wide;
 }
@@ -0,0 +1,172 @@
+/*
+ * Copyright © 2026 The pixman authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include "pixman-private.h"
+
+/* Damage history for buffer age repaint
+ *
+ * A compositor that reuses a buffer which is k frames old has to repaint
+ * the union of the damage of the last k frames, and with several outputs
+ * or buffers it asks for several ages on every frame. The history keeps
+ * the damage of the frames in a ring, and the union for age k is built
+ * from the one for age k - 1 with a single union, the first time that an
+ * age at least that old is asked for after a frame was added. So the
+ * queries of a frame share their work and never start from scratch.
+ *
+ * Keeping the unions up to date eagerly, by merging the damage of each
+ * new frame into the unions of all the older ones, costs as many unions
+ * of the largest regions on every frame, even when only the last frame
+ * or two are ever asked for.
+ */
+
+struct pixman_region32_history
+{
+    int			n_frames;
+    int			first;		/* Slot of the oldest frame */
+    int			count;		/* Frames in the history */
+    int			n_valid;	/* unions[age] is valid up to this age */
+    pixman_region32_t *	unions;		/* Indexed by age, from 2 */
+    pixman_region32_t	frames[1];	/* n_frames of them, then unions */
+};
+
+#define FRAME(history, age)						\
+    (&(history)->frames[((history)->first + (history)->count - (age)) %	\
+			(history)->n_frames])
+
+PIXMAN_EXPORT pixman_region32_history_t *
+pixman_region32_history_create (int n_frames)
+{
+    pixman_region32_history_t *history;
+    int i;
+
+    return_val_if_fail (n_frames > 0 && n_frames < INT32_MAX / 2, NULL);
+
+    /* The frames, and the unions for ages 2 to n_frames */
+    history = pixman_malloc_ab_plus_c (
+	2 * n_frames + 1, sizeof (pixman_region32_t),
+	sizeof (pixman_region32_history_t) - sizeof (pixman_region32_t));
+
+    if (!history)
+	return NULL;
+
+    history->n_frames = n_frames;
+    history->first = 0;
+    history->count = 0;
+    history->n_valid = 1;
+    history->unions = history->frames + n_frames;
+
+    for (i = 0; i < 2 * n_frames + 1; i++)
+	pixman_region32_init (&history->frames[i]);
+
+    return history;
+}
+
+PIXMAN_EXPORT void
+pixman_region32_history_destroy (pixman_region32_history_t *history)
+{
+    int i;
+
+    for (i = 0; i < 2 * history->n_frames + 1; i++)
+	pixman_region32_fini (&history->frames[i]);
+
+    free (history);
+}
+
+/* Forget all the frames, for example when the buffers are reallocated */
+PIXMAN_EXPORT void
+pixman_region32_history_reset (pixman_region32_history_t *history)
+{
+    int i;
+
+    for (i = 0; i < 2 * history->n_frames + 1; i++)
+	pixman_region32_clear (&history->frames[i]);
+
+    history->first = 0;
+    history->count = 0;
+    history->n_valid = 1;
+}
+
+/* Add the damage of a new frame. When the history is full, the oldest
+ * frame is forgotten. If memory runs out, the history is reset, so
+ * that the following queries ask for a full repaint instead of
+ * returning too little damage.
+ */
+PIXMAN_EXPORT pixman_bool_t
+pixman_region32_history_add (pixman_region32_history_t *history,
+			     pixman_region32_t *        damage)
+{
+    if (history->count == history->n_frames)
+    {
+	history->first = (history->first + 1) % history->n_frames;
+	history->count--;
+    }
+
+    history->count++;
+    history->n_valid = 1;
+
+    if (!pixman_region32_copy (FRAME (history, 1), damage))
+    {
+	pixman_region32_history_reset (history);
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Store in @result the union of the damage of the last @age frames.
+ * Returns FALSE when the history doesn't go back that far, in which case
+ * everything has to be repainted.
+ */
+PIXMAN_EXPORT pixman_bool_t
+pixman_region32_history_get (pixman_region32_history_t *history,
+			     int                        age,
+			     pixman_region32_t *        result)
+{
+    if (age < 1 || age > history->count)
+	return FALSE;
+
+    while (history->n_valid < age)
+    {
+	int k = history->n_valid + 1;
+	pixman_region32_t *newer =
+	    k == 2 ? FRAME (history, 1) : &history->unions[k - 1];
+
+	if (!pixman_region32_union (&history->unions[k], newer,
+				    FRAME (history, k)))
+	{
+	    pixman_region32_clear (&history->unions[k]);
+	    return FALSE;
+	}
+
+	history->n_valid = k;
+    }
+
+    if (age == 1)
+	return pixman_region32_copy (result, FRAME (history, 1));
+
+    return pixman_region32_copy (result, &history->unions[age]);
+}
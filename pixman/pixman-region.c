@@ -118,6 +118,12 @@ static region_data_type_t *pixman_broken_data =
 static pixman_bool_t
 pixman_break (region_type_t *region);
 
+static box_type_t *
+find_box_for_y (box_type_t *begin, box_type_t *end, int y);
+
+static box_type_t *
+find_band_end (box_type_t *band, box_type_t *end);
+
 /*
  * The functions in this file implement the Region abstraction used extensively
  * throughout the X11 sample server. A Region is simply a set of disjoint
@@ -202,15 +208,20 @@ PIXREGION_SZOF (size_t n)
     return size + sizeof(region_data_type_t);
 }
 
+/* Returns a block with room for @n rectangles, with its size field set */
 static region_data_type_t *
 alloc_data (size_t n)
 {
+    region_data_type_t *data;
     size_t sz = PIXREGION_SZOF (n);
 
     if (!sz)
 	return NULL;
 
-    return malloc (sz);
+    if ((data = malloc (sz)))
+	data->size = n;
+
+    return data;
 }
 
 #define FREE_DATA(reg) if ((reg)->data && (reg)->data->size) free ((reg)->data)
@@ -451,8 +462,7 @@ pixman_rect_alloc (region_type_t * region,
 
     if (!region->data)
     {
-	n++;
-	region->data = alloc_data (n);
+	region->data = alloc_data (n + 1);
 
 	if (!region->data)
 	    return pixman_break (region);
@@ -497,9 +507,8 @@ pixman_rect_alloc (region_type_t * region,
 	    return pixman_break (region);
 	
 	region->data = data;
+	region->data->size = n;
     }
-    
-    region->data->size = n;
 
     return TRUE;
 }
@@ -530,8 +539,6 @@ PREFIX (_copy) (region_type_t *dst, region_type_t *src)
 
 	if (!dst->data)
 	    return pixman_break (dst);
-
-	dst->data->size = src->data->numRects;
     }
 
     dst->data->numRects = src->data->numRects;
@@ -1153,6 +1160,86 @@ pixman_region_intersect_o (region_type_t *region,
     return TRUE;
 }
 
+/* Intersect a region of several rectangles with the single rectangle
+ * @box, directly band by band. @dst may be @src, in which case its own
+ * storage is reused: the rectangles only ever shrink or disappear, so
+ * each one is written at or before the position it was read from.
+ */
+static pixman_bool_t
+pixman_region_intersect_box (region_type_t *    dst,
+                             region_type_t *    src,
+                             const box_type_t * box)
+{
+    box_type_t clip = *box;
+    box_type_t *r = PIXREGION_BOXPTR (src);
+    box_type_t *r_end = r + src->data->numRects;
+    box_type_t *rects;
+    int prev_band = 0;
+    int n = 0;
+
+    if (dst != src && PIXREGION_SIZE (dst) < src->data->numRects)
+    {
+	FREE_DATA (dst);
+
+	if (!(dst->data = alloc_data (src->data->numRects)))
+	    return pixman_break (dst);
+    }
+
+    rects = PIXREGION_BOXPTR (dst);
+
+    /* Skip the bands above the rectangle */
+    r = find_box_for_y (r, r_end, clip.y1);
+
+    while (r != r_end && r->y1 < clip.y2)
+    {
+	int band_y1 = r->y1;
+	int y1 = MAX (band_y1, clip.y1);
+	int y2 = MIN (r->y2, clip.y2);
+	int cur_band = n;
+
+	for (; r != r_end && r->y1 == band_y1; ++r)
+	{
+	    int x1 = MAX (r->x1, clip.x1);
+	    int x2 = MIN (r->x2, clip.x2);
+
+	    if (x1 < x2)
+	    {
+		rects[n].x1 = x1;
+		rects[n].y1 = y1;
+		rects[n].x2 = x2;
+		rects[n].y2 = y2;
+		n++;
+	    }
+	}
+
+	dst->data->numRects = n;
+	COALESCE (dst, prev_band, cur_band);
+	n = dst->data->numRects;
+    }
+
+    dst->data->numRects = n;
+
+    if (n == 0)
+    {
+	FREE_DATA (dst);
+	dst->extents.x2 = dst->extents.x1;
+	dst->extents.y2 = dst->extents.y1;
+	dst->data = pixman_region_empty_data;
+    }
+    else if (n == 1)
+    {
+	dst->extents = rects[0];
+	FREE_DATA (dst);
+	dst->data = (region_data_type_t *)NULL;
+    }
+    else
+    {
+	pixman_set_extents (dst);
+    }
+
+    return TRUE;
+}
+
 PIXMAN_EXPORT pixman_bool_t
 PREFIX (_intersect) (region_type_t *     new_reg,
                      region_type_t *        reg1,
@@ -1204,6 +1291,16 @@ PREFIX (_intersect) (region_type_t *     new_reg,
     {
         return PREFIX (_copy) (new_reg, reg1);
     }
+    else if (!reg2->data)
+    {
+        if (!pixman_region_intersect_box (new_reg, reg1, &reg2->extents))
+	    return FALSE;
+    }
+    else if (!reg1->data)
+    {
+        if (!pixman_region_intersect_box (new_reg, reg2, &reg1->extents))
+	    return FALSE;
+    }
     else
     {
         /* General purpose intersection */
@@ -1808,6 +1905,193 @@ bail:
     return pixman_break (badreg);
 }
 
+/*-
+ *-----------------------------------------------------------------------
+ * pixman_region_union_rects --
+ *
+ *      Add an arbitrary collection of rectangles to a region in a single
+ *      pass, instead of one pixman_region_union_rect call per rectangle.
+ *
+ * Results:
+ *	TRUE if successful.
+ *
+ * Side Effects:
+ *      The region is replaced by its union with the rectangles. Empty
+ *      and malformed rectangles are ignored.
+ *
+ * Strategy:
+ *      The rectangles of the region and the new ones are sorted by y1,
+ *      and then swept from top to bottom. A band ends wherever one of
+ *      the rectangles starts or ends. The rectangles that cross the
+ *      current band are kept sorted by x1, so the boxes of the band are
+ *      their merged spans, and a band that has the same boxes as the
+ *      one above it is coalesced with it right away.
+ *
+ *-----------------------------------------------------------------------
+ */
+PIXMAN_EXPORT pixman_bool_t
+PREFIX (_union_rects) (region_type_t *   region,
+                       const box_type_t *boxes,
+                       int               count)
+{
+    region_type_t result;
+    region_type_t *new_reg = &result;
+    box_type_t *rects;              /* Sorted by y1, then x1		    */
+    box_type_t *active;             /* Crossing the band, sorted by x1	    */
+    box_type_t *next_rect;
+    int n_old, n, n_active, next;
+    int prev_band, cur_band, numRects;
+    int i, j, y, y_next, x1, x2;
+
+    GOOD (region);
+
+    if (PIXREGION_NAR (region))
+	return FALSE;
+
+    if (count <= 0)
+	return TRUE;
+
+    n_old = PIXREGION_NIL (region) ? 0 : PIXREGION_NUMRECTS (region);
+
+    if (count > INT_MAX / 2 - n_old)
+	return pixman_break (region);
+
+    rects = pixman_malloc_ab (n_old + count, 2 * sizeof (box_type_t));
+    if (!rects)
+	return pixman_break (region);
+
+    active = rects + n_old + count;
+
+    memcpy (rects, PIXREGION_RECTS (region), n_old * sizeof (box_type_t));
+
+    n = n_old;
+    for (i = 0; i < count; i++)
+    {
+	if (GOOD_RECT (&boxes[i]))
+	    rects[n++] = boxes[i];
+    }
+
+    if (n == n_old)
+    {
+	free (rects);
+	return TRUE;
+    }
+
+    if (n > 1)
+	quick_sort_rects (rects, n);
+
+    result.extents = *pixman_region_empty_box;
+    result.data = pixman_region_empty_data;
+
+    n_active = 0;
+    next = 0;
+    prev_band = 0;
+    y = rects[0].y1;
+
+    while (next < n || n_active)
+    {
+	/* Skip the gaps between rectangles */
+	if (!n_active)
+	    y = rects[next].y1;
+
+	/* Insert the rectangles that start here */
+	while (next < n && rects[next].y1 == y)
+	{
+	    int lo = 0, hi = n_active;
+
+	    while (lo < hi)
+	    {
+		int mid = (lo + hi) / 2;
+
+		if (active[mid].x1 <= rects[next].x1)
+		    lo = mid + 1;
+		else
+		    hi = mid;
+	    }
+
+	    memmove (&active[lo + 1], &active[lo],
+	             (n_active - lo) * sizeof (box_type_t));
+	    active[lo] = rects[next++];
+	    n_active++;
+	}
+
+	/* The band ends where the next rectangle starts or ends */
+	y_next = (next < n) ? rects[next].y1 : PIXMAN_REGION_MAX;
+	for (i = 0; i < n_active; i++)
+	{
+	    if (active[i].y2 < y_next)
+		y_next = active[i].y2;
+	}
+
+	cur_band = new_reg->data->numRects;
+
+	x1 = active[0].x1;
+	x2 = active[0].x2;
+
+	for (i = 1; i <= n_active; i++)
+	{
+	    if (i < n_active && active[i].x1 <= x2)
+	    {
+		if (active[i].x2 > x2)
+		    x2 = active[i].x2;
+		continue;
+	    }
+
+	    RECTALLOC_BAIL (new_reg, 1, bail);
+	    next_rect = PIXREGION_TOP (new_reg);
+	    ADDRECT (next_rect, x1, y, x2, y_next);
+	    new_reg->data->numRects++;
+
+	    if (i < n_active)
+	    {
+		x1 = active[i].x1;
+		x2 = active[i].x2;
+	    }
+	}
+
+	COALESCE (new_reg, prev_band, cur_band);
+
+	/* Remove the rectangles that end here */
+	for (i = j = 0; i < n_active; i++)
+	{
+	    if (active[i].y2 != y_next)
+		active[j++] = active[i];
+	}
+
+	n_active = j;
+	y = y_next;
+    }
+
+    free (rects);
+
+    numRects = new_reg->data->numRects;
+
+    if (numRects == 1)
+    {
+	new_reg->extents = *PIXREGION_BOXPTR (new_reg);
+	FREE_DATA (new_reg);
+	new_reg->data = (region_data_type_t *)NULL;
+    }
+    else
+    {
+	pixman_set_extents (new_reg);
+	DOWNSIZE (new_reg, numRects);
+    }
+
+    FREE_DATA (region);
+    *region = result;
+
+    GOOD (region);
+
+    return TRUE;
+
+bail:
+    free (rects);
+    FREE_DATA (new_reg);
+
+    return pixman_break (region);
+}
+
 /*======================================================================
  *                Region Subtraction
  *====================================================================*/
@@ -2000,105 +2284,520 @@ PREFIX (_subtract) (region_type_t *reg_d,
 }
 
 /*======================================================================
- *	    Region Inversion
+ *	    Multi-way Region Operations
  *====================================================================*/
 
+/* State of one operand in the sweep of PREFIX(_combine) */
+typedef struct
+{
+    box_type_t *band;		/* First box of the current band */
+    box_type_t *band_end;	/* End of the current band */
+    box_type_t *end;		/* End of the boxes of the region */
+} combine_operand_t;
+
+/* A vertical edge of a box of operand @index in the current band */
+typedef struct
+{
+    int		x;
+    int		index;
+} combine_edge_t;
+
+#define N_STACK_OPERANDS 64
+#define N_STACK_EDGES 512
+
+static force_inline int
+combine_highest_bit (uint32_t w)
+{
+#ifdef HAVE_BUILTIN_CLZ
+    return 31 - __builtin_clz (w);
+#else
+    int n = 31;
+
+    while (!(w & 0x80000000))
+    {
+	w <<= 1;
+	n--;
+    }
+
+    return n;
+#endif
+}
+
+/* Sort @n_runs sorted runs of edges, starting at the offsets in @runs,
+ * by merging them pairwise. @tmp has room for all the edges. Returns
+ * whichever of the two buffers holds the result.
+ */
+static combine_edge_t *
+combine_merge_runs (combine_edge_t *edges, combine_edge_t *tmp,
+                    int *runs, int n_runs, int n_edges)
+{
+    while (n_runs > 1)
+    {
+	combine_edge_t *swap;
+	int i, n = 0;
+
+	for (i = 0; i < n_runs; i += 2)
+	{
+	    int a = runs[i];
+	    int a_end = (i + 1 < n_runs)? runs[i + 1] : n_edges;
+	    int b = a_end;
+	    int b_end = (i + 2 < n_runs)? runs[i + 2] : n_edges;
+	    int k = a;
+
+	    while (a < a_end && b < b_end)
+		tmp[k++] = (edges[b].x < edges[a].x)? edges[b++] : edges[a++];
+	    while (a < a_end)
+		tmp[k++] = edges[a++];
+	    while (b < b_end)
+		tmp[k++] = edges[b++];
+
+	    runs[n++] = runs[i];
+	}
+
+	n_runs = n;
+
+	swap = edges;
+	edges = tmp;
+	tmp = swap;
+    }
+
+    return edges;
+}
+
 /*-
  *-----------------------------------------------------------------------
- * pixman_region_inverse --
- *	Take a region and a box and return a region that is everything
- *	in the box but not in the region. The careful reader will note
- *	that this is the same as subtracting the region from the box...
+ * pixman_region_combine --
+ *	Compute ((regions[0] ops[0] regions[1]) ops[1] regions[2]) ...
+ *	and leave the result in dest.
+ *
+ *	Instead of one pixman_op() pass and one temporary region per
+ *	operation, all the regions are swept together from top to
+ *	bottom. In each band, the vertical edges of the boxes of all the
+ *	regions are merged into one list, sorted by x, and walked from
+ *	left to right.
+ *
+ *	Whether a point is in the result only depends on the last region
+ *	that decides it: one the point is in, for a union or a
+ *	subtraction, or one it is not in, for an intersection. The
+ *	operations after it leave the result alone, and if there is no
+ *	such region the result is whether the point is in regions[0]. So
+ *	the sweep keeps a bitmask of the deciding regions, flips a bit at
+ *	every edge, and looks up the highest bit.
+ *
+ *	The result is built in a single new array of rectangles, and
+ *	bands are coalesced as they are produced.
  *
  * Results:
- *	TRUE.
+ *	TRUE if successful.
  *
  * Side Effects:
- *	new_reg is overwritten.
+ *	dest is overwritten. It may be one of the regions.
  *
  *-----------------------------------------------------------------------
  */
 PIXMAN_EXPORT pixman_bool_t
-PREFIX (_inverse) (region_type_t *new_reg,  /* Destination region */
-		   region_type_t *reg1,     /* Region to invert */
-		   box_type_t *   inv_rect) /* Bounding box for inversion */
+PREFIX (_combine) (region_type_t *           dest,
+                   int                       n_regions,
+                   region_type_t * const *   regions,
+                   const pixman_region_op_t *ops)
 {
-    region_type_t inv_reg; /* Quick and dirty region made from the
-			    * bounding box */
-    GOOD (reg1);
-    GOOD (new_reg);
-    
-    /* check for trivial rejects */
-    if (PIXREGION_NIL (reg1) || !EXTENTCHECK (inv_rect, &reg1->extents))
+    combine_operand_t stack_operands[N_STACK_OPERANDS];
+    int stack_runs[N_STACK_OPERANDS];
+    uint32_t stack_masks[2 * ((N_STACK_OPERANDS + 31) / 32)];
+    combine_edge_t stack_edges[2 * N_STACK_EDGES];
+    combine_operand_t *operands = stack_operands;
+    combine_edge_t *edges = stack_edges;
+    combine_edge_t *sorted;
+    int *runs = stack_runs;
+    uint32_t *deciding = stack_masks, *intersecting;
+    region_type_t result;
+    region_type_t *res = &result;
+    box_type_t *next_rect, *r;
+    int numRects, prev_band, cur_band, n_words, n_runs, n_edges;
+    int i, j, x, x1, y, y_next, inside, in, in0;
+    size_t size, max_edges;
+
+    GOOD (dest);
+
+    return_val_if_fail (n_regions > 0, FALSE);
+
+    for (i = 0; i < n_regions - 1; ++i)
     {
-        if (PIXREGION_NAR (reg1))
-	    return pixman_break (new_reg);
-	
-        new_reg->extents = *inv_rect;
-        FREE_DATA (new_reg);
-        new_reg->data = (region_data_type_t *)NULL;
-	
-        return TRUE;
+	return_val_if_fail (ops[i] >= PIXMAN_REGION_OP_UNION &&
+			    ops[i] <= PIXMAN_REGION_OP_SUBTRACT, FALSE);
     }
 
-    /* Add those rectangles in region 1 that aren't in region 2,
-     * do yucky subtraction for overlaps, and
-     * just throw away rectangles in region 2 that aren't in region 1
-     */
-    inv_reg.extents = *inv_rect;
-    inv_reg.data = (region_data_type_t *)NULL;
-    if (!pixman_op (new_reg, &inv_reg, reg1, pixman_region_subtract_o, TRUE, FALSE))
-	return FALSE;
+    if (n_regions == 1)
+	return PREFIX (_copy) (dest, regions[0]);
 
-    /*
-     * Can't alter new_reg's extents before we call pixman_op because
-     * it might be one of the source regions and pixman_op depends
-     * on the extents of those regions being unaltered. Besides, this
-     * way there's no checking against rectangles that will be nuked
-     * due to coalescing, so we have to examine fewer rectangles.
-     */
-    pixman_set_extents (new_reg);
-    GOOD (new_reg);
-    return TRUE;
-}
+    for (i = 0; i < n_regions; ++i)
+    {
+	GOOD (regions[i]);
 
-/* In time O(log n), locate the first box whose y2 is greater than y.
- * Return @end if no such box exists.
- */
-static box_type_t *
-find_box_for_y (box_type_t *begin, box_type_t *end, int y)
-{
-    box_type_t *mid;
+	if (PIXREGION_NAR (regions[i]))
+	    return pixman_break (dest);
+    }
 
-    if (end == begin)
-	return end;
+    n_words = (n_regions + 31) / 32;
 
-    if (end - begin == 1)
+    if (n_regions > N_STACK_OPERANDS)
     {
-	if (begin->y2 > y)
-	    return begin;
-	else
-	    return end;
+	/* One block for the operands, the runs and the masks */
+	size = n_regions * (sizeof (combine_operand_t) + sizeof (int));
+
+	if (!(operands = pixman_malloc_ab (1, size + 2 * n_words * sizeof (uint32_t))))
+	    return pixman_break (dest);
+
+	deciding = (uint32_t *)(operands + n_regions);
+	runs = (int *)(deciding + 2 * n_words);
     }
 
-    mid = begin + (end - begin) / 2;
-    if (mid->y2 > y)
+    /* Outside of all boxes, only the intersections decide */
+    intersecting = deciding + n_words;
+    memset (intersecting, 0, n_words * sizeof (uint32_t));
+
+    for (i = 1; i < n_regions; ++i)
     {
-	/* If no box is found in [begin, mid], the function
-	 * will return @mid, which is then known to be the
-	 * correct answer.
-	 */
-	return find_box_for_y (begin, mid, y);
+	if (ops[i - 1] == PIXMAN_REGION_OP_INTERSECT)
+	    intersecting[i >> 5] |= 1U << (i & 31);
     }
-    else
+
+    /* A band can't have more edges than the widest band of every
+     * region together.
+     */
+    size = 0;
+    max_edges = 0;
+    y = INT_MAX;
+
+    for (i = 0; i < n_regions; ++i)
     {
-	return find_box_for_y (mid, end, y);
-    }
-}
+	combine_operand_t *op = &operands[i];
+	box_type_t *band_end;
+	int widest = 0;
 
-/*
- *   rect_in(region, rect)
- *   This routine takes a pointer to a region and a pointer to a box
+	op->band = PIXREGION_RECTS (regions[i]);
+	op->end = op->band + PIXREGION_NUMRECTS (regions[i]);
+	op->band_end = op->end;
+
+	for (r = op->band; r != op->end; r = band_end)
+	{
+	    band_end = find_band_end (r, op->end);
+	    widest = MAX (widest, band_end - r);
+
+	    if (r == op->band)
+		op->band_end = band_end;
+	}
+
+	if (op->band != op->end && op->band->y1 < y)
+	    y = op->band->y1;
+
+	size += PIXREGION_NUMRECTS (regions[i]);
+	max_edges += 2 * widest;
+    }
+
+    result.extents = *pixman_region_empty_box;
+    result.data = pixman_region_empty_data;
+
+    if (max_edges > N_STACK_EDGES)
+    {
+	if (!(edges = pixman_malloc_ab (max_edges, 2 * sizeof (combine_edge_t))))
+	    goto bail;
+    }
+
+    /* guess at the size of the result */
+    if (size && !pixman_rect_alloc (res, size))
+	goto bail;
+
+    prev_band = 0;
+
+    while (y != INT_MAX)
+    {
+	/* The band ends where any region's band starts or ends. The
+	 * edges of the regions that cover it form one sorted run each.
+	 */
+	y_next = INT_MAX;
+	n_runs = 0;
+	n_edges = 0;
+
+	for (i = 0; i < n_regions; ++i)
+	{
+	    combine_operand_t *op = &operands[i];
+
+	    if (op->band == op->end)
+		continue;
+
+	    if (op->band->y1 > y)
+	    {
+		if (op->band->y1 < y_next)
+		    y_next = op->band->y1;
+
+		continue;
+	    }
+
+	    if (op->band->y2 < y_next)
+		y_next = op->band->y2;
+
+	    runs[n_runs++] = n_edges;
+
+	    for (r = op->band; r != op->band_end; r++)
+	    {
+		edges[n_edges].x = r->x1;
+		edges[n_edges++].index = i;
+		edges[n_edges].x = r->x2;
+		edges[n_edges++].index = i;
+	    }
+	}
+
+	sorted = combine_merge_runs (edges, edges + max_edges,
+				     runs, n_runs, n_edges);
+
+	/* Sweep the band [y, y_next) */
+	cur_band = res->data->numRects;
+	memcpy (deciding, intersecting, n_words * sizeof (uint32_t));
+	x1 = 0;
+	in = FALSE;
+	in0 = FALSE;
+
+	for (j = 0; j < n_edges; )
+	{
+	    x = sorted[j].x;
+
+	    /* Crossing an edge flips whether a region decides */
+	    for (; j < n_edges && sorted[j].x == x; ++j)
+	    {
+		int index = sorted[j].index;
+
+		if (index)
+		    deciding[index >> 5] ^= 1U << (index & 31);
+		else
+		    in0 = !in0;
+	    }
+
+	    inside = in0;
+
+	    for (i = n_words - 1; i >= 0; --i)
+	    {
+		if (deciding[i])
+		{
+		    int index = i * 32 + combine_highest_bit (deciding[i]);
+
+		    inside = (ops[index - 1] == PIXMAN_REGION_OP_UNION);
+		    break;
+		}
+	    }
+
+	    if (inside && !in)
+	    {
+		x1 = x;
+	    }
+	    else if (!inside && in)
+	    {
+		RECTALLOC_BAIL (res, 1, bail);
+		next_rect = PIXREGION_TOP (res);
+		ADDRECT (next_rect, x1, y, x, y_next);
+		res->data->numRects++;
+	    }
+
+	    in = inside;
+	}
+
+	COALESCE (res, prev_band, cur_band);
+
+	/* Move on to the next band of the regions whose band ends
+	 * here, and to the top of the next band.
+	 */
+	y = INT_MAX;
+
+	for (i = 0; i < n_regions; ++i)
+	{
+	    combine_operand_t *op = &operands[i];
+
+	    if (op->band == op->end)
+		continue;
+
+	    if (op->band->y2 == y_next)
+	    {
+		op->band = op->band_end;
+
+		if (op->band == op->end)
+		    continue;
+
+		op->band_end = find_band_end (op->band, op->end);
+	    }
+
+	    if (op->band->y1 > y_next)
+		y = MIN (y, op->band->y1);
+	    else
+		y = y_next;
+	}
+    }
+
+    if (operands != stack_operands)
+	free (operands);
+    if (edges != stack_edges)
+	free (edges);
+
+    if (!(numRects = res->data->numRects))
+    {
+	FREE_DATA (res);
+	res->data = pixman_region_empty_data;
+    }
+    else if (numRects == 1)
+    {
+	res->extents = *PIXREGION_BOXPTR (res);
+	FREE_DATA (res);
+	res->data = (region_data_type_t *)NULL;
+    }
+    else
+    {
+	DOWNSIZE (res, numRects);
+	pixman_set_extents (res);
+    }
+
+    FREE_DATA (dest);
+    *dest = result;
+
+    GOOD (dest);
+    return TRUE;
+
+bail:
+    if (operands != stack_operands)
+	free (operands);
+    if (edges != stack_edges)
+	free (edges);
+
+    FREE_DATA (res);
+
+    return pixman_break (dest);
+}
+
+/*======================================================================
+ *	    Region Inversion
+ *====================================================================*/
+
+/*-
+ *-----------------------------------------------------------------------
+ * pixman_region_inverse --
+ *	Take a region and a box and return a region that is everything
+ *	in the box but not in the region. The careful reader will note
+ *	that this is the same as subtracting the region from the box...
+ *
+ * Results:
+ *	TRUE.
+ *
+ * Side Effects:
+ *	new_reg is overwritten.
+ *
+ *-----------------------------------------------------------------------
+ */
+PIXMAN_EXPORT pixman_bool_t
+PREFIX (_inverse) (region_type_t *new_reg,  /* Destination region */
+		   region_type_t *reg1,     /* Region to invert */
+		   box_type_t *   inv_rect) /* Bounding box for inversion */
+{
+    region_type_t inv_reg; /* Quick and dirty region made from the
+			    * bounding box */
+    GOOD (reg1);
+    GOOD (new_reg);
+    
+    /* check for trivial rejects */
+    if (PIXREGION_NIL (reg1) || !EXTENTCHECK (inv_rect, &reg1->extents))
+    {
+        if (PIXREGION_NAR (reg1))
+	    return pixman_break (new_reg);
+	
+        new_reg->extents = *inv_rect;
+        FREE_DATA (new_reg);
+        new_reg->data = (region_data_type_t *)NULL;
+	
+        return TRUE;
+    }
+
+    /* Add those rectangles in region 1 that aren't in region 2,
+     * do yucky subtraction for overlaps, and
+     * just throw away rectangles in region 2 that aren't in region 1
+     */
+    inv_reg.extents = *inv_rect;
+    inv_reg.data = (region_data_type_t *)NULL;
+    if (!pixman_op (new_reg, &inv_reg, reg1, pixman_region_subtract_o, TRUE, FALSE))
+	return FALSE;
+
+    /*
+     * Can't alter new_reg's extents before we call pixman_op because
+     * it might be one of the source regions and pixman_op depends
+     * on the extents of those regions being unaltered. Besides, this
+     * way there's no checking against rectangles that will be nuked
+     * due to coalescing, so we have to examine fewer rectangles.
+     */
+    pixman_set_extents (new_reg);
+    GOOD (new_reg);
+    return TRUE;
+}
+
+/* In time O(log n), locate the first box whose y2 is greater than y.
+ * Return @end if no such box exists.
+ */
+static box_type_t *
+find_box_for_y (box_type_t *begin, box_type_t *end, int y)
+{
+    box_type_t *mid;
+
+    if (end == begin)
+	return end;
+
+    if (end - begin == 1)
+    {
+	if (begin->y2 > y)
+	    return begin;
+	else
+	    return end;
+    }
+
+    mid = begin + (end - begin) / 2;
+    if (mid->y2 > y)
+    {
+	/* If no box is found in [begin, mid], the function
+	 * will return @mid, which is then known to be the
+	 * correct answer.
+	 */
+	return find_box_for_y (begin, mid, y);
+    }
+    else
+    {
+	return find_box_for_y (mid, end, y);
+    }
+}
+
+/* Find the first box in a band, [@begin, @end), that ends to the right
+ * of @x. The boxes of a band are sorted and don't overlap, so their x2
+ * increase. Return @end if no such box exists.
+ */
+static box_type_t *
+find_box_for_x (box_type_t *begin, box_type_t *end, int x)
+{
+    while (begin != end)
+    {
+	box_type_t *mid = begin + (end - begin) / 2;
+
+	if (mid->x2 > x)
+	    end = mid;
+	else
+	    begin = mid + 1;
+    }
+
+    return begin;
+}
+
+/* Return the end of the band that starts at @band */
+static box_type_t *
+find_band_end (box_type_t *band, box_type_t *end)
+{
+    return find_box_for_y (band, end, band->y2);
+}
+
+/*
+ *   rect_in(region, rect)
+ *   This routine takes a pointer to a region and a pointer to a box
  *   and determines if the box is outside/inside/partly inside the region.
  *
  *   The idea is to travel through the list of rectangles trying to cover the
@@ -2167,7 +2866,16 @@ PREFIX (_contains_rectangle) (region_type_t *  region,
 	}
 
         if (pbox->x2 <= x)
-	    continue;           /* not far enough over yet */
+        {
+            /* not far enough over yet; skip to the first box that is */
+            box_type_t *band_end = find_band_end (pbox, pbox_end);
+
+            if ((pbox = find_box_for_x (pbox, band_end, x)) == band_end)
+            {
+                pbox--;
+                continue;
+            }
+        }
 
         if (pbox->x1 > x)
         {
@@ -2369,21 +3077,19 @@ PREFIX (_contains_point) (region_type_t * region,
 
     pbox = find_box_for_y (pbox, pbox_end, y);
 
-    for (;pbox != pbox_end; pbox++)
-    {
-        if ((y < pbox->y1) || (x < pbox->x1))
-	    break;              /* missed it */
+    if (pbox == pbox_end || y < pbox->y1)
+	return(FALSE);          /* in a gap between bands */
 
-        if (x >= pbox->x2)
-	    continue;           /* not there yet */
+    pbox_end = find_band_end (pbox, pbox_end);
+    pbox = find_box_for_x (pbox, pbox_end, x);
 
-        if (box)
-	    *box = *pbox;
+    if (pbox == pbox_end || x < pbox->x1)
+	return(FALSE);          /* in a gap within the band */
 
-        return(TRUE);
-    }
+    if (box)
+	*box = *pbox;
 
-    return(FALSE);
+    return(TRUE);
 }
 
 PIXMAN_EXPORT int
@@ -2588,24 +3294,82 @@ bitmap_addrect (region_type_t *reg,
     return r;
 }
 
+/* The bit of the leftmost pixel in a word of an a1 bitmap */
+#define FIRST_PIXEL (0xffffffff & ~SCREEN_SHIFT_RIGHT (0xffffffff, 1))
+
+/* Return the position of the leftmost set pixel of the non-zero word @w */
+static force_inline int
+find_first_pixel (uint32_t w)
+{
+#if defined (HAVE_BUILTIN_CLZ) && defined (WORDS_BIGENDIAN)
+    return __builtin_clz (w);
+#elif defined (HAVE_BUILTIN_CLZ)
+    return 31 - __builtin_clz (w & -w);
+#else
+    int n = 0;
+
+    while (!(w & FIRST_PIXEL))
+    {
+	w = SCREEN_SHIFT_LEFT (w, 1);
+	n++;
+    }
+
+    return n;
+#endif
+}
+
+/* Threshold a row of an a8 image into a1 bitmap words. Pixels of 0x80
+ * and above are set, as when the row is converted to a1 by compositing.
+ */
+static void
+bitmap_from_a8_row (uint32_t *bits, const uint8_t *row, int width)
+{
+    int x, i;
+
+    for (x = 0; x < width; x += 32)
+    {
+	uint32_t w = 0;
+
+	for (i = 0; i < 32 && x + i < width; i++)
+	{
+	    if (row[x + i] & 0x80)
+		w |= SCREEN_SHIFT_RIGHT (FIRST_PIXEL, i);
+	}
+
+	*bits++ = w;
+    }
+}
+
+static pixman_bool_t
+bitmap_rows_equal (const uint32_t *a, const uint32_t *b,
+                   int n_words, uint32_t last_mask)
+{
+    if (n_words == 0)
+	return TRUE;
+
+    return memcmp (a, b, (n_words - 1) * sizeof (uint32_t)) == 0 &&
+	((a[n_words - 1] ^ b[n_words - 1]) & last_mask) == 0;
+}
+
 /* Convert bitmap clip mask into clipping region.
- * First, goes through each line and makes boxes by noting the transitions
- * from 0 to 1 and 1 to 0.
+ * First, goes through each line and makes boxes by finding the
+ * transitions from 0 to 1 and 1 to 0, a word at a time.
  * Then it coalesces the current line with the previous if they have boxes
- * at the same X coordinates.
- * Stride is in number of uint32_t per line.
+ * at the same X coordinates. A line that is identical to the previous
+ * one just extends the boxes of the previous line.
+ * a8 images are thresholded into a bitmap one line at a time.
  */
 PIXMAN_EXPORT void
 PREFIX (_init_from_image) (region_type_t *region,
                            pixman_image_t *image)
 {
-    uint32_t mask0 = 0xffffffff & ~SCREEN_SHIFT_RIGHT(0xffffffff, 1);
+    uint32_t stack_bits[128];
+    uint32_t *bits = NULL, *line, *prev_line = NULL;
     box_type_t *first_rect, *rects, *prect_line_start;
     box_type_t *old_rect, *new_rect;
-    uint32_t *pw, w, *pw_line, *pw_line_end;
+    uint32_t *pw, *pw_line, w, m, valid, last_mask;
     int	irect_prev_start, irect_line_start;
-    int	h, base, rx1 = 0, crects;
-    int	ib;
+    int	h, base, x, rx1 = 0, crects, n_words;
     pixman_bool_t in_box, same;
     int width, height, stride;
 
@@ -2614,120 +3378,94 @@ PREFIX (_init_from_image) (region_type_t *region,
     critical_if_fail (region->data);
 
     return_if_fail (image->type == BITS);
-    return_if_fail (image->bits.format == PIXMAN_a1);
+    return_if_fail (image->bits.format == PIXMAN_a1 ||
+		    image->bits.format == PIXMAN_a8);
 
     pw_line = pixman_image_get_data (image);
     width = pixman_image_get_width (image);
     height = pixman_image_get_height (image);
     stride = pixman_image_get_stride (image) / 4;
 
+    n_words = (width + 31) >> 5;
+    last_mask = ~SCREEN_SHIFT_RIGHT (0xffffffff, width & 31);
+    if (!(width & 31))
+	last_mask = 0xffffffff;
+
+    if (image->bits.format == PIXMAN_a8)
+    {
+	if (2 * n_words <= (int)(sizeof (stack_bits) / sizeof (stack_bits[0])))
+	    bits = stack_bits;
+	else if (!(bits = pixman_malloc_ab (n_words, 2 * sizeof (uint32_t))))
+	    return;
+    }
+
     first_rect = PIXREGION_BOXPTR(region);
     rects = first_rect;
 
     region->extents.x1 = width - 1;
     region->extents.x2 = 0;
     irect_prev_start = -1;
-    for (h = 0; h < height; h++)
+    for (h = 0; h < height; h++, pw_line += stride)
     {
-        pw = pw_line;
-        pw_line += stride;
-        irect_line_start = rects - first_rect;
-
-        /* If the Screen left most bit of the word is set, we're starting in
-         * a box */
-        if (READ(pw) & mask0)
+        if (bits)
         {
-            in_box = TRUE;
-            rx1 = 0;
+            line = bits + (h & 1) * n_words;
+            bitmap_from_a8_row (line, (uint8_t *)pw_line, width);
         }
         else
         {
-            in_box = FALSE;
+            line = pw_line;
         }
 
-        /* Process all words which are fully in the pixmap */
-        pw_line_end = pw + (width >> 5);
-        for (base = 0; pw < pw_line_end; base += 32)
+        /* The boxes of the previous line (or of the band it was
+         * coalesced into) are the last ones; extend them down.
+         */
+        if (prev_line && bitmap_rows_equal (prev_line, line, n_words, last_mask))
         {
-            w = READ(pw++);
-            if (in_box)
-            {
-                if (!~w)
-                    continue;
-            }
-            else
-            {
-                if (!w)
-                    continue;
-            }
-            for (ib = 0; ib < 32; ib++)
-            {
-                /* If the Screen left most bit of the word is set, we're
-                 * starting a box */
-                if (w & mask0)
-                {
-                    if (!in_box)
-                    {
-                        rx1 = base + ib;
-                        /* start new box */
-                        in_box = TRUE;
-                    }
-                }
-                else
-                {
-                    if (in_box)
-                    {
-                        /* end box */
-                        rects = bitmap_addrect (region, rects, &first_rect,
-                                                rx1, h, base + ib, h + 1);
-                        if (rects == NULL)
-                            goto error;
-                        in_box = FALSE;
-                    }
-                }
-                /* Shift the word VISUALLY left one. */
-                w = SCREEN_SHIFT_LEFT(w, 1);
-            }
+            prev_line = line;
+            for (old_rect = first_rect + irect_prev_start; old_rect < rects; old_rect++)
+                old_rect->y2 += 1;
+            continue;
         }
 
-        if (width & 31)
+        prev_line = line;
+        irect_line_start = rects - first_rect;
+        in_box = FALSE;
+
+        for (base = 0, pw = line; base < width; base += 32)
         {
-            /* Process final partial word on line */
-             w = READ(pw++);
-            for (ib = 0; ib < (width & 31); ib++)
+            w = READ(pw++);
+            valid = (base + 32 <= width) ? 0xffffffff : last_mask;
+
+            /* Jump from one transition to the next; each one turns a
+             * box on or off.
+             */
+            for (x = 0; ; in_box = !in_box)
             {
-                /* If the Screen left most bit of the word is set, we're
-                 * starting a box */
-                if (w & mask0)
+                m = (in_box ? ~w : w) & valid & SCREEN_SHIFT_RIGHT (0xffffffff, x);
+                if (!m)
+                    break;
+
+                x = find_first_pixel (m);
+
+                if (!in_box)
                 {
-                    if (!in_box)
-                    {
-                        rx1 = base + ib;
-                        /* start new box */
-                        in_box = TRUE;
-                    }
+                    rx1 = base + x;
                 }
                 else
                 {
-                    if (in_box)
-                    {
-                        /* end box */
-                        rects = bitmap_addrect(region, rects, &first_rect,
-					       rx1, h, base + ib, h + 1);
-			if (rects == NULL)
-			    goto error;
-                        in_box = FALSE;
-                    }
+                    rects = bitmap_addrect (region, rects, &first_rect,
+                                            rx1, h, base + x, h + 1);
+                    if (rects == NULL)
+                        goto error;
                 }
-                /* Shift the word VISUALLY left one. */
-                w = SCREEN_SHIFT_LEFT(w, 1);
             }
         }
         /* If scanline ended with last bit set, end the box */
         if (in_box)
         {
             rects = bitmap_addrect(region, rects, &first_rect,
-				   rx1, h, base + (width & 31), h + 1);
+				   rx1, h, width, h + 1);
 	    if (rects == NULL)
 		goto error;
         }
@@ -2788,5 +3526,434 @@ PREFIX (_init_from_image) (region_type_t *region,
     }
 
  error:
-    return;
+    if (bits != stack_bits)
+	free (bits);
+}
+
+/* Set every pixel of an a8 image to the coverage of the region translated
+ * by (@x, @y): 0xff inside of it and 0 outside. Each band is written into
+ * its first row with one memset() per span and per gap, and then copied
+ * to the other rows of the band.
+ */
+PIXMAN_EXPORT pixman_bool_t
+PREFIX (_rasterize) (region_type_t * region,
+                     pixman_image_t *image,
+                     int             x,
+                     int             y)
+{
+    box_type_t *band, *band_end, *box, *end;
+    uint8_t *bits, *row;
+    int width, height, stride;
+    int row_y, y2;
+
+    return_val_if_fail (image->type == BITS, FALSE);
+    return_val_if_fail (image->bits.format == PIXMAN_a8, FALSE);
+
+    width = image->bits.width;
+    height = image->bits.height;
+    stride = image->bits.rowstride * 4;
+    bits = (uint8_t *)image->bits.bits;
+
+    band = PIXREGION_RECTS (region);
+    end = band + PIXREGION_NUMRECTS (region);
+
+    /* Skip the bands that are above the image */
+    band = find_box_for_y (band, end, -y);
+
+    row_y = 0;
+
+    for (; band != end && band->y1 + y < height; band = band_end)
+    {
+	int y1 = MAX (band->y1 + y, 0);
+	int x1 = 0;
+
+	band_end = find_band_end (band, end);
+	y2 = MIN (band->y2 + y, height);
+
+	/* Clear the rows between this band and the previous one */
+	if (row_y < y1)
+	    memset (bits + row_y * stride, 0, (size_t)(y1 - row_y) * stride);
+
+	row = bits + y1 * stride;
+
+	for (box = band; box != band_end; box++)
+	{
+	    int bx1 = MAX (box->x1 + x, x1);
+	    int bx2 = MIN (box->x2 + x, width);
+
+	    if (bx1 >= bx2)
+		continue;
+
+	    memset (row + x1, 0, bx1 - x1);
+	    memset (row + bx1, 0xff, bx2 - bx1);
+
+	    x1 = bx2;
+	}
+
+	memset (row + x1, 0, width - x1);
+
+	for (row_y = y1 + 1; row_y < y2; row_y++)
+	    memcpy (bits + row_y * stride, row, width);
+    }
+
+    if (row_y < height)
+	memset (bits + row_y * stride, 0, (size_t)(height - row_y) * stride);
+
+    return TRUE;
+}
+
+/* Add the horizontal coverage of the subpixel span [@x1, @x2), times
+ * @weight, to the accumulators of the pixels that it crosses.
+ */
+static force_inline void
+rasterize_aa_span (uint32_t *acc,
+                   int       x1,
+                   int       x2,
+                   int       shift,
+                   uint32_t  weight)
+{
+    int n = 1 << shift;
+    int px1 = x1 >> shift;
+    int px2 = (x2 - 1) >> shift;
+    int i;
+
+    if (px1 == px2)
+    {
+	acc[px1] += (x2 - x1) * weight;
+	return;
+    }
+
+    acc[px1] += (n - (x1 & (n - 1))) * weight;
+    for (i = px1 + 1; i < px2; i++)
+	acc[i] += n * weight;
+    acc[px2] += (((x2 - 1) & (n - 1)) + 1) * weight;
+}
+
+/* Like PREFIX(_rasterize), but the coordinates of the region are in units
+ * of 1 / (1 << @subpixel_bits) pixel, so a region that was built on a finer
+ * grid, or from fractional boxes rounded to one, gives an antialiased
+ * mask. Each pixel gets the fraction of its subpixels that the region
+ * covers. @x and @y are in whole pixels.
+ */
+PIXMAN_EXPORT pixman_bool_t
+PREFIX (_rasterize_aa) (region_type_t * region,
+                        pixman_image_t *image,
+                        int             x,
+                        int             y,
+                        int             subpixel_bits)
+{
+    box_type_t *first, *band, *band_end, *box, *end;
+    int shift = subpixel_bits;
+    int n = 1 << shift;
+    uint32_t total = n * n;
+    uint32_t *acc;
+    uint8_t *row;
+    int width, height, stride;
+    int sx, sy, i, j;
+
+    return_val_if_fail (image->type == BITS, FALSE);
+    return_val_if_fail (image->bits.format == PIXMAN_a8, FALSE);
+    return_val_if_fail (subpixel_bits >= 0 && subpixel_bits <= 4, FALSE);
+
+    if (subpixel_bits == 0)
+	return PREFIX (_rasterize) (region, image, x, y);
+
+    width = image->bits.width;
+    height = image->bits.height;
+    stride = image->bits.rowstride * 4;
+
+    if (width <= 0)
+	return TRUE;
+
+    acc = pixman_malloc_ab (width, sizeof (uint32_t));
+    if (!acc)
+	return FALSE;
+
+    first = PIXREGION_RECTS (region);
+    end = first + PIXREGION_NUMRECTS (region);
+
+    /* The origin of the image, in the subpixels of the region */
+    sx = -x * n;
+    sy = -y * n;
+
+    first = find_box_for_y (first, end, sy);
+
+    for (i = 0; i < height; i++, sy += n)
+    {
+	row = (uint8_t *)image->bits.bits + i * stride;
+
+	/* Skip the bands that end above this row */
+	while (first != end && first->y2 <= sy)
+	    first = find_band_end (first, end);
+
+	if (first == end || first->y1 >= sy + n)
+	{
+	    memset (row, 0, width);
+	    continue;
+	}
+
+	memset (acc, 0, width * sizeof (uint32_t));
+
+	for (band = first; band != end && band->y1 < sy + n; band = band_end)
+	{
+	    uint32_t weight = MIN (band->y2, sy + n) - MAX (band->y1, sy);
+
+	    band_end = find_band_end (band, end);
+
+	    for (box = band; box != band_end; box++)
+	    {
+		int x1 = MAX (box->x1 - sx, 0);
+		int x2 = MIN (box->x2 - sx, width * n);
+
+		if (x1 < x2)
+		    rasterize_aa_span (acc, x1, x2, shift, weight);
+	    }
+	}
+
+	for (j = 0; j < width; j++)
+	    row[j] = (acc[j] * 255 + total / 2) / total;
+    }
+
+    free (acc);
+
+    return TRUE;
+}
+
+/*======================================================================
+ *	    Packed Regions
+ *====================================================================*/
+
+/* A packed region stores each band once as the distance from the band
+ * above it, its height and its number of spans, followed by the spans
+ * as the distance from the end of the previous span and their width.
+ * All these numbers are non-negative and usually small, so they are
+ * written as little-endian base 128 varints: seven bits per byte, with
+ * the high bit set on all bytes but the last. A region that comes from
+ * a dithered mask or from text typically needs two or three bytes per
+ * box instead of sizeof (box_type_t).
+ *
+ * The stream follows the header directly.
+ */
+struct PREFIX (_packed)
+{
+    box_type_t	extents;
+    int		n_rects;
+    int		size;		/* Bytes in the stream */
+};
+
+#define PACKED_DATA(packed) ((const uint8_t *)((packed) + 1))
+
+/* What pixman_region_packed_iter_t holds */
+typedef struct
+{
+    const uint8_t *	next;
+    const uint8_t *	end;
+    int32_t		left;		/* x1 of the extents */
+    int32_t		x;		/* x2 of the previous span in the band */
+    int32_t		y1, y2;		/* The current band */
+    int32_t		n_spans;	/* Spans left in the band */
+} packed_iter_t;
+
+/* Write @v at @p, unless @p is NULL, and return the number of bytes */
+static int
+packed_put (uint8_t *p, uint32_t v)
+{
+    int n = 1;
+
+    while (v >= 0x80)
+    {
+	if (p)
+	    *p++ = (v & 0x7f) | 0x80;
+	v >>= 7;
+	n++;
+    }
+
+    if (p)
+	*p = v;
+
+    return n;
+}
+
+static force_inline uint32_t
+packed_get (const uint8_t **p)
+{
+    const uint8_t *q = *p;
+    uint32_t v = 0;
+    int shift = 0;
+
+    while (*q & 0x80)
+    {
+	v |= (uint32_t)(*q++ & 0x7f) << shift;
+	shift += 7;
+    }
+    v |= (uint32_t)*q++ << shift;
+
+    *p = q;
+
+    return v;
+}
+
+/* Encode the boxes of @region into @out, or just measure them when @out
+ * is NULL. The differences are taken as unsigned 32 bit numbers, which
+ * can't overflow since each coordinate is never smaller than the one it
+ * is measured from.
+ */
+static int
+packed_encode (region_type_t *region, uint8_t *out)
+{
+    box_type_t *box = PIXREGION_RECTS (region);
+    box_type_t *end = box + PIXREGION_NUMRECTS (region);
+    int32_t y = region->extents.y1;
+    int size = 0;
+
+#define PUT(v) (size += packed_put (out ? out + size : NULL, (v)))
+
+    while (box != end)
+    {
+	box_type_t *band_end = find_band_end (box, end);
+	int32_t x = region->extents.x1;
+
+	PUT ((uint32_t)box->y1 - (uint32_t)y);
+	PUT ((uint32_t)box->y2 - (uint32_t)box->y1);
+	PUT (band_end - box);
+
+	y = box->y2;
+
+	for (; box != band_end; box++)
+	{
+	    PUT ((uint32_t)box->x1 - (uint32_t)x);
+	    PUT ((uint32_t)box->x2 - (uint32_t)box->x1);
+
+	    x = box->x2;
+	}
+    }
+
+#undef PUT
+
+    return size;
+}
+
+PIXMAN_EXPORT packed_type_t *
+PREFIX (_pack) (region_type_t *region)
+{
+    packed_type_t *packed;
+    int size;
+
+    GOOD (region);
+
+    if (PIXREGION_NAR (region))
+	return NULL;
+
+    size = packed_encode (region, NULL);
+
+    packed = malloc (sizeof (packed_type_t) + size);
+    if (!packed)
+	return NULL;
+
+    packed->extents = region->extents;
+    packed->n_rects = PIXREGION_NUMRECTS (region);
+    packed->size = size;
+
+    packed_encode (region, (uint8_t *)(packed + 1));
+
+    return packed;
+}
+
+PIXMAN_EXPORT void
+PREFIX (_packed_destroy) (packed_type_t *packed)
+{
+    free (packed);
+}
+
+PIXMAN_EXPORT int
+PREFIX (_packed_size) (const packed_type_t *packed)
+{
+    return sizeof (packed_type_t) + packed->size;
+}
+
+PIXMAN_EXPORT const box_type_t *
+PREFIX (_packed_extents) (const packed_type_t *packed)
+{
+    return &packed->extents;
+}
+
+PIXMAN_EXPORT void
+PREFIX (_packed_iter_init) (pixman_region_packed_iter_t *public_iter,
+                            const packed_type_t *        packed)
+{
+    packed_iter_t *iter = (packed_iter_t *)public_iter;
+
+    COMPILE_TIME_ASSERT (
+	sizeof (packed_iter_t) <= sizeof (pixman_region_packed_iter_t));
+
+    iter->next = PACKED_DATA (packed);
+    iter->end = iter->next + packed->size;
+    iter->left = packed->extents.x1;
+    iter->x = packed->extents.x1;
+    iter->y1 = iter->y2 = packed->extents.y1;
+    iter->n_spans = 0;
+}
+
+/* Store the next box of the region, in y-x banded order, in @box */
+PIXMAN_EXPORT pixman_bool_t
+PREFIX (_packed_iter_next) (pixman_region_packed_iter_t *public_iter,
+                            box_type_t *                 box)
+{
+    packed_iter_t *iter = (packed_iter_t *)public_iter;
+
+    if (!iter->n_spans)
+    {
+	if (iter->next == iter->end)
+	    return FALSE;
+
+	iter->y1 = iter->y2 + packed_get (&iter->next);
+	iter->y2 = iter->y1 + packed_get (&iter->next);
+	iter->n_spans = packed_get (&iter->next);
+	iter->x = iter->left;
+    }
+
+    box->x1 = iter->x + packed_get (&iter->next);
+    box->x2 = iter->x = box->x1 + packed_get (&iter->next);
+    box->y1 = iter->y1;
+    box->y2 = iter->y2;
+
+    iter->n_spans--;
+
+    return TRUE;
+}
+
+PIXMAN_EXPORT pixman_bool_t
+PREFIX (_init_from_packed) (region_type_t *      region,
+                            const packed_type_t *packed)
+{
+    pixman_region_packed_iter_t iter;
+    box_type_t *box;
+
+    PREFIX (_init) (region);
+
+    if (packed->n_rects == 0)
+	return TRUE;
+
+    region->extents = packed->extents;
+
+    if (packed->n_rects == 1)
+    {
+	region->data = NULL;
+	return TRUE;
+    }
+
+    if (!pixman_rect_alloc (region, packed->n_rects))
+	return FALSE;
+
+    box = PIXREGION_BOXPTR (region);
+
+    PREFIX (_packed_iter_init) (&iter, packed);
+    while (PREFIX (_packed_iter_next) (&iter, box))
+	box++;
+
+    region->data->numRects = packed->n_rects;
+
+    GOOD (region);
+
+    return TRUE;
 }
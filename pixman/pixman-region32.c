@@ -33,6 +33,7 @@
 typedef pixman_box32_t		box_type_t;
 typedef pixman_region32_data_t	region_data_type_t;
 typedef pixman_region32_t	region_type_t;
+typedef pixman_region32_packed_t	packed_type_t;
 typedef int64_t                 overflow_int_t;
 
 typedef struct {
@@ -0,0 +1,340 @@
+/*
+ * Copyright © 2026 The pixman authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <math.h>
+#include "pixman-private.h"
+
+/* One-shot image resizing
+ *
+ * The image is resampled separably. Each source row is filtered
+ * horizontally once, into a ring of as many rows as the vertical filter
+ * has taps, and each destination row is then filtered vertically from
+ * that ring. So the intermediate buffer stays small however large the
+ * images are, and it is walked in the order it was written.
+ *
+ * All the arithmetic is done in floating point on premultiplied pixels
+ * as returned by the float fetchers, which means that sRGB sources are
+ * filtered in linear light.
+ */
+
+typedef struct
+{
+    int		n_taps;		/* Maximum number of taps per pixel */
+    int		box;		/* Box downscale factor, or 0 */
+    int *	first;		/* First source pixel of each destination pixel */
+    int *	n;		/* Number of taps of each destination pixel */
+    float *	weights;	/* n_taps weights for each destination pixel */
+} resize_axis_t;
+
+static void
+resize_axis_fini (resize_axis_t *axis)
+{
+    free (axis->first);
+    free (axis->n);
+    free (axis->weights);
+}
+
+/* Compute the weights that resample @src_size pixels into @dst_size.
+ * Destination pixel i is centered on (i + 0.5) * scale in the source.
+ * When minifying, the kernel is stretched by the scale factor so that it
+ * averages over the footprint of the destination pixel. Taps that fall
+ * outside of the source are folded onto the nearest edge pixel.
+ */
+static pixman_bool_t
+resize_axis_init (resize_axis_t *	axis,
+		  pixman_kernel_t	kernel,
+		  int			src_size,
+		  int			dst_size)
+{
+    double scale = (double)src_size / dst_size;
+    double stretch = MAX (scale, 1.0);
+    double support = _pixman_filter_kernel_width (kernel) * stretch / 2.0;
+    double *w = NULL;
+    int i;
+
+    axis->n_taps = MIN ((int)ceil (2 * support) + 1, src_size);
+    axis->box = 0;
+    axis->first = pixman_malloc_ab (dst_size, sizeof (int));
+    axis->n = pixman_malloc_ab (dst_size, sizeof (int));
+    axis->weights = pixman_malloc_ab (dst_size, axis->n_taps * sizeof (float));
+
+    if (!axis->first || !axis->n || !axis->weights)
+	goto fail;
+
+    if (!(w = pixman_malloc_ab ((int)ceil (2 * support) + 1, sizeof (double))))
+	goto fail;
+
+    if (kernel == PIXMAN_KERNEL_BOX && src_size % dst_size == 0)
+	axis->box = src_size / dst_size;
+
+    for (i = 0; i < dst_size; ++i)
+    {
+	double center = (i + 0.5) * scale;
+	float *weights = axis->weights + i * axis->n_taps;
+	double total = 0.0;
+	int j, j0, j1, first, last;
+
+	j0 = ceil (center - support - 0.5);
+	j1 = ceil (center + support - 0.5) - 1;
+
+	for (j = j0; j <= j1; ++j)
+	{
+	    w[j - j0] = _pixman_filter_kernel (
+		kernel, (j + 0.5 - center) / stretch);
+	    total += w[j - j0];
+	}
+
+	if (j1 < j0 || total == 0.0)
+	{
+	    /* IMPULSE, or a footprint that misses every tap: point sample */
+	    j0 = j1 = floor (center);
+	    w[0] = total = 1.0;
+	}
+
+	first = CLIP (j0, 0, src_size - 1);
+	last = CLIP (j1, 0, src_size - 1);
+
+	axis->first[i] = first;
+	axis->n[i] = last - first + 1;
+
+	for (j = 0; j < axis->n_taps; ++j)
+	    weights[j] = 0.0f;
+
+	for (j = j0; j <= j1; ++j)
+	    weights[CLIP (j, first, last) - first] += w[j - j0] / total;
+    }
+
+    free (w);
+
+    return TRUE;
+
+fail:
+    free (w);
+    resize_axis_fini (axis);
+
+    return FALSE;
+}
+
+static void
+resize_row (argb_t *		dst,
+	    const argb_t *	src,
+	    const resize_axis_t *axis,
+	    int			width)
+{
+    int i, j;
+
+    if (axis->box)
+    {
+	/* Integer box downscale; every pixel averages the same number
+	 * of source pixels and needs no weights.
+	 */
+	float inv = 1.0f / axis->box;
+
+	for (i = 0; i < width; ++i)
+	{
+	    argb_t s = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	    for (j = 0; j < axis->box; ++j, ++src)
+	    {
+		s.a += src->a;
+		s.r += src->r;
+		s.g += src->g;
+		s.b += src->b;
+	    }
+
+	    dst[i].a = s.a * inv;
+	    dst[i].r = s.r * inv;
+	    dst[i].g = s.g * inv;
+	    dst[i].b = s.b * inv;
+	}
+    }
+    else if (axis->n_taps == 1)
+    {
+	for (i = 0; i < width; ++i)
+	    dst[i] = src[axis->first[i]];
+    }
+    else
+    {
+	for (i = 0; i < width; ++i)
+	{
+	    const argb_t *p = src + axis->first[i];
+	    const float *w = axis->weights + i * axis->n_taps;
+	    argb_t s = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	    for (j = 0; j < axis->n[i]; ++j)
+	    {
+		s.a += w[j] * p[j].a;
+		s.r += w[j] * p[j].r;
+		s.g += w[j] * p[j].g;
+		s.b += w[j] * p[j].b;
+	    }
+
+	    dst[i] = s;
+	}
+    }
+}
+
+/* Filter one destination row from @n rows of the ring. Kernels with
+ * negative lobes can overshoot, so the result is clamped to a valid
+ * premultiplied pixel.
+ */
+static void
+resize_column (argb_t *		dst,
+	       argb_t **	rows,
+	       const float *	weights,
+	       int		n,
+	       int		width)
+{
+    int i, j;
+
+    for (i = 0; i < width; ++i)
+    {
+	argb_t s = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for (j = 0; j < n; ++j)
+	{
+	    const argb_t *p = rows[j] + i;
+
+	    s.a += weights[j] * p->a;
+	    s.r += weights[j] * p->r;
+	    s.g += weights[j] * p->g;
+	    s.b += weights[j] * p->b;
+	}
+
+	s.a = CLIP (s.a, 0.0f, 1.0f);
+	dst[i].a = s.a;
+	dst[i].r = CLIP (s.r, 0.0f, s.a);
+	dst[i].g = CLIP (s.g, 0.0f, s.a);
+	dst[i].b = CLIP (s.b, 0.0f, s.a);
+    }
+}
+
+PIXMAN_EXPORT pixman_bool_t
+pixman_image_resize (pixman_image_t *	src,
+		     pixman_image_t *	dest,
+		     pixman_kernel_t	kernel)
+{
+    resize_axis_t x_axis, y_axis;
+    int src_width, src_height, dest_width, dest_height;
+    argb_t *src_row = NULL, *ring = NULL, *dest_row = NULL;
+    argb_t **rows = NULL;
+    pixman_bool_t x_identity;
+    pixman_bool_t result = FALSE;
+    int next_row, i, j;
+
+    return_val_if_fail (src->type == BITS && dest->type == BITS, FALSE);
+    return_val_if_fail (kernel >= PIXMAN_KERNEL_IMPULSE &&
+			kernel <= PIXMAN_KERNEL_LANCZOS3_STRETCHED, FALSE);
+
+    src_width = src->bits.width;
+    src_height = src->bits.height;
+    dest_width = dest->bits.width;
+    dest_height = dest->bits.height;
+
+    if (dest_width <= 0 || dest_height <= 0)
+	return TRUE;
+
+    return_val_if_fail (src_width > 0 && src_height > 0, FALSE);
+
+    _pixman_image_validate (src);
+    _pixman_image_validate (dest);
+
+    if (!resize_axis_init (&x_axis, kernel, src_width, dest_width))
+	return FALSE;
+
+    if (!resize_axis_init (&y_axis, kernel, src_height, dest_height))
+    {
+	resize_axis_fini (&x_axis);
+	return FALSE;
+    }
+
+    /* When the widths match and every pixel has a single tap, the
+     * source rows go straight into the ring.
+     */
+    x_identity = src_width == dest_width && x_axis.n_taps == 1;
+
+    src_row = pixman_malloc_ab (src_width, sizeof (argb_t));
+    dest_row = pixman_malloc_ab (dest_width, sizeof (argb_t));
+    ring = pixman_malloc_abc (y_axis.n_taps, dest_width, sizeof (argb_t));
+    rows = pixman_malloc_ab (y_axis.n_taps, sizeof (argb_t *));
+
+    if (!src_row || !dest_row || !ring || !rows)
+	goto out;
+
+    next_row = 0;
+
+    for (i = 0; i < dest_height; ++i)
+    {
+	int first = y_axis.first[i];
+	int n = y_axis.n[i];
+
+	/* The first tap never moves backwards, so the rows that are
+	 * overwritten here are no longer needed.
+	 */
+	for (; next_row < first + n; ++next_row)
+	{
+	    argb_t *r = ring + (next_row % y_axis.n_taps) * dest_width;
+
+	    if (next_row < first)
+		continue;
+
+	    if (x_identity)
+	    {
+		src->bits.fetch_scanline_float (
+		    &src->bits, 0, next_row, src_width, (uint32_t *)r, NULL);
+	    }
+	    else
+	    {
+		src->bits.fetch_scanline_float (
+		    &src->bits, 0, next_row, src_width, (uint32_t *)src_row, NULL);
+
+		resize_row (r, src_row, &x_axis, dest_width);
+	    }
+	}
+
+	for (j = 0; j < n; ++j)
+	    rows[j] = ring + ((first + j) % y_axis.n_taps) * dest_width;
+
+	resize_column (dest_row, rows,
+		       y_axis.weights + i * y_axis.n_taps, n, dest_width);
+
+	dest->bits.store_scanline_float (
+	    &dest->bits, 0, i, dest_width, (uint32_t *)dest_row);
+    }
+
+    result = TRUE;
+
+out:
+    free (src_row);
+    free (dest_row);
+    free (ring);
+    free (rows);
+    resize_axis_fini (&x_axis);
+    resize_axis_fini (&y_axis);
+
+    return result;
+}
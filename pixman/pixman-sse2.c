@@ -35,6 +35,7 @@
 
 #include <xmmintrin.h> /* for _mm_shuffle_pi16 and _MM_SHUFFLE */
 #include <emmintrin.h> /* for SSE2 intrinsics */
+#include <math.h>
 #include "pixman-private.h"
 #include "pixman-combine32.h"
 #include "pixman-inlines.h"
@@ -2388,17 +2389,61 @@ create_mask_2x32_128 (uint32_t mask0,
 }
 #endif
 
+static force_inline void
+sse2_over_n_8888_row (uint32_t *dst,
+		      int32_t   w,
+		      __m128i   xmm_src,
+		      __m128i   xmm_alpha)
+{
+    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
+    uint32_t d;
+
+    while (w && (uintptr_t)dst & 15)
+    {
+	d = *dst;
+	*dst++ = pack_1x128_32 (over_1x128 (xmm_src,
+					    xmm_alpha,
+					    unpack_32_1x128 (d)));
+	w--;
+    }
+
+    while (w >= 4)
+    {
+	xmm_dst = load_128_aligned ((__m128i*)dst);
+
+	unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+
+	over_2x128 (&xmm_src, &xmm_src,
+		    &xmm_alpha, &xmm_alpha,
+		    &xmm_dst_lo, &xmm_dst_hi);
+
+	/* rebuid the 4 pixel data and save*/
+	save_128_aligned (
+	    (__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
+
+	w -= 4;
+	dst += 4;
+    }
+
+    while (w)
+    {
+	d = *dst;
+	*dst++ = pack_1x128_32 (over_1x128 (xmm_src,
+					    xmm_alpha,
+					    unpack_32_1x128 (d)));
+	w--;
+    }
+}
+
 static void
 sse2_composite_over_n_8888 (pixman_implementation_t *imp,
                             pixman_composite_info_t *info)
 {
     PIXMAN_COMPOSITE_ARGS (info);
     uint32_t src;
-    uint32_t    *dst_line, *dst, d;
-    int32_t w;
+    uint32_t    *dst_line;
     int dst_stride;
     __m128i xmm_src, xmm_alpha;
-    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
 
     src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
 
@@ -2413,47 +2458,45 @@ sse2_composite_over_n_8888 (pixman_implementation_t *imp,
 
     while (height--)
     {
-	dst = dst_line;
+	sse2_over_n_8888_row (dst_line, width, xmm_src, xmm_alpha);
 
 	dst_line += dst_stride;
-	w = width;
-
-	while (w && (uintptr_t)dst & 15)
-	{
-	    d = *dst;
-	    *dst++ = pack_1x128_32 (over_1x128 (xmm_src,
-						xmm_alpha,
-						unpack_32_1x128 (d)));
-	    w--;
-	}
+    }
+}
 
-	while (w >= 4)
-	{
-	    xmm_dst = load_128_aligned ((__m128i*)dst);
+static void
+sse2_composite_over_n_8888_spans (pixman_implementation_t *imp,
+				  pixman_composite_info_t *info,
+				  const pixman_box32_t *   boxes,
+				  int                      n_boxes)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+    uint32_t    *dst_line;
+    int dst_stride, i;
+    __m128i xmm_src, xmm_alpha;
 
-	    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
 
-	    over_2x128 (&xmm_src, &xmm_src,
-			&xmm_alpha, &xmm_alpha,
-			&xmm_dst_lo, &xmm_dst_hi);
+    if (src == 0)
+	return;
 
-	    /* rebuid the 4 pixel data and save*/
-	    save_128_aligned (
-		(__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, 0, dest_y, uint32_t, dst_stride, dst_line, 1);
 
-	    w -= 4;
-	    dst += 4;
-	}
+    xmm_src = expand_pixel_32_1x128 (src);
+    xmm_alpha = expand_alpha_1x128 (xmm_src);
 
-	while (w)
+    while (height--)
+    {
+	for (i = 0; i < n_boxes; i++)
 	{
-	    d = *dst;
-	    *dst++ = pack_1x128_32 (over_1x128 (xmm_src,
-						xmm_alpha,
-						unpack_32_1x128 (d)));
-	    w--;
+	    sse2_over_n_8888_row (dst_line + boxes[i].x1,
+				  boxes[i].x2 - boxes[i].x1,
+				  xmm_src, xmm_alpha);
 	}
 
+	dst_line += dst_stride;
     }
 }
 
@@ -3087,6 +3130,38 @@ sse2_composite_over_8888_8888 (pixman_implementation_t *imp,
     }
 }
 
+static void
+sse2_composite_over_8888_8888_spans (pixman_implementation_t *imp,
+				     pixman_composite_info_t *info,
+				     const pixman_box32_t *   boxes,
+				     int                      n_boxes)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride, i;
+    int src_dx = src_x - dest_x;
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, 0, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, 0, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	for (i = 0; i < n_boxes; i++)
+	{
+	    sse2_combine_over_u (imp, op,
+				 dst_line + boxes[i].x1,
+				 src_line + (boxes[i].x1 + src_dx),
+				 NULL, boxes[i].x2 - boxes[i].x1);
+	}
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
 static force_inline uint16_t
 composite_over_8888_0565pixel (uint32_t src, uint16_t dst)
 {
@@ -3099,19 +3174,87 @@ composite_over_8888_0565pixel (uint32_t src, uint16_t dst)
 		ms, expand_alpha_1x128 (ms), expand565_16_1x128 (dst))));
 }
 
+static force_inline void
+sse2_over_8888_0565_line (uint16_t *dst, const uint32_t *src, int32_t w)
+{
+    uint16_t d;
+    uint32_t s;
+
+    __m128i xmm_alpha_lo, xmm_alpha_hi;
+    __m128i xmm_src, xmm_src_lo, xmm_src_hi;
+    __m128i xmm_dst, xmm_dst0, xmm_dst1, xmm_dst2, xmm_dst3;
+
+    /* Align dst on a 16-byte boundary */
+    while (w &&
+	   ((uintptr_t)dst & 15))
+    {
+	s = *src++;
+	d = *dst;
+
+	*dst++ = composite_over_8888_0565pixel (s, d);
+	w--;
+    }
+
+    /* It's a 8 pixel loop */
+    while (w >= 8)
+    {
+	/* I'm loading unaligned because I'm not sure
+	 * about the address alignment.
+	 */
+	xmm_src = load_128_unaligned ((__m128i*) src);
+	xmm_dst = load_128_aligned ((__m128i*) dst);
+
+	/* Unpacking */
+	unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
+	unpack_565_128_4x128 (xmm_dst,
+			      &xmm_dst0, &xmm_dst1, &xmm_dst2, &xmm_dst3);
+	expand_alpha_2x128 (xmm_src_lo, xmm_src_hi,
+			    &xmm_alpha_lo, &xmm_alpha_hi);
+
+	/* I'm loading next 4 pixels from memory
+	 * before to optimze the memory read.
+	 */
+	xmm_src = load_128_unaligned ((__m128i*) (src + 4));
+
+	over_2x128 (&xmm_src_lo, &xmm_src_hi,
+		    &xmm_alpha_lo, &xmm_alpha_hi,
+		    &xmm_dst0, &xmm_dst1);
+
+	/* Unpacking */
+	unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
+	expand_alpha_2x128 (xmm_src_lo, xmm_src_hi,
+			    &xmm_alpha_lo, &xmm_alpha_hi);
+
+	over_2x128 (&xmm_src_lo, &xmm_src_hi,
+		    &xmm_alpha_lo, &xmm_alpha_hi,
+		    &xmm_dst2, &xmm_dst3);
+
+	save_128_aligned (
+	    (__m128i*)dst, pack_565_4x128_128 (
+		&xmm_dst0, &xmm_dst1, &xmm_dst2, &xmm_dst3));
+
+	w -= 8;
+	dst += 8;
+	src += 8;
+    }
+
+    while (w--)
+    {
+	s = *src++;
+	d = *dst;
+
+	*dst++ = composite_over_8888_0565pixel (s, d);
+    }
+}
+
 static void
 sse2_composite_over_8888_0565 (pixman_implementation_t *imp,
                                pixman_composite_info_t *info)
 {
     PIXMAN_COMPOSITE_ARGS (info);
-    uint16_t    *dst_line, *dst, d;
-    uint32_t    *src_line, *src, s;
+    uint16_t    *dst_line;
+    uint32_t    *src_line;
     int dst_stride, src_stride;
-    int32_t w;
-
-    __m128i xmm_alpha_lo, xmm_alpha_hi;
-    __m128i xmm_src, xmm_src_lo, xmm_src_hi;
-    __m128i xmm_dst, xmm_dst0, xmm_dst1, xmm_dst2, xmm_dst3;
 
     PIXMAN_IMAGE_GET_LINE (
 	dest_image, dest_x, dest_y, uint16_t, dst_stride, dst_line, 1);
@@ -3120,76 +3263,101 @@ sse2_composite_over_8888_0565 (pixman_implementation_t *imp,
 
     while (height--)
     {
-	dst = dst_line;
-	src = src_line;
+	sse2_over_8888_0565_line (dst_line, src_line, width);
 
 	dst_line += dst_stride;
 	src_line += src_stride;
-	w = width;
+    }
+}
+
+static force_inline void
+sse2_over_n_8_8888_row (uint32_t *      dst,
+			const uint8_t * mask,
+			int32_t         w,
+			uint32_t        srca,
+			__m128i         xmm_src,
+			__m128i         xmm_alpha,
+			__m128i         xmm_def)
+{
+    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
+    __m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
+    __m128i mmx_mask, mmx_dest;
+    uint32_t m, d;
+
+    while (w && (uintptr_t)dst & 15)
+    {
+	uint8_t m = *mask++;
 
-	/* Align dst on a 16-byte boundary */
-	while (w &&
-	       ((uintptr_t)dst & 15))
+	if (m)
 	{
-	    s = *src++;
 	    d = *dst;
+	    mmx_mask = expand_pixel_8_1x128 (m);
+	    mmx_dest = unpack_32_1x128 (d);
 
-	    *dst++ = composite_over_8888_0565pixel (s, d);
-	    w--;
+	    *dst = pack_1x128_32 (in_over_1x128 (&xmm_src,
+					       &xmm_alpha,
+					       &mmx_mask,
+					       &mmx_dest));
 	}
 
-	/* It's a 8 pixel loop */
-	while (w >= 8)
+	w--;
+	dst++;
+    }
+
+    while (w >= 4)
+    {
+	memcpy(&m, mask, sizeof(uint32_t));
+
+	if (srca == 0xff && m == 0xffffffff)
+	{
+	    save_128_aligned ((__m128i*)dst, xmm_def);
+	}
+	else if (m)
 	{
-	    /* I'm loading unaligned because I'm not sure
-	     * about the address alignment.
-	     */
-	    xmm_src = load_128_unaligned ((__m128i*) src);
 	    xmm_dst = load_128_aligned ((__m128i*) dst);
+	    xmm_mask = unpack_32_1x128 (m);
+	    xmm_mask = _mm_unpacklo_epi8 (xmm_mask, _mm_setzero_si128 ());
 
 	    /* Unpacking */
-	    unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
-	    unpack_565_128_4x128 (xmm_dst,
-				  &xmm_dst0, &xmm_dst1, &xmm_dst2, &xmm_dst3);
-	    expand_alpha_2x128 (xmm_src_lo, xmm_src_hi,
-				&xmm_alpha_lo, &xmm_alpha_hi);
-
-	    /* I'm loading next 4 pixels from memory
-	     * before to optimze the memory read.
-	     */
-	    xmm_src = load_128_unaligned ((__m128i*) (src + 4));
-
-	    over_2x128 (&xmm_src_lo, &xmm_src_hi,
-			&xmm_alpha_lo, &xmm_alpha_hi,
-			&xmm_dst0, &xmm_dst1);
+	    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+	    unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
 
-	    /* Unpacking */
-	    unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
-	    expand_alpha_2x128 (xmm_src_lo, xmm_src_hi,
-				&xmm_alpha_lo, &xmm_alpha_hi);
+	    expand_alpha_rev_2x128 (xmm_mask_lo, xmm_mask_hi,
+				    &xmm_mask_lo, &xmm_mask_hi);
 
-	    over_2x128 (&xmm_src_lo, &xmm_src_hi,
-			&xmm_alpha_lo, &xmm_alpha_hi,
-			&xmm_dst2, &xmm_dst3);
+	    in_over_2x128 (&xmm_src, &xmm_src,
+			   &xmm_alpha, &xmm_alpha,
+			   &xmm_mask_lo, &xmm_mask_hi,
+			   &xmm_dst_lo, &xmm_dst_hi);
 
 	    save_128_aligned (
-		(__m128i*)dst, pack_565_4x128_128 (
-		    &xmm_dst0, &xmm_dst1, &xmm_dst2, &xmm_dst3));
-
-	    w -= 8;
-	    dst += 8;
-	    src += 8;
+		(__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
 	}
 
-	while (w--)
+	w -= 4;
+	dst += 4;
+	mask += 4;
+    }
+
+    while (w)
+    {
+	uint8_t m = *mask++;
+
+	if (m)
 	{
-	    s = *src++;
 	    d = *dst;
+	    mmx_mask = expand_pixel_8_1x128 (m);
+	    mmx_dest = unpack_32_1x128 (d);
 
-	    *dst++ = composite_over_8888_0565pixel (s, d);
+	    *dst = pack_1x128_32 (in_over_1x128 (&xmm_src,
+					       &xmm_alpha,
+					       &mmx_mask,
+					       &mmx_dest));
 	}
-    }
 
+	w--;
+	dst++;
+    }
 }
 
 static void
@@ -3197,22 +3365,14 @@ sse2_composite_over_n_8_8888 (pixman_implementation_t *imp,
                               pixman_composite_info_t *info)
 {
     PIXMAN_COMPOSITE_ARGS (info);
-    uint32_t src, srca;
-    uint32_t *dst_line, *dst;
-    uint8_t *mask_line, *mask;
+    uint32_t src;
+    uint32_t *dst_line;
+    uint8_t *mask_line;
     int dst_stride, mask_stride;
-    int32_t w;
-    uint32_t m, d;
-
     __m128i xmm_src, xmm_alpha, xmm_def;
-    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
-    __m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
-
-    __m128i mmx_src, mmx_alpha, mmx_mask, mmx_dest;
 
     src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
 
-    srca = src >> 24;
     if (src == 0)
 	return;
 
@@ -3224,93 +3384,58 @@ sse2_composite_over_n_8_8888 (pixman_implementation_t *imp,
     xmm_def = create_mask_2x32_128 (src, src);
     xmm_src = expand_pixel_32_1x128 (src);
     xmm_alpha = expand_alpha_1x128 (xmm_src);
-    mmx_src   = xmm_src;
-    mmx_alpha = xmm_alpha;
 
     while (height--)
     {
-	dst = dst_line;
+	sse2_over_n_8_8888_row (dst_line, mask_line, width,
+				src >> 24, xmm_src, xmm_alpha, xmm_def);
+
 	dst_line += dst_stride;
-	mask = mask_line;
 	mask_line += mask_stride;
-	w = width;
+    }
+}
 
-	while (w && (uintptr_t)dst & 15)
-	{
-	    uint8_t m = *mask++;
+static void
+sse2_composite_over_n_8_8888_spans (pixman_implementation_t *imp,
+				    pixman_composite_info_t *info,
+				    const pixman_box32_t *   boxes,
+				    int                      n_boxes)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+    uint32_t *dst_line;
+    uint8_t *mask_line;
+    int dst_stride, mask_stride, i;
+    int mask_dx = mask_x - dest_x;
+    __m128i xmm_src, xmm_alpha, xmm_def;
 
-	    if (m)
-	    {
-		d = *dst;
-		mmx_mask = expand_pixel_8_1x128 (m);
-		mmx_dest = unpack_32_1x128 (d);
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
 
-		*dst = pack_1x128_32 (in_over_1x128 (&mmx_src,
-		                                   &mmx_alpha,
-		                                   &mmx_mask,
-		                                   &mmx_dest));
-	    }
+    if (src == 0)
+	return;
 
-	    w--;
-	    dst++;
-	}
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, 0, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, 0, mask_y, uint8_t, mask_stride, mask_line, 1);
 
-	while (w >= 4)
-	{
-            memcpy(&m, mask, sizeof(uint32_t));
-
-	    if (srca == 0xff && m == 0xffffffff)
-	    {
-		save_128_aligned ((__m128i*)dst, xmm_def);
-	    }
-	    else if (m)
-	    {
-		xmm_dst = load_128_aligned ((__m128i*) dst);
-		xmm_mask = unpack_32_1x128 (m);
-		xmm_mask = _mm_unpacklo_epi8 (xmm_mask, _mm_setzero_si128 ());
-
-		/* Unpacking */
-		unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
-		unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
-
-		expand_alpha_rev_2x128 (xmm_mask_lo, xmm_mask_hi,
-					&xmm_mask_lo, &xmm_mask_hi);
-
-		in_over_2x128 (&xmm_src, &xmm_src,
-			       &xmm_alpha, &xmm_alpha,
-			       &xmm_mask_lo, &xmm_mask_hi,
-			       &xmm_dst_lo, &xmm_dst_hi);
-
-		save_128_aligned (
-		    (__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
-	    }
-
-	    w -= 4;
-	    dst += 4;
-	    mask += 4;
-	}
+    xmm_def = create_mask_2x32_128 (src, src);
+    xmm_src = expand_pixel_32_1x128 (src);
+    xmm_alpha = expand_alpha_1x128 (xmm_src);
 
-	while (w)
+    while (height--)
+    {
+	for (i = 0; i < n_boxes; i++)
 	{
-	    uint8_t m = *mask++;
-
-	    if (m)
-	    {
-		d = *dst;
-		mmx_mask = expand_pixel_8_1x128 (m);
-		mmx_dest = unpack_32_1x128 (d);
-
-		*dst = pack_1x128_32 (in_over_1x128 (&mmx_src,
-		                                   &mmx_alpha,
-		                                   &mmx_mask,
-		                                   &mmx_dest));
-	    }
-
-	    w--;
-	    dst++;
+	    sse2_over_n_8_8888_row (dst_line + boxes[i].x1,
+				    mask_line + (boxes[i].x1 + mask_dx),
+				    boxes[i].x2 - boxes[i].x1,
+				    src >> 24, xmm_src, xmm_alpha, xmm_def);
 	}
-    }
 
+	dst_line += dst_stride;
+	mask_line += mask_stride;
+    }
 }
 
 #if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
@@ -3467,6 +3592,58 @@ sse2_fill (pixman_implementation_t *imp,
     return TRUE;
 }
 
+#if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+static pixman_bool_t
+sse2_add_saturate_8 (pixman_implementation_t *imp,
+                     uint8_t *                dst,
+                     int                      value,
+                     int                      width)
+{
+    uint8_t v = MIN (value, 0xff);
+    __m128i xmm_v = _mm_set1_epi8 ((char)v);
+
+    while (width && ((uintptr_t)dst & 15))
+    {
+	*dst = MIN (*dst + v, 0xff);
+	dst++;
+	width--;
+    }
+
+    while (width >= 64)
+    {
+	save_128_aligned ((__m128i*)(dst),
+			  _mm_adds_epu8 (load_128_aligned ((__m128i*)(dst)), xmm_v));
+	save_128_aligned ((__m128i*)(dst + 16),
+			  _mm_adds_epu8 (load_128_aligned ((__m128i*)(dst + 16)), xmm_v));
+	save_128_aligned ((__m128i*)(dst + 32),
+			  _mm_adds_epu8 (load_128_aligned ((__m128i*)(dst + 32)), xmm_v));
+	save_128_aligned ((__m128i*)(dst + 48),
+			  _mm_adds_epu8 (load_128_aligned ((__m128i*)(dst + 48)), xmm_v));
+
+	dst += 64;
+	width -= 64;
+    }
+
+    while (width >= 16)
+    {
+	save_128_aligned ((__m128i*)(dst),
+			  _mm_adds_epu8 (load_128_aligned ((__m128i*)(dst)), xmm_v));
+
+	dst += 16;
+	width -= 16;
+    }
+
+    while (width--)
+    {
+	*dst = MIN (*dst + v, 0xff);
+	dst++;
+    }
+
+    return TRUE;
+}
+
 static void
 sse2_composite_src_n_8_8888 (pixman_implementation_t *imp,
                              pixman_composite_info_t *info)
@@ -4824,6 +5001,37 @@ sse2_composite_copy_area (pixman_implementation_t *imp,
 	      src_x, src_y, dest_x, dest_y, width, height);
 }
 
+static void
+sse2_composite_copy_area_spans (pixman_implementation_t *imp,
+				pixman_composite_info_t *info,
+				const pixman_box32_t *   boxes,
+				int                      n_boxes)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride, i;
+    int src_dx = src_x - dest_x;
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, 0, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, 0, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	for (i = 0; i < n_boxes; i++)
+	{
+	    memcpy (dst_line + boxes[i].x1,
+		    src_line + (boxes[i].x1 + src_dx),
+		    (boxes[i].x2 - boxes[i].x1) * 4);
+	}
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
 static void
 sse2_composite_over_x888_8_8888 (pixman_implementation_t *imp,
                                  pixman_composite_info_t *info)
@@ -4949,22 +5157,109 @@ sse2_composite_over_x888_8_8888 (pixman_implementation_t *imp,
 
 }
 
-static void
-sse2_composite_over_8888_8_8888 (pixman_implementation_t *imp,
-                                 pixman_composite_info_t *info)
+static force_inline uint32_t
+composite_over_8888_8_8888pixel (uint32_t s, uint32_t m, uint32_t d)
+{
+    uint32_t sa = s >> 24;
+    __m128i ms, md, ma, msa;
+
+    if (sa == 0xff && m == 0xff)
+	return s;
+
+    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
+    ms = unpack_32_1x128 (s);
+    md = unpack_32_1x128 (d);
+
+    msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+
+    return pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
+}
+
+static force_inline void
+sse2_over_8888_8_8888_line (uint32_t       *dst,
+			    const uint32_t *src,
+			    const uint8_t  *mask,
+			    int32_t         w)
 {
-    PIXMAN_COMPOSITE_ARGS (info);
-    uint32_t    *src, *src_line, s;
-    uint32_t    *dst, *dst_line, d;
-    uint8_t         *mask, *mask_line;
     uint32_t m;
-    int src_stride, mask_stride, dst_stride;
-    int32_t w;
 
     __m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
     __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
     __m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
 
+    while (w && (uintptr_t)dst & 15)
+    {
+	m = (uint32_t) *mask++;
+
+	if (m)
+	    *dst = composite_over_8888_8_8888pixel (*src, m, *dst);
+
+	src++;
+	dst++;
+	w--;
+    }
+
+    while (w >= 4)
+    {
+	memcpy(&m, mask, sizeof(uint32_t));
+
+	if (m)
+	{
+	    xmm_src = load_128_unaligned ((__m128i*)src);
+
+	    if (m == 0xffffffff && is_opaque (xmm_src))
+	    {
+		save_128_aligned ((__m128i *)dst, xmm_src);
+	    }
+	    else
+	    {
+		xmm_dst = load_128_aligned ((__m128i *)dst);
+
+		xmm_mask = _mm_unpacklo_epi16 (unpack_32_1x128 (m), _mm_setzero_si128());
+
+		unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
+		unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
+		unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+
+		expand_alpha_2x128 (xmm_src_lo, xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi);
+		expand_alpha_rev_2x128 (xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
+
+		in_over_2x128 (&xmm_src_lo, &xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi,
+			       &xmm_mask_lo, &xmm_mask_hi, &xmm_dst_lo, &xmm_dst_hi);
+
+		save_128_aligned ((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
+	    }
+	}
+
+	src += 4;
+	dst += 4;
+	mask += 4;
+	w -= 4;
+    }
+
+    while (w)
+    {
+	m = (uint32_t) *mask++;
+
+	if (m)
+	    *dst = composite_over_8888_8_8888pixel (*src, m, *dst);
+
+	src++;
+	dst++;
+	w--;
+    }
+}
+
+static void
+sse2_composite_over_8888_8_8888 (pixman_implementation_t *imp,
+                                 pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *src_line;
+    uint32_t    *dst_line;
+    uint8_t     *mask_line;
+    int src_stride, mask_stride, dst_stride;
+
     PIXMAN_IMAGE_GET_LINE (
 	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
     PIXMAN_IMAGE_GET_LINE (
@@ -4974,122 +5269,221 @@ sse2_composite_over_8888_8_8888 (pixman_implementation_t *imp,
 
     while (height--)
     {
-        src = src_line;
-        src_line += src_stride;
-        dst = dst_line;
-        dst_line += dst_stride;
-        mask = mask_line;
-        mask_line += mask_stride;
+	sse2_over_8888_8_8888_line (dst_line, src_line, mask_line, width);
 
-        w = width;
+	src_line += src_stride;
+	dst_line += dst_stride;
+	mask_line += mask_stride;
+    }
+}
 
-        while (w && (uintptr_t)dst & 15)
-        {
-	    uint32_t sa;
+static force_inline uint16_t
+composite_over_8888_8_0565pixel (uint32_t s, uint32_t m, uint16_t d)
+{
+    __m128i ms, md, ma, msa;
 
-            s = *src++;
-            m = (uint32_t) *mask++;
-            d = *dst;
+    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
+    ms = unpack_32_1x128 (s);
+    md = expand565_16_1x128 (d);
 
-	    sa = s >> 24;
+    msa = expand_alpha_1x128 (ms);
 
-	    if (m)
-	    {
-		if (sa == 0xff && m == 0xff)
-		{
-		    *dst = s;
-		}
-		else
-		{
-		    __m128i ms, md, ma, msa;
+    return pack_565_32_16 (pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md)));
+}
 
-		    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
-		    ms = unpack_32_1x128 (s);
-		    md = unpack_32_1x128 (d);
+static force_inline void
+sse2_over_8888_8_0565_quad (const uint32_t *src,
+			    uint32_t        m,
+			    __m128i        *xmm_dst_lo,
+			    __m128i        *xmm_dst_hi)
+{
+    __m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
+    __m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
 
-		    msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+    xmm_src = load_128_unaligned ((__m128i*)src);
+    xmm_mask = _mm_unpacklo_epi16 (unpack_32_1x128 (m), _mm_setzero_si128());
 
-		    *dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
-		}
-	    }
+    unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
+    unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
 
-	    dst++;
-            w--;
-        }
+    expand_alpha_2x128 (xmm_src_lo, xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi);
+    expand_alpha_rev_2x128 (xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
 
-        while (w >= 4)
-        {
-            memcpy(&m, mask, sizeof(uint32_t));
+    in_over_2x128 (&xmm_src_lo, &xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi,
+		   &xmm_mask_lo, &xmm_mask_hi, xmm_dst_lo, xmm_dst_hi);
+}
 
-	    if (m)
-	    {
-		xmm_src = load_128_unaligned ((__m128i*)src);
+static force_inline void
+sse2_over_8888_8_0565_line (uint16_t       *dst,
+			    const uint32_t *src,
+			    const uint8_t  *mask,
+			    int32_t         w)
+{
+    uint32_t m;
 
-		if (m == 0xffffffff && is_opaque (xmm_src))
-		{
-		    save_128_aligned ((__m128i *)dst, xmm_src);
-		}
-		else
-		{
-		    xmm_dst = load_128_aligned ((__m128i *)dst);
+    __m128i xmm_dst, xmm_dst0, xmm_dst1, xmm_dst2, xmm_dst3;
 
-		    xmm_mask = _mm_unpacklo_epi16 (unpack_32_1x128 (m), _mm_setzero_si128());
+    while (w && (uintptr_t)dst & 15)
+    {
+	m = (uint32_t) *mask++;
 
-		    unpack_128_2x128 (xmm_src, &xmm_src_lo, &xmm_src_hi);
-		    unpack_128_2x128 (xmm_mask, &xmm_mask_lo, &xmm_mask_hi);
-		    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+	if (m)
+	    *dst = composite_over_8888_8_0565pixel (*src, m, *dst);
 
-		    expand_alpha_2x128 (xmm_src_lo, xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi);
-		    expand_alpha_rev_2x128 (xmm_mask_lo, xmm_mask_hi, &xmm_mask_lo, &xmm_mask_hi);
+	src++;
+	dst++;
+	w--;
+    }
 
-		    in_over_2x128 (&xmm_src_lo, &xmm_src_hi, &xmm_srca_lo, &xmm_srca_hi,
-				   &xmm_mask_lo, &xmm_mask_hi, &xmm_dst_lo, &xmm_dst_hi);
+    while (w >= 8)
+    {
+	xmm_dst = load_128_aligned ((__m128i*) dst);
+	unpack_565_128_4x128 (xmm_dst,
+			      &xmm_dst0, &xmm_dst1, &xmm_dst2, &xmm_dst3);
 
-		    save_128_aligned ((__m128i*)dst, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi));
-		}
-	    }
+	memcpy(&m, mask, sizeof(uint32_t));
+	if (m)
+	    sse2_over_8888_8_0565_quad (src, m, &xmm_dst0, &xmm_dst1);
 
-            src += 4;
-            dst += 4;
-            mask += 4;
-            w -= 4;
-        }
+	memcpy(&m, mask + 4, sizeof(uint32_t));
+	if (m)
+	    sse2_over_8888_8_0565_quad (src + 4, m, &xmm_dst2, &xmm_dst3);
 
-        while (w)
-        {
-	    uint32_t sa;
+	save_128_aligned (
+	    (__m128i*)dst, pack_565_4x128_128 (
+		&xmm_dst0, &xmm_dst1, &xmm_dst2, &xmm_dst3));
 
-            s = *src++;
-            m = (uint32_t) *mask++;
-            d = *dst;
+	src += 8;
+	dst += 8;
+	mask += 8;
+	w -= 8;
+    }
 
-	    sa = s >> 24;
+    while (w)
+    {
+	m = (uint32_t) *mask++;
 
-	    if (m)
-	    {
-		if (sa == 0xff && m == 0xff)
-		{
-		    *dst = s;
-		}
-		else
-		{
-		    __m128i ms, md, ma, msa;
+	if (m)
+	    *dst = composite_over_8888_8_0565pixel (*src, m, *dst);
 
-		    ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
-		    ms = unpack_32_1x128 (s);
-		    md = unpack_32_1x128 (d);
+	src++;
+	dst++;
+	w--;
+    }
+}
 
-		    msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+/* Gradients composited straight into the destination
+ *
+ * The gradient iterator generates one row at a time into a buffer that
+ * stays in the cache, and the row is composited into the destination
+ * right away, instead of going through general_composite_rect() with
+ * its separate mask and destination iterators.
+ */
+#define GRADIENT_STACK_LENGTH		2048
 
-		    *dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
-		}
-	    }
+static force_inline void
+sse2_composite_over_gradient (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info,
+			      pixman_bool_t            dest_0565,
+			      pixman_bool_t            with_mask)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t stack_buffer[GRADIENT_STACK_LENGTH];
+    uint32_t *buffer = stack_buffer;
+    uint32_t *dst32_line = NULL;
+    uint16_t *dst16_line = NULL;
+    uint8_t *mask_line = NULL;
+    int dst_stride, mask_stride = 0;
+    pixman_iter_t src_iter;
 
-	    dst++;
-            w--;
-        }
+    if (width > GRADIENT_STACK_LENGTH)
+    {
+	buffer = pixman_malloc_ab (width, sizeof (uint32_t));
+	if (!buffer)
+	    return;
+    }
+
+    if (dest_0565)
+    {
+	PIXMAN_IMAGE_GET_LINE (
+	    dest_image, dest_x, dest_y, uint16_t, dst_stride, dst16_line, 1);
+    }
+    else
+    {
+	PIXMAN_IMAGE_GET_LINE (
+	    dest_image, dest_x, dest_y, uint32_t, dst_stride, dst32_line, 1);
+    }
+
+    if (with_mask)
+    {
+	PIXMAN_IMAGE_GET_LINE (
+	    mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+    }
+
+    _pixman_implementation_iter_init (imp->toplevel, &src_iter, src_image,
+				      src_x, src_y, width, height,
+				      (uint8_t *)buffer, ITER_NARROW | ITER_SRC,
+				      info->src_flags);
+
+    while (height--)
+    {
+	uint32_t *src = src_iter.get_scanline (&src_iter, NULL);
+
+	if (dest_0565)
+	{
+	    if (with_mask)
+		sse2_over_8888_8_0565_line (dst16_line, src, mask_line, width);
+	    else
+		sse2_over_8888_0565_line (dst16_line, src, width);
+
+	    dst16_line += dst_stride;
+	}
+	else
+	{
+	    if (with_mask)
+		sse2_over_8888_8_8888_line (dst32_line, src, mask_line, width);
+	    else
+		core_combine_over_u_sse2_no_mask (dst32_line, src, width);
+
+	    dst32_line += dst_stride;
+	}
+
+	mask_line += mask_stride;
     }
 
+    if (src_iter.fini)
+	src_iter.fini (&src_iter);
+
+    if (buffer != stack_buffer)
+	free (buffer);
+}
+
+static void
+sse2_composite_over_gradient_8888 (pixman_implementation_t *imp,
+				   pixman_composite_info_t *info)
+{
+    sse2_composite_over_gradient (imp, info, FALSE, FALSE);
+}
+
+static void
+sse2_composite_over_gradient_0565 (pixman_implementation_t *imp,
+				   pixman_composite_info_t *info)
+{
+    sse2_composite_over_gradient (imp, info, TRUE, FALSE);
+}
+
+static void
+sse2_composite_over_gradient_8_8888 (pixman_implementation_t *imp,
+				     pixman_composite_info_t *info)
+{
+    sse2_composite_over_gradient (imp, info, FALSE, TRUE);
+}
+
+static void
+sse2_composite_over_gradient_8_0565 (pixman_implementation_t *imp,
+				     pixman_composite_info_t *info)
+{
+    sse2_composite_over_gradient (imp, info, TRUE, TRUE);
 }
 
 static void
@@ -6181,25 +6575,48 @@ FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_normal_OVER,
 			       uint32_t, uint32_t, uint32_t,
 			       NORMAL, FLAG_HAVE_SOLID_MASK)
 
+#define GRADIENT_FAST_PATHS(src)					\
+    { FAST_PATH (OVER, src, FAST_PATH_NO_ALPHA_MAP, null, 0,		\
+		 a8r8g8b8, FAST_PATH_STD_DEST_FLAGS,			\
+		 sse2_composite_over_gradient_8888) },			\
+    { FAST_PATH (OVER, src, FAST_PATH_NO_ALPHA_MAP, null, 0,		\
+		 x8r8g8b8, FAST_PATH_STD_DEST_FLAGS,			\
+		 sse2_composite_over_gradient_8888) },			\
+    { FAST_PATH (OVER, src, FAST_PATH_NO_ALPHA_MAP, null, 0,		\
+		 r5g6b5, FAST_PATH_STD_DEST_FLAGS,			\
+		 sse2_composite_over_gradient_0565) },			\
+    { FAST_PATH (OVER, src, FAST_PATH_NO_ALPHA_MAP,			\
+		 a8, MASK_FLAGS (a8, FAST_PATH_UNIFIED_ALPHA),		\
+		 a8r8g8b8, FAST_PATH_STD_DEST_FLAGS,			\
+		 sse2_composite_over_gradient_8_8888) },		\
+    { FAST_PATH (OVER, src, FAST_PATH_NO_ALPHA_MAP,			\
+		 a8, MASK_FLAGS (a8, FAST_PATH_UNIFIED_ALPHA),		\
+		 x8r8g8b8, FAST_PATH_STD_DEST_FLAGS,			\
+		 sse2_composite_over_gradient_8_8888) },		\
+    { FAST_PATH (OVER, src, FAST_PATH_NO_ALPHA_MAP,			\
+		 a8, MASK_FLAGS (a8, FAST_PATH_UNIFIED_ALPHA),		\
+		 r5g6b5, FAST_PATH_STD_DEST_FLAGS,			\
+		 sse2_composite_over_gradient_8_0565) }
+
 static const pixman_fast_path_t sse2_fast_paths[] =
 {
     /* PIXMAN_OP_OVER */
     PIXMAN_STD_FAST_PATH (OVER, solid, a8, r5g6b5, sse2_composite_over_n_8_0565),
     PIXMAN_STD_FAST_PATH (OVER, solid, a8, b5g6r5, sse2_composite_over_n_8_0565),
-    PIXMAN_STD_FAST_PATH (OVER, solid, null, a8r8g8b8, sse2_composite_over_n_8888),
-    PIXMAN_STD_FAST_PATH (OVER, solid, null, x8r8g8b8, sse2_composite_over_n_8888),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, null, a8r8g8b8, sse2_composite_over_n_8888, sse2_composite_over_n_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, null, x8r8g8b8, sse2_composite_over_n_8888, sse2_composite_over_n_8888_spans),
     PIXMAN_STD_FAST_PATH (OVER, solid, null, r5g6b5, sse2_composite_over_n_0565),
     PIXMAN_STD_FAST_PATH (OVER, solid, null, b5g6r5, sse2_composite_over_n_0565),
-    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, a8r8g8b8, sse2_composite_over_8888_8888),
-    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, x8r8g8b8, sse2_composite_over_8888_8888),
-    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, a8b8g8r8, sse2_composite_over_8888_8888),
-    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, x8b8g8r8, sse2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, a8r8g8b8, null, a8r8g8b8, sse2_composite_over_8888_8888, sse2_composite_over_8888_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, a8r8g8b8, null, x8r8g8b8, sse2_composite_over_8888_8888, sse2_composite_over_8888_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, a8b8g8r8, null, a8b8g8r8, sse2_composite_over_8888_8888, sse2_composite_over_8888_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, a8b8g8r8, null, x8b8g8r8, sse2_composite_over_8888_8888, sse2_composite_over_8888_8888_spans),
     PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, r5g6b5, sse2_composite_over_8888_0565),
     PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, b5g6r5, sse2_composite_over_8888_0565),
-    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8r8g8b8, sse2_composite_over_n_8_8888),
-    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8r8g8b8, sse2_composite_over_n_8_8888),
-    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8b8g8r8, sse2_composite_over_n_8_8888),
-    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8b8g8r8, sse2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, a8, a8r8g8b8, sse2_composite_over_n_8_8888, sse2_composite_over_n_8_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, a8, x8r8g8b8, sse2_composite_over_n_8_8888, sse2_composite_over_n_8_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, a8, a8b8g8r8, sse2_composite_over_n_8_8888, sse2_composite_over_n_8_8888_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, solid, a8, x8b8g8r8, sse2_composite_over_n_8_8888, sse2_composite_over_n_8_8888_spans),
     PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, a8r8g8b8, sse2_composite_over_8888_8888_8888),
     PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, a8, x8r8g8b8, sse2_composite_over_8888_8_8888),
     PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, a8, a8r8g8b8, sse2_composite_over_8888_8_8888),
@@ -6229,8 +6646,10 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     PIXMAN_STD_FAST_PATH (OVER, rpixbuf, rpixbuf, x8b8g8r8, sse2_composite_over_pixbuf_8888),
     PIXMAN_STD_FAST_PATH (OVER, pixbuf, pixbuf, r5g6b5, sse2_composite_over_pixbuf_0565),
     PIXMAN_STD_FAST_PATH (OVER, rpixbuf, rpixbuf, b5g6r5, sse2_composite_over_pixbuf_0565),
-    PIXMAN_STD_FAST_PATH (OVER, x8r8g8b8, null, x8r8g8b8, sse2_composite_copy_area),
-    PIXMAN_STD_FAST_PATH (OVER, x8b8g8r8, null, x8b8g8r8, sse2_composite_copy_area),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, x8r8g8b8, null, x8r8g8b8, sse2_composite_copy_area, sse2_composite_copy_area_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (OVER, x8b8g8r8, null, x8b8g8r8, sse2_composite_copy_area, sse2_composite_copy_area_spans),
+    GRADIENT_FAST_PATHS (linear_gradient),
+    GRADIENT_FAST_PATHS (radial_gradient),
     
     /* PIXMAN_OP_OVER_REVERSE */
     PIXMAN_STD_FAST_PATH (OVER_REVERSE, solid, null, a8r8g8b8, sse2_composite_over_reverse_n_8888),
@@ -6263,12 +6682,12 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, b5g6r5, sse2_composite_src_x888_0565),
     PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, a8r8g8b8, sse2_composite_src_x888_8888),
     PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, a8b8g8r8, sse2_composite_src_x888_8888),
-    PIXMAN_STD_FAST_PATH (SRC, a8r8g8b8, null, a8r8g8b8, sse2_composite_copy_area),
-    PIXMAN_STD_FAST_PATH (SRC, a8b8g8r8, null, a8b8g8r8, sse2_composite_copy_area),
-    PIXMAN_STD_FAST_PATH (SRC, a8r8g8b8, null, x8r8g8b8, sse2_composite_copy_area),
-    PIXMAN_STD_FAST_PATH (SRC, a8b8g8r8, null, x8b8g8r8, sse2_composite_copy_area),
-    PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, x8r8g8b8, sse2_composite_copy_area),
-    PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, x8b8g8r8, sse2_composite_copy_area),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a8r8g8b8, null, a8r8g8b8, sse2_composite_copy_area, sse2_composite_copy_area_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a8b8g8r8, null, a8b8g8r8, sse2_composite_copy_area, sse2_composite_copy_area_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a8r8g8b8, null, x8r8g8b8, sse2_composite_copy_area, sse2_composite_copy_area_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, a8b8g8r8, null, x8b8g8r8, sse2_composite_copy_area, sse2_composite_copy_area_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, x8r8g8b8, null, x8r8g8b8, sse2_composite_copy_area, sse2_composite_copy_area_spans),
+    PIXMAN_STD_FAST_PATH_SPANS (SRC, x8b8g8r8, null, x8b8g8r8, sse2_composite_copy_area, sse2_composite_copy_area_spans),
     PIXMAN_STD_FAST_PATH (SRC, r5g6b5, null, r5g6b5, sse2_composite_copy_area),
     PIXMAN_STD_FAST_PATH (SRC, b5g6r5, null, b5g6r5, sse2_composite_copy_area),
 
@@ -6447,12 +6866,921 @@ sse2_fetch_a8 (pixman_iter_t *iter, const uint32_t *mask)
     return iter->buffer;
 }
 
+/* Bilinear affine fetchers
+ *
+ * The source coordinates of four destination pixels are generated at a
+ * time in SSE2 registers, along with their integer parts and bilinear
+ * weights. PAD repeat is applied in the registers as well, and so is
+ * NORMAL repeat for images that are small enough, see below. The other
+ * repeat modes need a division or a bounds check and are applied per
+ * texel. The texels are then gathered and four pixels are interpolated
+ * before they are stored together.
+ */
+
+/* NORMAL repeat coordinates are kept wrapped into [0, size) in 16.16
+ * fixed point. The start and the step are reduced once per scanline, so
+ * a single conditional subtraction per step keeps them in range, and the
+ * tiled texels are gathered without repeat () walking back from far away
+ * coordinates. The sum of two wrapped coordinates must fit in 31 bits,
+ * which limits this to images smaller than AFFINE_WRAP_LIMIT.
+ */
+#define AFFINE_WRAP_LIMIT	0x4000
+
+static force_inline void
+wrap_init_epi32 (__m128i *		xmm_c,
+		 __m128i *		xmm_step,
+		 pixman_fixed_t		c,
+		 pixman_fixed_t		u,
+		 int			size)
+{
+    int64_t s = (int64_t)size << 16;
+
+    *xmm_c = _mm_set_epi32 (MOD (c + 3 * (int64_t)u, s),
+			    MOD (c + 2 * (int64_t)u, s),
+			    MOD (c + (int64_t)u, s),
+			    MOD ((int64_t)c, s));
+    *xmm_step = _mm_set1_epi32 (MOD (4 * (int64_t)u, s));
+}
+
+static force_inline __m128i
+wrap_step_epi32 (__m128i v, __m128i step, __m128i size_fixed)
+{
+    v = _mm_add_epi32 (v, step);
+
+    return _mm_sub_epi32 (
+	v, _mm_andnot_si128 (_mm_cmpgt_epi32 (size_fixed, v), size_fixed));
+}
+
+/* The integer coordinate after a wrapped one */
+static force_inline __m128i
+wrap_next_epi32 (__m128i v, __m128i size)
+{
+    v = _mm_add_epi32 (v, _mm_set1_epi32 (1));
+
+    return _mm_andnot_si128 (_mm_cmpeq_epi32 (v, size), v);
+}
+static force_inline __m128i
+clamp_epi32 (__m128i v, __m128i lo, __m128i hi)
+{
+    __m128i m;
+
+    m = _mm_cmplt_epi32 (v, lo);
+    v = _mm_or_si128 (_mm_and_si128 (m, lo), _mm_andnot_si128 (m, v));
+    m = _mm_cmpgt_epi32 (v, hi);
+    v = _mm_or_si128 (_mm_and_si128 (m, hi), _mm_andnot_si128 (m, v));
+
+    return v;
+}
+
+static force_inline uint32_t
+fetch_texel (bits_image_t *		bits,
+	     int			x,
+	     int			y,
+	     convert_pixel_t		convert_pixel,
+	     pixman_format_code_t	format,
+	     pixman_repeat_t		repeat_mode)
+{
+    const uint8_t *row;
+
+    if (repeat_mode == PIXMAN_REPEAT_NONE)
+    {
+	if (x < 0 || x >= bits->width || y < 0 || y >= bits->height)
+	    return 0;
+    }
+    else if (repeat_mode != PIXMAN_REPEAT_PAD)
+    {
+	repeat (repeat_mode, &x, bits->width);
+	repeat (repeat_mode, &y, bits->height);
+    }
+
+    row = (uint8_t *)bits->bits + bits->rowstride * 4 * y;
+
+    return convert_pixel (row, x) | (PIXMAN_FORMAT_A (format)? 0 : 0xff000000);
+}
+
+/* Interpolate one pixel into the four 32 bit lanes of the result */
+static force_inline __m128i
+bilinear_interpolate_1x128 (uint32_t tl, uint32_t tr,
+			    uint32_t bl, uint32_t br,
+			    int distx, int disty)
+{
+    __m128i xmm_zero = _mm_setzero_si128 ();
+    __m128i xmm_wt = _mm_set1_epi16 (BILINEAR_INTERPOLATION_RANGE - disty);
+    __m128i xmm_wb = _mm_set1_epi16 (disty);
+    __m128i xmm_wh = _mm_set1_epi32 (
+	(distx << 16) | (BILINEAR_INTERPOLATION_RANGE - distx));
+    __m128i tltr, blbr, xmm_a;
+
+    tltr = _mm_unpacklo_epi8 (
+	_mm_unpacklo_epi32 (_mm_cvtsi32_si128 (tl), _mm_cvtsi32_si128 (tr)),
+	xmm_zero);
+    blbr = _mm_unpacklo_epi8 (
+	_mm_unpacklo_epi32 (_mm_cvtsi32_si128 (bl), _mm_cvtsi32_si128 (br)),
+	xmm_zero);
+
+    /* vertical interpolation */
+    xmm_a = _mm_add_epi16 (_mm_mullo_epi16 (tltr, xmm_wt),
+			   _mm_mullo_epi16 (blbr, xmm_wb));
+
+    /* horizontal interpolation */
+    xmm_a = _mm_madd_epi16 (
+	_mm_unpacklo_epi16 (xmm_a, _mm_unpackhi_epi64 (xmm_a, xmm_a)), xmm_wh);
+
+    return _mm_srli_epi32 (xmm_a, BILINEAR_INTERPOLATION_BITS * 2);
+}
+
+static force_inline void
+sse2_fetch_bilinear_affine (pixman_image_t *		image,
+			    int				offset,
+			    int				line,
+			    int				width,
+			    uint32_t *			buffer,
+
+			    convert_pixel_t		convert_pixel,
+			    pixman_format_code_t	format,
+			    pixman_repeat_t		repeat_mode)
+{
+    bits_image_t *bits = &image->bits;
+    pixman_fixed_t ux, uy;
+    pixman_vector_t v;
+    __m128i xmm_x, xmm_y, xmm_ux4, xmm_uy4;
+    __m128i xmm_wmask, xmm_zero, xmm_one, xmm_minus_one, xmm_w1, xmm_h1;
+    __m128i xmm_w, xmm_h, xmm_wf, xmm_hf;
+    int32_t x1[4], y1[4], x2[4], y2[4], wx[4], wy[4];
+    pixman_repeat_t texel_repeat = repeat_mode;
+    int i, k;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (offset) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (line) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	return;
+
+    ux = image->common.transform->matrix[0][0];
+    uy = image->common.transform->matrix[1][0];
+
+    v.vector[0] -= pixman_fixed_1 / 2;
+    v.vector[1] -= pixman_fixed_1 / 2;
+
+    if (repeat_mode == PIXMAN_REPEAT_NONE)
+    {
+	/* The coordinates are linear along the scanline, so the ends
+	 * tell whether it misses the image altogether.
+	 */
+	int64_t xs = v.vector[0], xe = xs + (int64_t)ux * (width - 1);
+	int64_t ys = v.vector[1], ye = ys + (int64_t)uy * (width - 1);
+
+	if (MAX (xs, xe) < -pixman_fixed_1			||
+	    MIN (xs, xe) >= pixman_int_to_fixed (bits->width)	||
+	    MAX (ys, ye) < -pixman_fixed_1			||
+	    MIN (ys, ye) >= pixman_int_to_fixed (bits->height))
+	{
+	    memset (buffer, 0, width * sizeof (uint32_t));
+	    return;
+	}
+    }
+
+    if (repeat_mode == PIXMAN_REPEAT_NORMAL &&
+	bits->width < AFFINE_WRAP_LIMIT && bits->height < AFFINE_WRAP_LIMIT)
+    {
+	wrap_init_epi32 (&xmm_x, &xmm_ux4, v.vector[0], ux, bits->width);
+	wrap_init_epi32 (&xmm_y, &xmm_uy4, v.vector[1], uy, bits->height);
+
+	texel_repeat = PIXMAN_REPEAT_PAD;
+    }
+    else
+    {
+	/* The lanes wrap around like the scalar walk does; multiply
+	 * unsigned so that large steps are not undefined behaviour.
+	 */
+	xmm_x = _mm_add_epi32 (_mm_set1_epi32 (v.vector[0]),
+			       _mm_set_epi32 (3 * (uint32_t)ux, 2 * (uint32_t)ux,
+					      ux, 0));
+	xmm_y = _mm_add_epi32 (_mm_set1_epi32 (v.vector[1]),
+			       _mm_set_epi32 (3 * (uint32_t)uy, 2 * (uint32_t)uy,
+					      uy, 0));
+	xmm_ux4 = _mm_set1_epi32 (4 * (uint32_t)ux);
+	xmm_uy4 = _mm_set1_epi32 (4 * (uint32_t)uy);
+    }
+
+    xmm_wmask = _mm_set1_epi32 (BILINEAR_INTERPOLATION_RANGE - 1);
+    xmm_zero = _mm_setzero_si128 ();
+    xmm_one = _mm_set1_epi32 (1);
+    xmm_minus_one = _mm_set1_epi32 (-1);
+    xmm_w1 = _mm_set1_epi32 (bits->width - 1);
+    xmm_h1 = _mm_set1_epi32 (bits->height - 1);
+    xmm_w = _mm_set1_epi32 (bits->width);
+    xmm_h = _mm_set1_epi32 (bits->height);
+    xmm_wf = _mm_slli_epi32 (xmm_w, 16);
+    xmm_hf = _mm_slli_epi32 (xmm_h, 16);
+
+    for (i = 0; i < width; i += 4)
+    {
+	__m128i xmm_x1 = _mm_srai_epi32 (xmm_x, 16);
+	__m128i xmm_y1 = _mm_srai_epi32 (xmm_y, 16);
+	__m128i xmm_x2 = _mm_add_epi32 (xmm_x1, xmm_one);
+	__m128i xmm_y2 = _mm_add_epi32 (xmm_y1, xmm_one);
+	__m128i xmm_pix[4];
+	int n = MIN (width - i, 4);
+
+	if (repeat_mode == PIXMAN_REPEAT_PAD)
+	{
+	    xmm_x1 = clamp_epi32 (xmm_x1, xmm_zero, xmm_w1);
+	    xmm_x2 = clamp_epi32 (xmm_x2, xmm_zero, xmm_w1);
+	    xmm_y1 = clamp_epi32 (xmm_y1, xmm_zero, xmm_h1);
+	    xmm_y2 = clamp_epi32 (xmm_y2, xmm_zero, xmm_h1);
+	}
+	else if (texel_repeat != repeat_mode)
+	{
+	    xmm_x2 = wrap_next_epi32 (xmm_x1, xmm_w);
+	    xmm_y2 = wrap_next_epi32 (xmm_y1, xmm_h);
+	}
+	else if (repeat_mode == PIXMAN_REPEAT_NONE && n == 4)
+	{
+	    /* Skip four pixels at once when none of their texels is
+	     * inside the image, as in the borders around a scaled or
+	     * rotated picture.
+	     */
+	    __m128i xmm_in = _mm_and_si128 (
+		_mm_and_si128 (_mm_cmpgt_epi32 (xmm_x2, xmm_minus_one),
+			       _mm_cmpgt_epi32 (xmm_w, xmm_x1)),
+		_mm_and_si128 (_mm_cmpgt_epi32 (xmm_y2, xmm_minus_one),
+			       _mm_cmpgt_epi32 (xmm_h, xmm_y1)));
+
+	    if (!_mm_movemask_epi8 (xmm_in))
+	    {
+		_mm_storeu_si128 ((__m128i *)(buffer + i), xmm_zero);
+		goto next;
+	    }
+	}
+
+	_mm_storeu_si128 ((__m128i *)x1, xmm_x1);
+	_mm_storeu_si128 ((__m128i *)y1, xmm_y1);
+	_mm_storeu_si128 ((__m128i *)x2, xmm_x2);
+	_mm_storeu_si128 ((__m128i *)y2, xmm_y2);
+	_mm_storeu_si128 ((__m128i *)wx, _mm_and_si128 (
+			      _mm_srli_epi32 (xmm_x, 16 - BILINEAR_INTERPOLATION_BITS),
+			      xmm_wmask));
+	_mm_storeu_si128 ((__m128i *)wy, _mm_and_si128 (
+			      _mm_srli_epi32 (xmm_y, 16 - BILINEAR_INTERPOLATION_BITS),
+			      xmm_wmask));
+
+	for (k = 0; k < n; ++k)
+	{
+	    uint32_t tl, tr, bl, br;
+
+	    tl = fetch_texel (bits, x1[k], y1[k],
+			      convert_pixel, format, texel_repeat);
+	    tr = fetch_texel (bits, x2[k], y1[k],
+			      convert_pixel, format, texel_repeat);
+	    bl = fetch_texel (bits, x1[k], y2[k],
+			      convert_pixel, format, texel_repeat);
+	    br = fetch_texel (bits, x2[k], y2[k],
+			      convert_pixel, format, texel_repeat);
+
+	    xmm_pix[k] = bilinear_interpolate_1x128 (
+		tl, tr, bl, br, wx[k], wy[k]);
+	}
+
+	if (n == 4)
+	{
+	    _mm_storeu_si128 ((__m128i *)(buffer + i), _mm_packus_epi16 (
+				  _mm_packs_epi32 (xmm_pix[0], xmm_pix[1]),
+				  _mm_packs_epi32 (xmm_pix[2], xmm_pix[3])));
+	}
+	else
+	{
+	    for (k = 0; k < n; ++k)
+	    {
+		__m128i xmm_p = _mm_packs_epi32 (xmm_pix[k], xmm_pix[k]);
+
+		buffer[i + k] = _mm_cvtsi128_si32 (_mm_packus_epi16 (xmm_p, xmm_p));
+	    }
+	}
+
+    next:
+	if (texel_repeat != repeat_mode)
+	{
+	    xmm_x = wrap_step_epi32 (xmm_x, xmm_ux4, xmm_wf);
+	    xmm_y = wrap_step_epi32 (xmm_y, xmm_uy4, xmm_hf);
+	}
+	else
+	{
+	    xmm_x = _mm_add_epi32 (xmm_x, xmm_ux4);
+	    xmm_y = _mm_add_epi32 (xmm_y, xmm_uy4);
+	}
+    }
+}
+
+#define MAKE_AFFINE_FETCHER(name, format, repeat_mode)			\
+    static uint32_t *							\
+    sse2_fetch_bilinear_affine_ ## name (pixman_iter_t   *iter,		\
+					 const uint32_t * mask)		\
+    {									\
+	sse2_fetch_bilinear_affine (iter->image,			\
+				    iter->x, iter->y++,			\
+				    iter->width, iter->buffer,		\
+				    convert_ ## format,			\
+				    PIXMAN_ ## format,			\
+				    repeat_mode);			\
+	return iter->buffer;						\
+    }
+
+MAKE_AFFINE_FETCHER (pad_a8r8g8b8,     a8r8g8b8, PIXMAN_REPEAT_PAD)
+MAKE_AFFINE_FETCHER (none_a8r8g8b8,    a8r8g8b8, PIXMAN_REPEAT_NONE)
+MAKE_AFFINE_FETCHER (reflect_a8r8g8b8, a8r8g8b8, PIXMAN_REPEAT_REFLECT)
+MAKE_AFFINE_FETCHER (normal_a8r8g8b8,  a8r8g8b8, PIXMAN_REPEAT_NORMAL)
+MAKE_AFFINE_FETCHER (pad_x8r8g8b8,     x8r8g8b8, PIXMAN_REPEAT_PAD)
+MAKE_AFFINE_FETCHER (none_x8r8g8b8,    x8r8g8b8, PIXMAN_REPEAT_NONE)
+MAKE_AFFINE_FETCHER (reflect_x8r8g8b8, x8r8g8b8, PIXMAN_REPEAT_REFLECT)
+MAKE_AFFINE_FETCHER (normal_x8r8g8b8,  x8r8g8b8, PIXMAN_REPEAT_NORMAL)
+MAKE_AFFINE_FETCHER (pad_a8,           a8,       PIXMAN_REPEAT_PAD)
+MAKE_AFFINE_FETCHER (none_a8,          a8,       PIXMAN_REPEAT_NONE)
+MAKE_AFFINE_FETCHER (reflect_a8,       a8,       PIXMAN_REPEAT_REFLECT)
+MAKE_AFFINE_FETCHER (normal_a8,        a8,       PIXMAN_REPEAT_NORMAL)
+MAKE_AFFINE_FETCHER (pad_r5g6b5,       r5g6b5,   PIXMAN_REPEAT_PAD)
+MAKE_AFFINE_FETCHER (none_r5g6b5,      r5g6b5,   PIXMAN_REPEAT_NONE)
+MAKE_AFFINE_FETCHER (reflect_r5g6b5,   r5g6b5,   PIXMAN_REPEAT_REFLECT)
+MAKE_AFFINE_FETCHER (normal_r5g6b5,    r5g6b5,   PIXMAN_REPEAT_NORMAL)
+
+/* Gradients
+ *
+ * The gradient iterators compute the parameters of four pixels at a time
+ * exactly as the general iterators do, so the results are identical.
+ * Colours come from the colour ramp table when the gradient has one.
+ * Otherwise the four pixels are interpolated in SIMD as long as they fall
+ * into the current stop interval of the walker, and the walker is stepped
+ * one pixel at a time where they don't.
+ */
+
+/* Parameters within this range can be handled in 32 bit lanes */
+#define GRADIENT_T_LIMIT		(1 << 30)
+
+static force_inline int32_t
+gradient_clamp_x (pixman_fixed_48_16_t x)
+{
+    return CLIP (x, INT32_MIN, INT32_MAX);
+}
+
+/* The same arithmetic as pixman_gradient_walker_pixel_32 (), for four
+ * pixels that are all in the current interval of the walker.
+ */
+static force_inline __m128i
+gradient_interpolate_4 (const pixman_gradient_walker_t *walker,
+			__m128i                         xmm_pos)
+{
+    __m128 y = _mm_mul_ps (_mm_cvtepi32_ps (xmm_pos),
+			   _mm_set1_ps (1.0f / 65536.0f));
+    __m128 half = _mm_set1_ps (0.5f);
+    __m128i mask_ff = _mm_set1_epi32 (0xff);
+    __m128 a, r, g, b;
+
+    a = _mm_mul_ps (_mm_set1_ps (255.f),
+		    _mm_add_ps (_mm_mul_ps (_mm_set1_ps (walker->a_s), y),
+				_mm_set1_ps (walker->a_b)));
+    r = _mm_mul_ps (a, _mm_add_ps (_mm_mul_ps (_mm_set1_ps (walker->r_s), y),
+				   _mm_set1_ps (walker->r_b)));
+    g = _mm_mul_ps (a, _mm_add_ps (_mm_mul_ps (_mm_set1_ps (walker->g_s), y),
+				   _mm_set1_ps (walker->g_b)));
+    b = _mm_mul_ps (a, _mm_add_ps (_mm_mul_ps (_mm_set1_ps (walker->b_s), y),
+				   _mm_set1_ps (walker->b_b)));
+
+    return _mm_or_si128 (
+	_mm_or_si128 (
+	    _mm_slli_epi32 (_mm_and_si128 (
+				_mm_cvttps_epi32 (_mm_add_ps (a, half)), mask_ff), 24),
+	    _mm_slli_epi32 (_mm_and_si128 (
+				_mm_cvttps_epi32 (_mm_add_ps (r, half)), mask_ff), 16)),
+	_mm_or_si128 (
+	    _mm_slli_epi32 (_mm_and_si128 (
+				_mm_cvttps_epi32 (_mm_add_ps (g, half)), mask_ff), 8),
+	    _mm_and_si128 (_mm_cvttps_epi32 (_mm_add_ps (b, half)), mask_ff)));
+}
+
+/* Look up four pixels in the colour ramp table. Returns FALSE if any of
+ * them needs the walker, see _pixman_gradient_prepare_lut().
+ */
+static force_inline pixman_bool_t
+gradient_lookup_4 (const uint32_t *lut,
+		   pixman_repeat_t repeat,
+		   __m128i         xmm_pos,
+		   uint32_t       *buffer)
+{
+    __m128i xmm_t = _mm_and_si128 (xmm_pos, _mm_set1_epi32 (0xffff));
+    int32_t idx[4];
+    int k;
+
+    if (repeat == PIXMAN_REPEAT_REFLECT)
+    {
+	__m128i odd = _mm_cmpeq_epi32 (
+	    _mm_and_si128 (xmm_pos, _mm_set1_epi32 (0x10000)),
+	    _mm_set1_epi32 (0x10000));
+
+	xmm_t = _mm_or_si128 (
+	    _mm_andnot_si128 (odd, xmm_t),
+	    _mm_and_si128 (odd, _mm_sub_epi32 (_mm_set1_epi32 (0x10000), xmm_t)));
+    }
+    else if (repeat != PIXMAN_REPEAT_NORMAL)
+    {
+	xmm_t = xmm_pos;
+    }
+
+    /* Outside of [0, 0x10000), which includes 0x10000 for REFLECT */
+    if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (
+			       _mm_srli_epi32 (xmm_t, 16), _mm_setzero_si128 ())) != 0xffff)
+	return FALSE;
+
+    _mm_storeu_si128 ((__m128i *)idx,
+		      _mm_srli_epi32 (xmm_t, 16 - GRADIENT_LUT_BITS));
+
+    for (k = 0; k < 4; ++k)
+    {
+	if (lut[GRADIENT_LUT_SIZE + (idx[k] >> 5)] & (1U << (idx[k] & 31)))
+	    return FALSE;
+    }
+
+    for (k = 0; k < 4; ++k)
+	buffer[k] = lut[idx[k]];
+
+    return TRUE;
+}
+
+/* Write the colours of the four gradient parameters in @xmm_pos */
+static force_inline void
+gradient_write_narrow_4 (pixman_gradient_walker_t *walker,
+			 __m128i                   xmm_pos,
+			 uint32_t                 *buffer)
+{
+    int32_t pos[4];
+
+    if (walker->lut)
+    {
+	if (gradient_lookup_4 (walker->lut, walker->repeat, xmm_pos, buffer))
+	    return;
+    }
+    else if (!walker->need_reset)
+    {
+	__m128i left = _mm_set1_epi32 (gradient_clamp_x (walker->left_x));
+	__m128i right = _mm_set1_epi32 (gradient_clamp_x (walker->right_x));
+
+	if (_mm_movemask_epi8 (
+		_mm_andnot_si128 (_mm_cmplt_epi32 (xmm_pos, left),
+				  _mm_cmplt_epi32 (xmm_pos, right))) == 0xffff)
+	{
+	    save_128_unaligned ((__m128i *)buffer,
+				gradient_interpolate_4 (walker, xmm_pos));
+	    return;
+	}
+    }
+
+    /* Let the walker deal with stops and the colours outside of the ramp */
+    _mm_storeu_si128 ((__m128i *)pos, xmm_pos);
+
+    _pixman_gradient_walker_write_narrow (walker, pos[0], buffer + 0);
+    _pixman_gradient_walker_write_narrow (walker, pos[1], buffer + 1);
+    _pixman_gradient_walker_write_narrow (walker, pos[2], buffer + 2);
+    _pixman_gradient_walker_write_narrow (walker, pos[3], buffer + 3);
+}
+
+static force_inline __m128i
+linear_gradient_positions (pixman_fixed_32_32_t t, double inc, int i)
+{
+    __m128d xmm_i01 = _mm_set_pd (i + 1, i);
+    __m128d xmm_i23 = _mm_set_pd (i + 3, i + 2);
+    __m128d xmm_inc = _mm_set1_pd (inc);
+
+    return _mm_add_epi32 (
+	_mm_set1_epi32 ((int32_t)t),
+	_mm_unpacklo_epi64 (
+	    _mm_cvttpd_epi32 (_mm_mul_pd (xmm_inc, xmm_i01)),
+	    _mm_cvttpd_epi32 (_mm_mul_pd (xmm_inc, xmm_i23))));
+}
+
+static uint32_t *
+sse2_fetch_linear_gradient (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    pixman_gradient_walker_t walker;
+    uint32_t *buffer = iter->buffer;
+    int width = iter->width;
+    pixman_fixed_32_32_t t;
+    double inc;
+    int i;
+
+    if (!_pixman_linear_gradient_get_affine_params (
+	    image, iter->x, iter->y++, &t, &inc))
+    {
+	return iter->buffer;
+    }
+
+    _pixman_gradient_walker_init (&walker, &image->gradient,
+				  image->common.repeat);
+
+    if (((pixman_fixed_32_32_t)(inc * width)) == 0)
+    {
+	_pixman_gradient_walker_fill_narrow (&walker, t, buffer, buffer + width);
+	return iter->buffer;
+    }
+
+    i = 0;
+
+    /* t + inc * i is linear in i, so the ends bound all of it */
+    if (t > -GRADIENT_T_LIMIT && t < GRADIENT_T_LIMIT &&
+	fabs (inc * width) < GRADIENT_T_LIMIT)
+    {
+	for (; i + 4 <= width; i += 4)
+	{
+	    gradient_write_narrow_4 (
+		&walker, linear_gradient_positions (t, inc, i), buffer + i);
+	}
+    }
+
+    for (; i < width; ++i)
+    {
+	_pixman_gradient_walker_write_narrow (
+	    &walker, t + (pixman_fixed_32_32_t)(inc * i), buffer + i);
+    }
+
+    return iter->buffer;
+}
+
+static void
+sse2_linear_gradient_iter_init (pixman_iter_t *iter,
+				const pixman_iter_info_t *info)
+{
+    _pixman_linear_gradient_iter_init (iter->image, iter);
+
+    /* Horizontal gradients have been written out already */
+    if (iter->get_scanline != _pixman_iter_get_scanline_noop)
+	iter->get_scanline = sse2_fetch_linear_gradient;
+}
+
+/* Radial gradients
+ *
+ * B and C of the quadratic are integers, see radial_get_scanline(), and
+ * they are stepped with forward differences in double precision. This is
+ * exact as long as they stay below 2^53, which the iterator checks up
+ * front, so that the roots come out exactly as in radial_write_color().
+ * Single precision is not enough here: B² - AC loses most of its bits to
+ * cancellation near the focal point.
+ */
+#define RADIAL_GRADIENT_EXACT_LIMIT	(1ULL << 52)
+
+typedef struct
+{
+    __m128d	b, db;		/* B of two pixels, and its step */
+    __m128d	c, dc, ddc;	/* C of two pixels, and its steps */
+    __m128d	a, inva;
+    __m128d	dr, mindr;
+    pixman_bool_t none;
+} radial_gradient_lanes_t;
+
+static force_inline void
+radial_gradient_lanes_init (radial_gradient_lanes_t *lanes,
+			    const radial_gradient_t *radial,
+			    pixman_repeat_t          repeat,
+			    pixman_fixed_32_32_t     b,
+			    pixman_fixed_32_32_t     db,
+			    pixman_fixed_32_32_t     c,
+			    pixman_fixed_32_32_t     dc,
+			    pixman_fixed_32_32_t     ddc)
+{
+    /* Pixels n and n + 1; every step advances both by two pixels */
+    lanes->b = _mm_set_pd ((double)(b + db), (double)b);
+    lanes->db = _mm_set1_pd (2 * (double)db);
+    lanes->c = _mm_set_pd ((double)(c + dc), (double)c);
+    lanes->dc = _mm_set_pd ((double)(2 * dc + 3 * ddc), (double)(2 * dc + ddc));
+    lanes->ddc = _mm_set1_pd (4 * (double)ddc);
+
+    lanes->a = _mm_set1_pd (radial->a);
+    lanes->inva = _mm_set1_pd (radial->inva);
+    lanes->dr = _mm_set1_pd (radial->delta.radius);
+    lanes->mindr = _mm_set1_pd (radial->mindr);
+    lanes->none = repeat == PIXMAN_REPEAT_NONE;
+}
+
+/* Solve the quadratic for two pixels, like radial_write_color () does
+ * for a != 0, and advance. The lanes of @valid are set for pixels that
+ * are covered by the gradient.
+ */
+static force_inline __m128d
+radial_gradient_solve_2 (radial_gradient_lanes_t *lanes, __m128d *valid)
+{
+    __m128d discr, sqrtdiscr, t0, t1, valid0, valid1;
+
+    discr = _mm_sub_pd (_mm_mul_pd (lanes->b, lanes->b),
+			_mm_mul_pd (lanes->a, lanes->c));
+    sqrtdiscr = _mm_sqrt_pd (_mm_max_pd (discr, _mm_setzero_pd ()));
+    t0 = _mm_mul_pd (_mm_add_pd (lanes->b, sqrtdiscr), lanes->inva);
+    t1 = _mm_mul_pd (_mm_sub_pd (lanes->b, sqrtdiscr), lanes->inva);
+
+    if (lanes->none)
+    {
+	__m128d zero = _mm_setzero_pd ();
+	__m128d one = _mm_set1_pd (pixman_fixed_1);
+
+	valid0 = _mm_and_pd (_mm_cmple_pd (zero, t0), _mm_cmple_pd (t0, one));
+	valid1 = _mm_and_pd (_mm_cmple_pd (zero, t1), _mm_cmple_pd (t1, one));
+    }
+    else
+    {
+	valid0 = _mm_cmpge_pd (_mm_mul_pd (t0, lanes->dr), lanes->mindr);
+	valid1 = _mm_cmpge_pd (_mm_mul_pd (t1, lanes->dr), lanes->mindr);
+    }
+
+    *valid = _mm_and_pd (_mm_cmpge_pd (discr, _mm_setzero_pd ()),
+			 _mm_or_pd (valid0, valid1));
+
+    lanes->b = _mm_add_pd (lanes->b, lanes->db);
+    lanes->c = _mm_add_pd (lanes->c, lanes->dc);
+    lanes->dc = _mm_add_pd (lanes->dc, lanes->ddc);
+
+    return _mm_or_pd (_mm_and_pd (valid0, t0), _mm_andnot_pd (valid0, t1));
+}
+
+static uint32_t *
+sse2_fetch_radial_gradient (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    pixman_bool_t wide = !(iter->iter_flags & ITER_NARROW);
+    pixman_gradient_walker_t walker;
+    radial_gradient_lanes_t lanes;
+    uint32_t *buffer = iter->buffer;
+    int width = iter->width;
+    pixman_fixed_32_32_t b, db, c, dc, ddc;
+    int i, k;
+
+    if (!_pixman_radial_gradient_get_affine_params (
+	    image, iter->x, iter->y++, &b, &db, &c, &dc, &ddc))
+    {
+	return iter->buffer;
+    }
+
+    _pixman_gradient_walker_init (&walker, &image->gradient,
+				  image->common.repeat);
+
+    radial_gradient_lanes_init (&lanes, &image->radial, image->common.repeat,
+				b, db, c, dc, ddc);
+
+    for (i = 0; i < width; i += 4)
+    {
+	__m128d t01, t23, valid01, valid23;
+	double t[4];
+	int valid;
+
+	t01 = radial_gradient_solve_2 (&lanes, &valid01);
+	t23 = radial_gradient_solve_2 (&lanes, &valid23);
+
+	valid = _mm_movemask_pd (valid01) | (_mm_movemask_pd (valid23) << 2);
+
+	if (!wide && valid == 0xf && i + 4 <= width)
+	{
+	    __m128d limit = _mm_set1_pd (GRADIENT_T_LIMIT);
+	    __m128d in_range = _mm_and_pd (
+		_mm_cmplt_pd (_mm_andnot_pd (_mm_set1_pd (-0.0), t01), limit),
+		_mm_cmplt_pd (_mm_andnot_pd (_mm_set1_pd (-0.0), t23), limit));
+
+	    if (_mm_movemask_pd (in_range) == 0x3)
+	    {
+		gradient_write_narrow_4 (
+		    &walker,
+		    _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (t01),
+					_mm_cvttpd_epi32 (t23)),
+		    buffer + i);
+		continue;
+	    }
+	}
+
+	_mm_storeu_pd (t + 0, t01);
+	_mm_storeu_pd (t + 2, t23);
+
+	for (k = 0; k < 4 && i + k < width; ++k)
+	{
+	    if (wide)
+	    {
+		if (valid & (1 << k))
+		{
+		    _pixman_gradient_walker_write_wide (
+			&walker, t[k], buffer + 4 * (i + k));
+		}
+		else
+		{
+		    memset (buffer + 4 * (i + k), 0, 16);
+		}
+	    }
+	    else
+	    {
+		if (valid & (1 << k))
+		    _pixman_gradient_walker_write_narrow (&walker, t[k], buffer + i + k);
+		else
+		    buffer[i + k] = 0;
+	    }
+	}
+    }
+
+    return iter->buffer;
+}
+
+/* Whether B, C and the differences of C stay below
+ * RADIAL_GRADIENT_EXACT_LIMIT for all the pixels of @iter, including
+ * the up to three pixels past the end of each row that the fetcher
+ * computes as well. B and the first difference of C are affine in the
+ * pixel position, and C is a convex quadratic bounded below by -r₁²,
+ * so it is enough to look at the corners.
+ */
+static pixman_bool_t
+radial_gradient_is_exact (pixman_iter_t *iter)
+{
+    pixman_image_t *image = iter->image;
+    int x[2], y[2];
+    int i, j;
+
+    x[0] = iter->x;
+    x[1] = iter->x + iter->width + 3;
+    y[0] = iter->y;
+    y[1] = iter->y + iter->height - 1;
+
+    if ((double)image->radial.c1.radius * image->radial.c1.radius >=
+	RADIAL_GRADIENT_EXACT_LIMIT)
+    {
+	return FALSE;
+    }
+
+    for (j = 0; j < 2; ++j)
+    {
+	for (i = 0; i < 2; ++i)
+	{
+	    pixman_fixed_32_32_t b, db, c, dc, ddc;
+
+	    if (!_pixman_radial_gradient_get_affine_params (
+		    image, x[i], y[j], &b, &db, &c, &dc, &ddc))
+	    {
+		return FALSE;
+	    }
+
+	    if (fabs ((double)b) >= RADIAL_GRADIENT_EXACT_LIMIT ||
+		fabs ((double)c) >= RADIAL_GRADIENT_EXACT_LIMIT ||
+		fabs ((double)dc) + 4 * fabs ((double)ddc) >=
+		RADIAL_GRADIENT_EXACT_LIMIT)
+	    {
+		return FALSE;
+	    }
+	}
+    }
+
+    return TRUE;
+}
+
+static void
+sse2_radial_gradient_iter_init (pixman_iter_t *iter,
+				const pixman_iter_info_t *info)
+{
+    _pixman_radial_gradient_iter_init (iter->image, iter);
+
+    /* When the circles touch, a is 0 and the equation is linear */
+    if (iter->image->radial.a != 0 && radial_gradient_is_exact (iter))
+	iter->get_scanline = sse2_fetch_radial_gradient;
+}
+
+/* Conical gradients
+ *
+ * The angle is computed in single precision with a polynomial instead of
+ * atan2 (). Its error is below 1e-5 radians, which is less than 1/65536 of
+ * a turn and so at most one step of the 16.16 gradient parameter.
+ */
+static force_inline __m128i
+conical_gradient_positions (__m128 x, __m128 y, __m128 angle)
+{
+    const __m128 sign = _mm_set1_ps (-0.0f);
+    const __m128 zero = _mm_setzero_ps ();
+    const __m128 one = _mm_set1_ps (1.0f);
+    __m128 ax = _mm_andnot_ps (sign, x);
+    __m128 ay = _mm_andnot_ps (sign, y);
+    __m128 mx = _mm_max_ps (ax, ay);
+    __m128 a, s, r, t, f, swap;
+
+    /* atan (a) on [0, 1], Abramowitz and Stegun 4.4.49. The center
+     * would divide 0 by 0; it gets an angle of 0 like with atan2 ().
+     */
+    a = _mm_and_ps (_mm_div_ps (_mm_min_ps (ax, ay), mx),
+		    _mm_cmpgt_ps (mx, zero));
+    s = _mm_mul_ps (a, a);
+    r = _mm_add_ps (_mm_mul_ps (_mm_set1_ps (0.0208351f), s),
+		    _mm_set1_ps (-0.0851330f));
+    r = _mm_add_ps (_mm_mul_ps (r, s), _mm_set1_ps (0.1801410f));
+    r = _mm_add_ps (_mm_mul_ps (r, s), _mm_set1_ps (-0.3302995f));
+    r = _mm_add_ps (_mm_mul_ps (r, s), _mm_set1_ps (0.9998660f));
+    r = _mm_mul_ps (r, a);
+
+    /* Unfold into the other octants */
+    swap = _mm_cmpgt_ps (ay, ax);
+    r = _mm_or_ps (_mm_andnot_ps (swap, r),
+		   _mm_and_ps (swap, _mm_sub_ps (_mm_set1_ps (M_PI / 2), r)));
+    swap = _mm_cmplt_ps (x, zero);
+    r = _mm_or_ps (_mm_andnot_ps (swap, r),
+		   _mm_and_ps (swap, _mm_sub_ps (_mm_set1_ps (M_PI), r)));
+    r = _mm_xor_ps (r, _mm_and_ps (y, sign));
+
+    /* Turns, wrapped into [0, 1) */
+    t = _mm_add_ps (_mm_mul_ps (r, _mm_set1_ps (1 / (2 * M_PI))), angle);
+    f = _mm_cvtepi32_ps (_mm_cvttps_epi32 (t));
+    f = _mm_sub_ps (f, _mm_and_ps (_mm_cmpgt_ps (f, t), one));
+    t = _mm_sub_ps (t, f);
+
+    /* Scale t to [0, 1] and make rotation CCW, as in
+     * coordinates_to_parameter ()
+     */
+    return _mm_cvttps_epi32 (
+	_mm_mul_ps (_mm_sub_ps (one, t), _mm_set1_ps (65536.f)));
+}
+
+static uint32_t *
+sse2_fetch_conical_gradient (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    pixman_bool_t wide = !(iter->iter_flags & ITER_NARROW);
+    pixman_gradient_walker_t walker;
+    uint32_t *buffer = iter->buffer;
+    int width = iter->width;
+    double rx, ry, cx, cy;
+    __m128 xmm_cx, xmm_cy, angle;
+    int i, k;
+
+    if (!_pixman_conical_gradient_get_affine_params (
+	    image, iter->x, iter->y++, &rx, &ry, &cx, &cy))
+    {
+	return iter->buffer;
+    }
+
+    _pixman_gradient_walker_init (&walker, &image->gradient,
+				  image->common.repeat);
+
+    xmm_cx = _mm_mul_ps (_mm_set_ps (3, 2, 1, 0), _mm_set1_ps (cx));
+    xmm_cy = _mm_mul_ps (_mm_set_ps (3, 2, 1, 0), _mm_set1_ps (cy));
+    angle = _mm_set1_ps (image->conical.angle * (1 / (2 * M_PI)));
+
+    for (i = 0; i < width; i += 4)
+    {
+	/* The start of each group is computed in double precision so that
+	 * errors don't accumulate along the row.
+	 */
+	__m128 x = _mm_add_ps (_mm_set1_ps (rx + i * cx), xmm_cx);
+	__m128 y = _mm_add_ps (_mm_set1_ps (ry + i * cy), xmm_cy);
+	__m128i xmm_pos = conical_gradient_positions (x, y, angle);
+	int32_t pos[4];
+
+	if (!wide && i + 4 <= width)
+	{
+	    gradient_write_narrow_4 (&walker, xmm_pos, buffer + i);
+	    continue;
+	}
+
+	_mm_storeu_si128 ((__m128i *)pos, xmm_pos);
+
+	for (k = 0; k < 4 && i + k < width; ++k)
+	{
+	    if (wide)
+	    {
+		_pixman_gradient_walker_write_wide (
+		    &walker, pos[k], buffer + 4 * (i + k));
+	    }
+	    else
+	    {
+		_pixman_gradient_walker_write_narrow (
+		    &walker, pos[k], buffer + i + k);
+	    }
+	}
+    }
+
+    return iter->buffer;
+}
+
+static void
+sse2_conical_gradient_iter_init (pixman_iter_t *iter,
+				 const pixman_iter_info_t *info)
+{
+    _pixman_conical_gradient_iter_init (iter->image, iter);
+
+    iter->get_scanline = sse2_fetch_conical_gradient;
+}
+
 #define IMAGE_FLAGS							\
     (FAST_PATH_STANDARD_FLAGS | FAST_PATH_ID_TRANSFORM |		\
      FAST_PATH_BITS_IMAGE | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST)
 
 static const pixman_iter_info_t sse2_iters[] = 
 {
+    { PIXMAN_linear_gradient, FAST_PATH_AFFINE_TRANSFORM, ITER_NARROW,
+      sse2_linear_gradient_iter_init, NULL, NULL
+    },
+    { PIXMAN_radial_gradient, FAST_PATH_AFFINE_TRANSFORM, 0,
+      sse2_radial_gradient_iter_init, NULL, NULL
+    },
+    { PIXMAN_conical_gradient, FAST_PATH_AFFINE_TRANSFORM, 0,
+      sse2_conical_gradient_iter_init, NULL, NULL
+    },
     { PIXMAN_x8r8g8b8, IMAGE_FLAGS, ITER_NARROW,
       _pixman_iter_init_bits_stride, sse2_fetch_x8r8g8b8, NULL
     },
@@ -6462,6 +7790,38 @@ static const pixman_iter_info_t sse2_iters[] =
     { PIXMAN_a8, IMAGE_FLAGS, ITER_NARROW,
       _pixman_iter_init_bits_stride, sse2_fetch_a8, NULL
     },
+
+#define AFFINE_FLAGS							\
+    (FAST_PATH_NO_ALPHA_MAP		|				\
+     FAST_PATH_NO_ACCESSORS		|				\
+     FAST_PATH_HAS_TRANSFORM		|				\
+     FAST_PATH_AFFINE_TRANSFORM)
+
+#define AFFINE_FAST_PATH(name, format, repeat)				\
+    { PIXMAN_ ## format,						\
+      AFFINE_FLAGS | FAST_PATH_BILINEAR_FILTER |			\
+      FAST_PATH_ ## repeat ## _REPEAT,					\
+      ITER_NARROW | ITER_SRC,						\
+      NULL, sse2_fetch_bilinear_affine_ ## name, NULL			\
+    },
+
+    AFFINE_FAST_PATH (pad_a8r8g8b8, a8r8g8b8, PAD)
+    AFFINE_FAST_PATH (none_a8r8g8b8, a8r8g8b8, NONE)
+    AFFINE_FAST_PATH (reflect_a8r8g8b8, a8r8g8b8, REFLECT)
+    AFFINE_FAST_PATH (normal_a8r8g8b8, a8r8g8b8, NORMAL)
+    AFFINE_FAST_PATH (pad_x8r8g8b8, x8r8g8b8, PAD)
+    AFFINE_FAST_PATH (none_x8r8g8b8, x8r8g8b8, NONE)
+    AFFINE_FAST_PATH (reflect_x8r8g8b8, x8r8g8b8, REFLECT)
+    AFFINE_FAST_PATH (normal_x8r8g8b8, x8r8g8b8, NORMAL)
+    AFFINE_FAST_PATH (pad_a8, a8, PAD)
+    AFFINE_FAST_PATH (none_a8, a8, NONE)
+    AFFINE_FAST_PATH (reflect_a8, a8, REFLECT)
+    AFFINE_FAST_PATH (normal_a8, a8, NORMAL)
+    AFFINE_FAST_PATH (pad_r5g6b5, r5g6b5, PAD)
+    AFFINE_FAST_PATH (none_r5g6b5, r5g6b5, NONE)
+    AFFINE_FAST_PATH (reflect_r5g6b5, r5g6b5, REFLECT)
+    AFFINE_FAST_PATH (normal_r5g6b5, r5g6b5, NORMAL)
+
     { PIXMAN_null },
 };
 
@@ -6520,6 +7880,7 @@ _pixman_implementation_create_sse2 (pixman_implementation_t *fallback)
 
     imp->blt = sse2_blt;
     imp->fill = sse2_fill;
+    imp->add_saturate_8 = sse2_add_saturate_8;
 
     imp->iter_info = sse2_iters;
 
@@ -27,6 +27,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "pixman-private.h"
 
 /*
@@ -342,14 +343,21 @@ pixman_add_trapezoids (pixman_image_t *          image,
 #endif
 }
 
+/*
+ * Rasterize the part of a trapezoid that falls in the rows [y1, y2) of
+ * the image. Nothing outside of those rows is read or written, so
+ * disjoint bands of the same image can be rasterized independently,
+ * for example from several threads.
+ */
 PIXMAN_EXPORT void
-pixman_rasterize_trapezoid (pixman_image_t *          image,
-                            const pixman_trapezoid_t *trap,
-                            int                       x_off,
-                            int                       y_off)
+pixman_rasterize_trapezoid_band (pixman_image_t *          image,
+				 const pixman_trapezoid_t *trap,
+				 int                       x_off,
+				 int                       y_off,
+				 int                       y1,
+				 int                       y2)
 {
     int bpp;
-    int height;
 
     pixman_fixed_t y_off_fixed;
     pixman_edge_t l, r;
@@ -362,19 +370,24 @@ pixman_rasterize_trapezoid (pixman_image_t *          image,
     if (!pixman_trapezoid_valid (trap))
 	return;
 
-    height = image->bits.height;
+    y1 = MAX (y1, 0);
+    y2 = MIN (y2, image->bits.height);
+
+    if (y1 >= y2)
+	return;
+
     bpp = PIXMAN_FORMAT_BPP (image->bits.format);
 
     y_off_fixed = pixman_int_to_fixed (y_off);
 
     t = trap->top + y_off_fixed;
-    if (t < 0)
-	t = 0;
+    if (t < pixman_int_to_fixed (y1))
+	t = pixman_int_to_fixed (y1);
     t = pixman_sample_ceil_y (t, bpp);
 
     b = trap->bottom + y_off_fixed;
-    if (pixman_fixed_to_int (b) >= height)
-	b = pixman_int_to_fixed (height) - 1;
+    if (pixman_fixed_to_int (b) >= y2)
+	b = pixman_int_to_fixed (y2) - 1;
     b = pixman_sample_floor_y (b, bpp);
     
     if (b >= t)
@@ -387,25 +400,20 @@ pixman_rasterize_trapezoid (pixman_image_t *          image,
     }
 }
 
-static const pixman_bool_t zero_src_has_no_effect[PIXMAN_N_OPERATORS] =
+PIXMAN_EXPORT void
+pixman_rasterize_trapezoid (pixman_image_t *          image,
+                            const pixman_trapezoid_t *trap,
+                            int                       x_off,
+                            int                       y_off)
 {
-    FALSE,	/* Clear		0			0    */
-    FALSE,	/* Src			1			0    */
-    TRUE,	/* Dst			0			1    */
-    TRUE,	/* Over			1			1-Aa */
-    TRUE,	/* OverReverse		1-Ab			1    */
-    FALSE,	/* In			Ab			0    */
-    FALSE,	/* InReverse		0			Aa   */
-    FALSE,	/* Out			1-Ab			0    */
-    TRUE,	/* OutReverse		0			1-Aa */
-    TRUE,	/* Atop			Ab			1-Aa */
-    FALSE,	/* AtopReverse		1-Ab			Aa   */
-    TRUE,	/* Xor			1-Ab			1-Aa */
-    TRUE,	/* Add			1			1    */
-};
+    return_if_fail (image->type == BITS);
+
+    pixman_rasterize_trapezoid_band (image, trap, x_off, y_off,
+				     0, image->bits.height);
+}
 
 static pixman_bool_t
-get_trap_extents (pixman_op_t op, pixman_image_t *dest,
+get_trap_extents (pixman_op_t op, pixman_image_t *dest, int y_dst,
 		  const pixman_trapezoid_t *traps, int n_traps,
 		  pixman_box32_t *box)
 {
@@ -415,7 +423,7 @@ get_trap_extents (pixman_op_t op, pixman_image_t *dest,
      * effect on the underlying image, we have to
      * composite across the entire destination
      */
-    if (!zero_src_has_no_effect [op])
+    if (!_pixman_zero_src_has_no_effect [op])
     {
 	box->x1 = 0;
 	box->y1 = 0;
@@ -461,13 +469,351 @@ get_trap_extents (pixman_op_t op, pixman_image_t *dest,
 	EXTEND(trap->right.p1.x);
 	EXTEND(trap->right.p2.x);
     }
-	
+
+    /* Rows outside of the destination do not need to be rasterized.
+     * The columns are left alone, because they determine where the
+     * x coordinates of extremely slanted edges overflow.
+     */
+    box->y1 = MAX (box->y1, - y_dst);
+    box->y2 = MIN (box->y2, dest->bits.height - y_dst);
+
     if (box->x1 >= box->x2 || box->y1 >= box->y2)
 	return FALSE;
 
     return TRUE;
 }
 
+/*
+ * Sweep-line rasterization of a set of trapezoids
+ *
+ * The trapezoids are sorted once by their first sample row, and the
+ * mask is then rasterized in bands of rows from top to bottom. Each
+ * band is rasterized for all the trapezoids that cross it before moving
+ * on to the next, and the edges of a trapezoid are set up when the
+ * first band reaches it and stepped along from band to band after that.
+ * Coverage is accumulated with saturating adds, which do not depend on
+ * the order, so the result is the same as when the trapezoids are
+ * rasterized one by one.
+ */
+#define TRAP_TILE_SIZE		(64 * 1024)
+
+typedef struct
+{
+    const pixman_trapezoid_t *	trap;
+    pixman_fixed_t		t;	/* First sample row */
+    pixman_fixed_t		b;	/* Last sample row */
+} trap_rows_t;
+
+typedef struct
+{
+    pixman_edge_t	l, r;
+    pixman_fixed_t	t;	/* Next sample row */
+    pixman_fixed_t	b;	/* Last sample row */
+} trap_edges_t;
+
+typedef struct
+{
+    int			bpp;
+    int			x_off;
+    int			y_off;
+    trap_rows_t *	rows;	/* Sorted by first sample row */
+    int			n_rows;
+    int			next;	/* First one that is not active yet */
+    trap_edges_t *	active;
+    int			n_active;
+    pixman_box32_t *	boxes;	/* Touched by each trapezoid in a band */
+    int			n_boxes;
+} trap_sweep_t;
+
+static void
+trap_sweep_fini (trap_sweep_t *sweep)
+{
+    free (sweep->rows);
+    free (sweep->active);
+    free (sweep->boxes);
+}
+
+/* Find the sample rows of the trapezoids within rows [0, height) once
+ * they are offset by (x_off, y_off), and sort them from top to bottom.
+ */
+static pixman_bool_t
+trap_sweep_init (trap_sweep_t *			sweep,
+		 int				bpp,
+		 int				height,
+		 int				x_off,
+		 int				y_off,
+		 int				n_traps,
+		 const pixman_trapezoid_t *	traps)
+{
+    pixman_fixed_t y_off_fixed = pixman_int_to_fixed (y_off);
+    trap_rows_t *rows;
+    int *first;
+    int i, n;
+
+    sweep->bpp = bpp;
+    sweep->x_off = x_off;
+    sweep->y_off = y_off;
+    sweep->n_rows = 0;
+    sweep->next = 0;
+    sweep->n_active = 0;
+    sweep->boxes = NULL;
+    sweep->n_boxes = 0;
+
+    rows = pixman_malloc_ab (n_traps, sizeof (trap_rows_t));
+    first = pixman_malloc_ab (height + 1, sizeof (int));
+    sweep->rows = pixman_malloc_ab (n_traps, sizeof (trap_rows_t));
+    sweep->active = pixman_malloc_ab (n_traps, sizeof (trap_edges_t));
+
+    if (!rows || !first || !sweep->rows || !sweep->active)
+    {
+	free (rows);
+	free (first);
+	trap_sweep_fini (sweep);
+	return FALSE;
+    }
+
+    memset (first, 0, (height + 1) * sizeof (int));
+
+    for (i = 0, n = 0; i < n_traps; ++i)
+    {
+	const pixman_trapezoid_t *trap = &(traps[i]);
+	pixman_fixed_t t, b;
+
+	if (!pixman_trapezoid_valid (trap))
+	    continue;
+
+	/* Same sample rows as pixman_rasterize_trapezoid() */
+	t = trap->top + y_off_fixed;
+	if (t < 0)
+	    t = 0;
+	t = pixman_sample_ceil_y (t, bpp);
+
+	b = trap->bottom + y_off_fixed;
+	if (pixman_fixed_to_int (b) >= height)
+	    b = pixman_int_to_fixed (height) - 1;
+	b = pixman_sample_floor_y (b, bpp);
+
+	if (b < t)
+	    continue;
+
+	rows[n].trap = trap;
+	rows[n].t = t;
+	rows[n].b = b;
+	n++;
+
+	first[pixman_fixed_to_int (t) + 1]++;
+    }
+
+    /* Counting sort by the first pixel row */
+    for (i = 0; i < height; ++i)
+	first[i + 1] += first[i];
+
+    for (i = 0; i < n; ++i)
+	sweep->rows[first[pixman_fixed_to_int (rows[i].t)]++] = rows[i];
+
+    sweep->n_rows = n;
+
+    free (rows);
+    free (first);
+
+    return TRUE;
+}
+
+/* Number of rows in a band of a mask that is @width pixels wide */
+static int
+trap_band_height (int width, int bpp, int height)
+{
+    int stride = ((width * bpp + 0x1f) >> 5) * sizeof (uint32_t);
+
+    return CLIP (TRAP_TILE_SIZE / stride, 1, height);
+}
+
+/* Whether the x coordinate of @edge can overflow while it is stepped
+ * from @x over @height. The edge then does not stay between where it
+ * started and where it stopped. The steps per row are kept in 32 bits
+ * as well, so very steep edges are assumed to overflow.
+ */
+static pixman_bool_t
+trap_edge_may_wrap (const pixman_edge_t *edge,
+		    pixman_fixed_t       x,
+		    pixman_fixed_t       height)
+{
+    int64_t slope = llabs ((int64_t)edge->stepx) + 1;
+
+    if (slope * pixman_fixed_1 > INT32_MAX / 2)
+	return TRUE;
+
+    return llabs ((int64_t)x) + slope * height > INT32_MAX - 2 * pixman_fixed_1;
+}
+
+/* Rasterize rows [y1, y2) into @image, starting at its row @y. Bands
+ * must be visited from top to bottom. Returns whether any trapezoid
+ * covered the band. If sweep->boxes is not NULL, it receives a box
+ * around the pixels that each trapezoid may have touched.
+ */
+static pixman_bool_t
+trap_sweep_band (trap_sweep_t *	sweep,
+		 pixman_image_t *	image,
+		 int			y,
+		 int			y1,
+		 int			y2)
+{
+    pixman_fixed_t origin = pixman_int_to_fixed (y1 - y);
+    pixman_fixed_t last = pixman_int_to_fixed (y2 - 1) + Y_FRAC_LAST (sweep->bpp);
+    pixman_bool_t covered;
+    int i;
+
+    sweep->n_boxes = 0;
+
+    /* Edges are only set up once their trapezoid is reached */
+    while (sweep->next < sweep->n_rows && sweep->rows[sweep->next].t <= last)
+    {
+	const trap_rows_t *rows = &sweep->rows[sweep->next++];
+	trap_edges_t *edges = &sweep->active[sweep->n_active++];
+
+	pixman_line_fixed_edge_init (&edges->l, sweep->bpp, rows->t,
+				     &rows->trap->left,
+				     sweep->x_off, sweep->y_off);
+	pixman_line_fixed_edge_init (&edges->r, sweep->bpp, rows->t,
+				     &rows->trap->right,
+				     sweep->x_off, sweep->y_off);
+	edges->t = rows->t;
+	edges->b = rows->b;
+    }
+
+    covered = sweep->n_active > 0;
+
+    for (i = 0; i < sweep->n_active; ++i)
+    {
+	trap_edges_t *edges = &sweep->active[i];
+	pixman_fixed_t b = MIN (edges->b, last);
+	pixman_fixed_t lx = edges->l.x;
+	pixman_fixed_t rx = edges->r.x;
+	pixman_fixed_t x1 = MIN (lx, rx);
+	pixman_fixed_t x2 = MAX (lx, rx);
+
+	pixman_rasterize_edges (image, &edges->l, &edges->r,
+				edges->t - origin, b - origin);
+
+	if (sweep->boxes)
+	{
+	    /* The edges are straight, so they stay within the range of
+	     * where they started and where they stopped.
+	     */
+	    pixman_box32_t *box = &sweep->boxes[sweep->n_boxes];
+
+	    x1 = MIN (x1, MIN (edges->l.x, edges->r.x));
+	    x2 = MAX (x2, MAX (edges->l.x, edges->r.x));
+
+	    if (trap_edge_may_wrap (&edges->l, lx, b - edges->t) ||
+		trap_edge_may_wrap (&edges->r, rx, b - edges->t))
+	    {
+		box->x1 = 0;
+		box->x2 = image->bits.width;
+	    }
+	    else
+	    {
+		box->x1 = MAX (pixman_fixed_to_int (x1), 0);
+		box->x2 = MIN (pixman_fixed_to_int (x2) + 1, image->bits.width);
+	    }
+
+	    box->y1 = pixman_fixed_to_int (edges->t - origin);
+	    box->y2 = pixman_fixed_to_int (b - origin) + 1;
+
+	    if (box->x1 < box->x2)
+		sweep->n_boxes++;
+	}
+
+	if (b == edges->b)
+	{
+	    /* Order does not matter, so move the last one here */
+	    *edges = sweep->active[--sweep->n_active];
+	    i--;
+	}
+	else
+	{
+	    /* Continue at the first sample row of the next band */
+	    RENDER_EDGE_STEP_BIG ((&edges->l));
+	    RENDER_EDGE_STEP_BIG ((&edges->r));
+	    edges->t = pixman_int_to_fixed (y2) + Y_FRAC_FIRST (sweep->bpp);
+	}
+    }
+
+    return covered;
+}
+
+/* The number of pixels in the boxes of a band, counting overlaps twice */
+static int64_t
+trap_boxes_area (const trap_sweep_t *sweep)
+{
+    int64_t area = 0;
+    int i;
+
+    for (i = 0; i < sweep->n_boxes; ++i)
+    {
+	const pixman_box32_t *box = &sweep->boxes[i];
+
+	area += (int64_t)(box->x2 - box->x1) * (box->y2 - box->y1);
+    }
+
+    return area;
+}
+
+/* Composite the pixels of a band of @mask that the trapezoids may have
+ * touched, and clear them for the next band. The boxes around the
+ * trapezoids can overlap, so they are merged into a region first to
+ * composite every pixel once. Returns FALSE, with the band untouched,
+ * if the region could not be allocated.
+ */
+static pixman_bool_t
+trap_composite_boxes (pixman_op_t		op,
+		      pixman_image_t *		src,
+		      pixman_image_t *		mask,
+		      pixman_image_t *		dst,
+		      const trap_sweep_t *	sweep,
+		      int			x_src,
+		      int			y_src,
+		      int			x_dst,
+		      int			y_dst)
+{
+    int bpp = PIXMAN_FORMAT_BPP (mask->bits.format);
+    int stride = mask->bits.rowstride * sizeof (uint32_t);
+    uint8_t *bits = (uint8_t *)mask->bits.bits;
+    pixman_region32_t region;
+    const pixman_box32_t *box;
+    int n, i, y;
+
+    if (!pixman_region32_init_rects (&region, sweep->boxes, sweep->n_boxes))
+	return FALSE;
+
+    box = pixman_region32_rectangles (&region, &n);
+
+    for (i = 0; i < n; ++i)
+    {
+	pixman_image_composite (op, src, mask, dst,
+				x_src + box[i].x1, y_src + box[i].y1,
+				box[i].x1, box[i].y1,
+				x_dst + box[i].x1, y_dst + box[i].y1,
+				box[i].x2 - box[i].x1, box[i].y2 - box[i].y1);
+    }
+
+    /* Clearing whole bytes of a1 or a4 pixels can reach into the next
+     * box, so that waits until all of them are composited.
+     */
+    for (i = 0; i < n; ++i)
+    {
+	int b1 = (box[i].x1 * bpp) >> 3;
+	int b2 = (box[i].x2 * bpp + 7) >> 3;
+
+	for (y = box[i].y1; y < box[i].y2; ++y)
+	    memset (bits + y * stride + b1, 0, b2 - b1);
+    }
+
+    pixman_region32_fini (&region);
+
+    return TRUE;
+}
+
 /*
  * pixman_composite_trapezoids()
  *
@@ -489,7 +835,8 @@ pixman_composite_trapezoids (pixman_op_t		op,
 			     int			n_traps,
 			     const pixman_trapezoid_t *	traps)
 {
-    int i;
+    trap_sweep_t sweep;
+    int bpp;
 
     return_if_fail (PIXMAN_FORMAT_TYPE (mask_format) == PIXMAN_TYPE_A);
     
@@ -499,52 +846,107 @@ pixman_composite_trapezoids (pixman_op_t		op,
     _pixman_image_validate (src);
     _pixman_image_validate (dst);
 
+    bpp = PIXMAN_FORMAT_BPP (mask_format);
+
     if (op == PIXMAN_OP_ADD &&
 	(src->common.flags & FAST_PATH_IS_OPAQUE)		&&
 	(mask_format == dst->common.extended_format_code)	&&
 	!(dst->common.have_clip_region))
     {
-	for (i = 0; i < n_traps; ++i)
-	{
-	    const pixman_trapezoid_t *trap = &(traps[i]);
-	    
-	    if (!pixman_trapezoid_valid (trap))
-		continue;
-	    
-	    pixman_rasterize_trapezoid (dst, trap, x_dst, y_dst);
-	}
+	int height = dst->bits.height;
+	int band_height = trap_band_height (dst->bits.width, bpp, height);
+	int y;
+
+	if (!trap_sweep_init (&sweep, bpp, height, x_dst, y_dst, n_traps, traps))
+	    return;
+
+	for (y = 0; y < height; y += band_height)
+	    trap_sweep_band (&sweep, dst, y, y, MIN (y + band_height, height));
     }
     else
     {
 	pixman_image_t *tmp;
 	pixman_box32_t box;
-	int i;
+	int width, height, tile_height, y;
 
-	if (!get_trap_extents (op, dst, traps, n_traps, &box))
+	if (!get_trap_extents (op, dst, y_dst, traps, n_traps, &box))
 	    return;
-	
+
+	width = box.x2 - box.x1;
+	height = box.y2 - box.y1;
+
+	if (!trap_sweep_init (&sweep, bpp, height,
+			      - box.x1, - box.y1, n_traps, traps))
+	{
+	    return;
+	}
+
+	/* The mask is rasterized and composited a band of rows at a
+	 * time, so it stays small and in the cache however large the
+	 * extents of the trapezoids are.
+	 */
+	tile_height = trap_band_height (width, bpp, height);
+
 	if (!(tmp = pixman_image_create_bits (
-		  mask_format, box.x2 - box.x1, box.y2 - box.y1, NULL, -1)))
+		  mask_format, width, tile_height, NULL, -1)))
+	{
+	    trap_sweep_fini (&sweep);
 	    return;
-	
-	for (i = 0; i < n_traps; ++i)
+	}
+
+	/* With a solid source, an operator where zero coverage has no
+	 * effect only has to touch the pixels that the trapezoids went
+	 * through, such as the few pixels per row of a thin line. Those
+	 * are composited straight from the band as it is produced, and
+	 * only they are cleared afterwards. Bands that are mostly covered
+	 * anyway are composited whole.
+	 */
+	if (src->type == SOLID && (op == PIXMAN_OP_OVER || op == PIXMAN_OP_ADD))
 	{
-	    const pixman_trapezoid_t *trap = &(traps[i]);
-	    
-	    if (!pixman_trapezoid_valid (trap))
+	    sweep.boxes = pixman_malloc_ab (sweep.n_rows, sizeof (pixman_box32_t));
+
+	    if (!sweep.boxes)
+	    {
+		pixman_image_unref (tmp);
+		trap_sweep_fini (&sweep);
+		return;
+	    }
+	}
+
+	for (y = 0; y < height; y += tile_height)
+	{
+	    int h = MIN (tile_height, height - y);
+	    pixman_bool_t covered = trap_sweep_band (&sweep, tmp, 0, y, y + h);
+
+	    /* If that fails, the band is composited and cleared whole */
+	    if (sweep.boxes && trap_boxes_area (&sweep) < (int64_t)width * h / 2 &&
+		trap_composite_boxes (op, src, tmp, dst, &sweep,
+				      x_src + box.x1, y_src + box.y1 + y,
+				      x_dst + box.x1, y_dst + box.y1 + y))
+	    {
 		continue;
-	    
-	    pixman_rasterize_trapezoid (tmp, trap, - box.x1, - box.y1);
+	    }
+
+	    if (covered || !_pixman_zero_src_has_no_effect[op])
+	    {
+		pixman_image_composite (op, src, tmp, dst,
+					x_src + box.x1, y_src + box.y1 + y,
+					0, 0,
+					x_dst + box.x1, y_dst + box.y1 + y,
+					width, h);
+	    }
+
+	    if (covered)
+	    {
+		memset (tmp->bits.bits, 0,
+			tmp->bits.rowstride * h * sizeof (uint32_t));
+	    }
 	}
-	
-	pixman_image_composite (op, src, tmp, dst,
-				x_src + box.x1, y_src + box.y1,
-				0, 0,
-				x_dst + box.x1, y_dst + box.y1,
-				box.x2 - box.x1, box.y2 - box.y1);
-	
+
 	pixman_image_unref (tmp);
     }
+
+    trap_sweep_fini (&sweep);
 }
 
 static int
@@ -465,6 +465,13 @@ analyze_extent (pixman_image_t       *image,
 	    height = params[1];
 	    break;
 	    
+	case PIXMAN_FILTER_BICUBIC:
+	    x_off = - pixman_fixed_1 * 3 / 2;
+	    y_off = - pixman_fixed_1 * 3 / 2;
+	    width = pixman_fixed_1 * 3;
+	    height = pixman_fixed_1 * 3;
+	    break;
+
 	case PIXMAN_FILTER_GOOD:
 	case PIXMAN_FILTER_BEST:
 	case PIXMAN_FILTER_BILINEAR:
@@ -540,44 +547,80 @@ analyze_extent (pixman_image_t       *image,
     return TRUE;
 }
 
-/*
- * Work around GCC bug causing crashes in Mozilla with SSE2
- *
- * When using -msse, gcc generates movdqa instructions assuming that
- * the stack is 16 byte aligned. Unfortunately some applications, such
- * as Mozilla and Mono, end up aligning the stack to 4 bytes, which
- * causes the movdqa instructions to fail.
- *
- * The __force_align_arg_pointer__ makes gcc generate a prologue that
- * realigns the stack pointer to 16 bytes.
- *
- * On x86-64 this is not necessary because the standard ABI already
- * calls for a 16 byte aligned stack.
- *
- * See https://bugs.freedesktop.org/show_bug.cgi?id=15693
+/* Composite @n boxes in y-x banded order. When the fast path has a
+ * spans function, all the boxes of a band are passed to it at once, so
+ * that clips with many small boxes, such as those of shaped windows,
+ * don't pay for the setup of the fast path once per box.
  */
-#if defined (USE_SSE2) && defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
-__attribute__((__force_align_arg_pointer__))
-#endif
-PIXMAN_EXPORT void
-pixman_image_composite32 (pixman_op_t      op,
-                          pixman_image_t * src,
-                          pixman_image_t * mask,
-                          pixman_image_t * dest,
-                          int32_t          src_x,
-                          int32_t          src_y,
-                          int32_t          mask_x,
-                          int32_t          mask_y,
-                          int32_t          dest_x,
-                          int32_t          dest_y,
-                          int32_t          width,
-                          int32_t          height)
+static void
+composite_boxes (pixman_implementation_t *     imp,
+		 pixman_composite_func_t       func,
+		 pixman_composite_spans_func_t spans,
+		 pixman_composite_info_t *     info,
+		 const pixman_box32_t *        pbox,
+		 int                           n,
+		 int32_t                       src_dx,
+		 int32_t                       src_dy,
+		 int32_t                       mask_dx,
+		 int32_t                       mask_dy)
+{
+    const pixman_box32_t *end = pbox + n;
+
+    while (pbox != end)
+    {
+	const pixman_box32_t *band_end = pbox + 1;
+
+	if (spans)
+	{
+	    while (band_end != end && band_end->y1 == pbox->y1)
+		band_end++;
+	}
+
+	info->src_x = pbox->x1 + src_dx;
+	info->src_y = pbox->y1 + src_dy;
+	info->mask_x = pbox->x1 + mask_dx;
+	info->mask_y = pbox->y1 + mask_dy;
+	info->dest_x = pbox->x1;
+	info->dest_y = pbox->y1;
+	info->width = pbox->x2 - pbox->x1;
+	info->height = pbox->y2 - pbox->y1;
+
+	if (band_end - pbox > 1)
+	    spans (imp, info, pbox, band_end - pbox);
+	else
+	    func (imp, info);
+
+	pbox = band_end;
+    }
+}
+
+/* Composite where the destination is inside @clip, if it isn't NULL.
+ * When nothing but @clip restricts the composite region to something
+ * else than a rectangle, the packed boxes are clipped to that rectangle
+ * one at a time, so a clip with a huge number of boxes is never
+ * expanded.
+ */
+static void
+composite_clipped (pixman_op_t                     op,
+		   pixman_image_t *                src,
+		   pixman_image_t *                mask,
+		   pixman_image_t *                dest,
+		   const pixman_region32_packed_t *clip,
+		   int32_t                         src_x,
+		   int32_t                         src_y,
+		   int32_t                         mask_x,
+		   int32_t                         mask_y,
+		   int32_t                         dest_x,
+		   int32_t                         dest_y,
+		   int32_t                         width,
+		   int32_t                         height)
 {
     pixman_format_code_t src_format, mask_format, dest_format;
     pixman_region32_t region;
     pixman_box32_t extents;
     pixman_implementation_t *imp;
     pixman_composite_func_t func;
+    pixman_composite_spans_func_t spans;
     pixman_composite_info_t info;
     const pixman_box32_t *pbox;
     int n;
@@ -626,6 +669,19 @@ pixman_image_composite32 (pixman_op_t      op,
 	goto out;
     }
 
+    if (clip)
+    {
+	const pixman_box32_t *c = pixman_region32_packed_extents (clip);
+
+	if (!pixman_region32_intersect_rect (&region, &region,
+					     c->x1, c->y1,
+					     c->x2 - c->x1, c->y2 - c->y1) ||
+	    !pixman_region32_not_empty (&region))
+	{
+	    goto out;
+	}
+    }
+
     extents = *pixman_region32_extents (&region);
 
     extents.x1 -= dest_x - src_x;
@@ -673,39 +729,133 @@ pixman_image_composite32 (pixman_op_t      op,
      */
     info.op = optimize_operator (op, info.src_flags, info.mask_flags, info.dest_flags);
 
-    _pixman_implementation_lookup_composite (
+    _pixman_implementation_lookup_composite_spans (
 	get_implementation (), info.op,
 	src_format, info.src_flags,
 	mask_format, info.mask_flags,
 	dest_format, info.dest_flags,
-	&imp, &func);
+	&imp, &func, &spans);
 
     info.src_image = src;
     info.mask_image = mask;
     info.dest_image = dest;
 
-    pbox = pixman_region32_rectangles (&region, &n);
+    if (clip && pixman_region32_n_rects (&region) == 1)
+    {
+	pixman_region_packed_iter_t iter;
+	pixman_box32_t box;
+
+	extents = *pixman_region32_extents (&region);
+
+	pixman_region32_packed_iter_init (&iter, clip);
+	while (pixman_region32_packed_iter_next (&iter, &box))
+	{
+	    if (box.y2 <= extents.y1)
+		continue;
+	    if (box.y1 >= extents.y2)
+		break;
+
+	    box.x1 = MAX (box.x1, extents.x1);
+	    box.y1 = MAX (box.y1, extents.y1);
+	    box.x2 = MIN (box.x2, extents.x2);
+	    box.y2 = MIN (box.y2, extents.y2);
 
-    while (n--)
+	    if (box.x1 < box.x2)
+	    {
+		composite_boxes (imp, func, NULL, &info, &box, 1,
+				 src_x - dest_x, src_y - dest_y,
+				 mask_x - dest_x, mask_y - dest_y);
+	    }
+	}
+
+	goto out;
+    }
+
+    if (clip)
     {
-	info.src_x = pbox->x1 + src_x - dest_x;
-	info.src_y = pbox->y1 + src_y - dest_y;
-	info.mask_x = pbox->x1 + mask_x - dest_x;
-	info.mask_y = pbox->y1 + mask_y - dest_y;
-	info.dest_x = pbox->x1;
-	info.dest_y = pbox->y1;
-	info.width = pbox->x2 - pbox->x1;
-	info.height = pbox->y2 - pbox->y1;
-
-	func (imp, &info);
-
-	pbox++;
+	pixman_region32_t clip_region;
+	pixman_bool_t ok;
+
+	ok = pixman_region32_init_from_packed (&clip_region, clip) &&
+	    pixman_region32_intersect (&region, &region, &clip_region);
+
+	pixman_region32_fini (&clip_region);
+
+	if (!ok)
+	    goto out;
     }
 
+    pbox = pixman_region32_rectangles (&region, &n);
+
+    composite_boxes (imp, func, spans, &info, pbox, n,
+		     src_x - dest_x, src_y - dest_y,
+		     mask_x - dest_x, mask_y - dest_y);
+
 out:
     pixman_region32_fini (&region);
 }
 
+/*
+ * Work around GCC bug causing crashes in Mozilla with SSE2
+ *
+ * When using -msse, gcc generates movdqa instructions assuming that
+ * the stack is 16 byte aligned. Unfortunately some applications, such
+ * as Mozilla and Mono, end up aligning the stack to 4 bytes, which
+ * causes the movdqa instructions to fail.
+ *
+ * The __force_align_arg_pointer__ makes gcc generate a prologue that
+ * realigns the stack pointer to 16 bytes.
+ *
+ * On x86-64 this is not necessary because the standard ABI already
+ * calls for a 16 byte aligned stack.
+ *
+ * See https://bugs.freedesktop.org/show_bug.cgi?id=15693
+ */
+#if defined (USE_SSE2) && defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+PIXMAN_EXPORT void
+pixman_image_composite32 (pixman_op_t      op,
+                          pixman_image_t * src,
+                          pixman_image_t * mask,
+                          pixman_image_t * dest,
+                          int32_t          src_x,
+                          int32_t          src_y,
+                          int32_t          mask_x,
+                          int32_t          mask_y,
+                          int32_t          dest_x,
+                          int32_t          dest_y,
+                          int32_t          width,
+                          int32_t          height)
+{
+    composite_clipped (op, src, mask, dest, NULL,
+		       src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+		       width, height);
+}
+
+#if defined (USE_SSE2) && defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+PIXMAN_EXPORT void
+pixman_image_composite_packed_region32 (pixman_op_t                     op,
+					pixman_image_t *                src,
+					pixman_image_t *                mask,
+					pixman_image_t *                dest,
+					const pixman_region32_packed_t *clip,
+					int32_t                         src_x,
+					int32_t                         src_y,
+					int32_t                         mask_x,
+					int32_t                         mask_y,
+					int32_t                         dest_x,
+					int32_t                         dest_y,
+					int32_t                         width,
+					int32_t                         height)
+{
+    composite_clipped (op, src, mask, dest, clip,
+		       src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+		       width, height);
+}
+
 PIXMAN_EXPORT void
 pixman_image_composite (pixman_op_t      op,
                         pixman_image_t * src,
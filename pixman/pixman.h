@@ -382,7 +382,15 @@ typedef enum
      * is as close as possible to the subpixel location chosen earlier. Then
      * the image is convolved with the matrix and the resulting pixel returned.
      */
-    PIXMAN_FILTER_SEPARABLE_CONVOLUTION
+    PIXMAN_FILTER_SEPARABLE_CONVOLUTION,
+
+    /* The BICUBIC filter samples the 4x4 neighbourhood of the location
+     * with the same Mitchell-Netravali cubic as PIXMAN_KERNEL_CUBIC. It
+     * takes no parameters and is equivalent to a SEPARABLE_CONVOLUTION
+     * filter with a CUBIC reconstruction and an IMPULSE sample kernel,
+     * but without rounding the location to a subpixel phase.
+     */
+    PIXMAN_FILTER_BICUBIC
 } pixman_filter_t;
 
 typedef enum
@@ -455,6 +463,7 @@ typedef enum
  * Regions
  */
 typedef struct pixman_region16_data	pixman_region16_data_t;
+typedef struct pixman_region_packed	pixman_region16_packed_t;
 typedef struct pixman_box16		pixman_box16_t;
 typedef struct pixman_rectangle16	pixman_rectangle16_t;
 typedef struct pixman_region16		pixman_region16_t;
@@ -489,6 +498,27 @@ typedef enum
     PIXMAN_REGION_PART
 } pixman_region_overlap_t;
 
+typedef enum
+{
+    PIXMAN_REGION_OP_UNION,
+    PIXMAN_REGION_OP_INTERSECT,
+    PIXMAN_REGION_OP_SUBTRACT
+} pixman_region_op_t;
+
+/* Packed regions store each band once, followed by the spans of the
+ * band as variable-length deltas, in a fraction of the memory of the
+ * rectangles of a region. They can't be modified, only iterated over
+ * or converted back into regions.
+ *
+ * The iterator is opaque. It only reserves room for the state that
+ * the functions below keep in it.
+ */
+typedef struct
+{
+    const void *	reserved_ptr[4];
+    int32_t		reserved[8];
+} pixman_region_packed_iter_t;
+
 /* This function exists only to make it possible to preserve
  * the X ABI - it should go away at first opportunity.
  */
@@ -521,6 +551,19 @@ PIXMAN_API
 void                    pixman_region_init_from_image    (pixman_region16_t *region,
 							  pixman_image_t    *image);
 
+PIXMAN_API
+pixman_bool_t           pixman_region_rasterize          (pixman_region16_t *region,
+							  pixman_image_t    *image,
+							  int                x,
+							  int                y);
+
+PIXMAN_API
+pixman_bool_t           pixman_region_rasterize_aa       (pixman_region16_t *region,
+							  pixman_image_t    *image,
+							  int                x,
+							  int                y,
+							  int                subpixel_bits);
+
 PIXMAN_API
 void                    pixman_region_fini               (pixman_region16_t *region);
 
@@ -553,6 +596,11 @@ pixman_bool_t           pixman_region_union_rect         (pixman_region16_t *des
 							  unsigned int       width,
 							  unsigned int       height);
 
+PIXMAN_API
+pixman_bool_t           pixman_region_union_rects        (pixman_region16_t *region,
+							  const pixman_box16_t *boxes,
+							  int                count);
+
 PIXMAN_API
 pixman_bool_t		pixman_region_intersect_rect     (pixman_region16_t *dest,
 							  pixman_region16_t *source,
@@ -566,6 +614,16 @@ pixman_bool_t           pixman_region_subtract           (pixman_region16_t *reg
 							  pixman_region16_t *reg_m,
 							  pixman_region16_t *reg_s);
 
+/* Set @dest to ((regions[0] ops[0] regions[1]) ops[1] regions[2]) ...
+ * in a single pass over all the regions. There are @n_regions - 1
+ * operations, and @dest may be one of the regions.
+ */
+PIXMAN_API
+pixman_bool_t           pixman_region_combine            (pixman_region16_t *dest,
+							  int                n_regions,
+							  pixman_region16_t * const *regions,
+							  const pixman_region_op_t *ops);
+
 PIXMAN_API
 pixman_bool_t           pixman_region_inverse            (pixman_region16_t *new_reg,
 							  pixman_region16_t *reg1,
@@ -607,10 +665,36 @@ void                    pixman_region_reset              (pixman_region16_t *reg
 
 PIXMAN_API
 void			pixman_region_clear		 (pixman_region16_t *region);
+
+PIXMAN_API
+pixman_region16_packed_t *pixman_region_pack             (pixman_region16_t *region);
+
+PIXMAN_API
+void                    pixman_region_packed_destroy     (pixman_region16_packed_t *packed);
+
+PIXMAN_API
+int                     pixman_region_packed_size        (const pixman_region16_packed_t *packed);
+
+PIXMAN_API
+const pixman_box16_t *  pixman_region_packed_extents     (const pixman_region16_packed_t *packed);
+
+PIXMAN_API
+pixman_bool_t           pixman_region_init_from_packed   (pixman_region16_t *region,
+							  const pixman_region16_packed_t *packed);
+
+PIXMAN_API
+void                    pixman_region_packed_iter_init   (pixman_region_packed_iter_t *iter,
+							  const pixman_region16_packed_t *packed);
+
+PIXMAN_API
+pixman_bool_t           pixman_region_packed_iter_next   (pixman_region_packed_iter_t *iter,
+							  pixman_box16_t    *box);
 /*
  * 32 bit regions
  */
 typedef struct pixman_region32_data	pixman_region32_data_t;
+typedef struct pixman_region32_packed	pixman_region32_packed_t;
+typedef struct pixman_region32_history	pixman_region32_history_t;
 typedef struct pixman_box32		pixman_box32_t;
 typedef struct pixman_rectangle32	pixman_rectangle32_t;
 typedef struct pixman_region32		pixman_region32_t;
@@ -662,6 +746,19 @@ PIXMAN_API
 void                    pixman_region32_init_from_image    (pixman_region32_t *region,
 							    pixman_image_t    *image);
 
+PIXMAN_API
+pixman_bool_t           pixman_region32_rasterize          (pixman_region32_t *region,
+							    pixman_image_t    *image,
+							    int                x,
+							    int                y);
+
+PIXMAN_API
+pixman_bool_t           pixman_region32_rasterize_aa       (pixman_region32_t *region,
+							    pixman_image_t    *image,
+							    int                x,
+							    int                y,
+							    int                subpixel_bits);
+
 PIXMAN_API
 void                    pixman_region32_fini               (pixman_region32_t *region);
 
@@ -702,11 +799,22 @@ pixman_bool_t           pixman_region32_union_rect         (pixman_region32_t *d
 							    unsigned int       width,
 							    unsigned int       height);
 
+PIXMAN_API
+pixman_bool_t           pixman_region32_union_rects        (pixman_region32_t *region,
+							    const pixman_box32_t *boxes,
+							    int                count);
+
 PIXMAN_API
 pixman_bool_t           pixman_region32_subtract           (pixman_region32_t *reg_d,
 							    pixman_region32_t *reg_m,
 							    pixman_region32_t *reg_s);
 
+PIXMAN_API
+pixman_bool_t           pixman_region32_combine            (pixman_region32_t *dest,
+							    int                n_regions,
+							    pixman_region32_t * const *regions,
+							    const pixman_region_op_t *ops);
+
 PIXMAN_API
 pixman_bool_t           pixman_region32_inverse            (pixman_region32_t *new_reg,
 							    pixman_region32_t *reg1,
@@ -749,6 +857,49 @@ void                    pixman_region32_reset              (pixman_region32_t *r
 PIXMAN_API
 void			pixman_region32_clear		   (pixman_region32_t *region);
 
+PIXMAN_API
+pixman_region32_packed_t *pixman_region32_pack             (pixman_region32_t *region);
+
+PIXMAN_API
+void                    pixman_region32_packed_destroy     (pixman_region32_packed_t *packed);
+
+PIXMAN_API
+int                     pixman_region32_packed_size        (const pixman_region32_packed_t *packed);
+
+PIXMAN_API
+const pixman_box32_t *  pixman_region32_packed_extents     (const pixman_region32_packed_t *packed);
+
+PIXMAN_API
+pixman_bool_t           pixman_region32_init_from_packed   (pixman_region32_t *region,
+							    const pixman_region32_packed_t *packed);
+
+PIXMAN_API
+void                    pixman_region32_packed_iter_init   (pixman_region_packed_iter_t *iter,
+							    const pixman_region32_packed_t *packed);
+
+PIXMAN_API
+pixman_bool_t           pixman_region32_packed_iter_next   (pixman_region_packed_iter_t *iter,
+							    pixman_box32_t    *box);
+
+/* Damage history, for repainting buffers that are several frames old */
+PIXMAN_API
+pixman_region32_history_t *pixman_region32_history_create  (int                        n_frames);
+
+PIXMAN_API
+void                    pixman_region32_history_destroy    (pixman_region32_history_t *history);
+
+PIXMAN_API
+void                    pixman_region32_history_reset      (pixman_region32_history_t *history);
+
+PIXMAN_API
+pixman_bool_t           pixman_region32_history_add        (pixman_region32_history_t *history,
+							    pixman_region32_t         *damage);
+
+PIXMAN_API
+pixman_bool_t           pixman_region32_history_get        (pixman_region32_history_t *history,
+							    int                        age,
+							    pixman_region32_t         *result);
+
 
 /* Copy / Fill / Misc */
 PIXMAN_API
@@ -1112,6 +1263,17 @@ pixman_filter_create_separable_convolution (int             *n_values,
 					    int              subsample_bits_x,
 					    int              subsample_bits_y);
 
+/* Resample all of @src into all of @dest, using @kernel as the
+ * resampling filter in both directions. The transform, filter, repeat
+ * mode, clip and alpha map of both images are ignored; pixels beyond the
+ * edges of @src repeat the edge pixels. Returns FALSE if the images are
+ * not bits images or memory could not be allocated.
+ */
+PIXMAN_API
+pixman_bool_t	pixman_image_resize (pixman_image_t  *src,
+				     pixman_image_t  *dest,
+				     pixman_kernel_t  kernel);
+
 
 PIXMAN_API
 pixman_bool_t	pixman_image_fill_rectangles	     (pixman_op_t		    op,
@@ -1170,6 +1332,24 @@ void          pixman_image_composite32        (pixman_op_t        op,
 					       int32_t            width,
 					       int32_t            height);
 
+/* Like pixman_image_composite32(), but only where the destination is
+ * inside @clip, without converting it back into a region.
+ */
+PIXMAN_API
+void          pixman_image_composite_packed_region32 (pixman_op_t        op,
+						      pixman_image_t    *src,
+						      pixman_image_t    *mask,
+						      pixman_image_t    *dest,
+						      const pixman_region32_packed_t *clip,
+						      int32_t            src_x,
+						      int32_t            src_y,
+						      int32_t            mask_x,
+						      int32_t            mask_y,
+						      int32_t            dest_x,
+						      int32_t            dest_y,
+						      int32_t            width,
+						      int32_t            height);
+
 /* Executive Summary: This function is a no-op that only exists
  * for historical reasons.
  *
@@ -1383,6 +1563,14 @@ void           pixman_rasterize_trapezoid  (pixman_image_t            *image,
 					    int                        x_off,
 					    int                        y_off);
 
+PIXMAN_API
+void           pixman_rasterize_trapezoid_band (pixman_image_t            *image,
+						const pixman_trapezoid_t  *trap,
+						int                        x_off,
+						int                        y_off,
+						int                        y1,
+						int                        y2);
+
 PIXMAN_API
 void          pixman_composite_trapezoids (pixman_op_t		       op,
 					   pixman_image_t *	       src,
@@ -1414,6 +1602,52 @@ void	      pixman_add_triangles       (pixman_image_t              *image,
 					  int	                       n_tris,
 					  const pixman_triangle_t     *tris);
 
+/*
+ * Polygons
+ */
+typedef enum
+{
+    PIXMAN_FILL_RULE_NONZERO,
+    PIXMAN_FILL_RULE_EVEN_ODD
+} pixman_fill_rule_t;
+
+PIXMAN_API
+void          pixman_composite_polygon   (pixman_op_t		       op,
+					  pixman_image_t *	       src,
+					  pixman_image_t *	       dst,
+					  pixman_format_code_t	       mask_format,
+					  int			       x_src,
+					  int			       y_src,
+					  int			       x_dst,
+					  int			       y_dst,
+					  int			       n_points,
+					  const pixman_point_fixed_t * points,
+					  pixman_fill_rule_t	       fill_rule);
+
+PIXMAN_API
+void          pixman_composite_tri_strip (pixman_op_t		       op,
+					  pixman_image_t *	       src,
+					  pixman_image_t *	       dst,
+					  pixman_format_code_t	       mask_format,
+					  int			       x_src,
+					  int			       y_src,
+					  int			       x_dst,
+					  int			       y_dst,
+					  int			       n_points,
+					  const pixman_point_fixed_t * points);
+
+PIXMAN_API
+void          pixman_composite_tri_fan   (pixman_op_t		       op,
+					  pixman_image_t *	       src,
+					  pixman_image_t *	       dst,
+					  pixman_format_code_t	       mask_format,
+					  int			       x_src,
+					  int			       y_src,
+					  int			       x_dst,
+					  int			       y_dst,
+					  int			       n_points,
+					  const pixman_point_fixed_t * points);
+
 PIXMAN_END_DECLS
 
 #endif /* PIXMAN_H__ */
@@ -0,0 +1,282 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "utils.h"
+
+#define WIDTH	48
+#define HEIGHT	32
+
+/* Compare PIXMAN_FILTER_BICUBIC against a double precision evaluation
+ * of the Mitchell-Netravali cubic (B = C = 1/3). The 32 bit paths
+ * round the weights to a few bits and filter the columns with 8
+ * fractional bits, so they may be off by two units per channel; the
+ * floating point path may be off by one.
+ */
+#define NARROW_TOLERANCE	(2 / 255.)
+#define WIDE_TOLERANCE		(1 / 255.)
+
+static const pixman_format_code_t src_formats[] =
+{
+    PIXMAN_a8r8g8b8,		/* fast path fetchers */
+    PIXMAN_x8r8g8b8,
+    PIXMAN_a8b8g8r8,		/* general fetcher */
+};
+
+static const pixman_format_code_t dest_formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_rgba_float,
+};
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+static void
+cubic_weights (double t, double *w)
+{
+    double t2 = t * t;
+    double t3 = t2 * t;
+
+    w[0] = (1 - 9 * t + 15 * t2 - 7 * t3) / 18;
+    w[1] = (16 - 36 * t2 + 21 * t3) / 18;
+    w[2] = (1 + 9 * t + 27 * t2 - 21 * t3) / 18;
+    w[3] = (7 * t3 - 6 * t2) / 18;
+}
+
+static pixman_bool_t
+repeat_coord (pixman_repeat_t repeat, int *c, int size)
+{
+    switch (repeat)
+    {
+    case PIXMAN_REPEAT_NONE:
+	return *c >= 0 && *c < size;
+
+    case PIXMAN_REPEAT_NORMAL:
+	*c = ((*c % size) + size) % size;
+	break;
+
+    case PIXMAN_REPEAT_PAD:
+	*c = *c < 0 ? 0 : (*c >= size ? size - 1 : *c);
+	break;
+
+    case PIXMAN_REPEAT_REFLECT:
+	*c = ((*c % (2 * size)) + 2 * size) % (2 * size);
+	if (*c >= size)
+	    *c = 2 * size - *c - 1;
+	break;
+    }
+
+    return TRUE;
+}
+
+/* Fetch a pixel of the source as a, r, g, b in [0, 1] */
+static void
+fetch_source (pixman_image_t *src, pixman_repeat_t repeat,
+	      int x, int y, double *argb)
+{
+    pixman_format_code_t format = pixman_image_get_format (src);
+    uint32_t *bits = pixman_image_get_data (src);
+    int stride = pixman_image_get_stride (src) / 4;
+    uint32_t p;
+
+    if (!repeat_coord (repeat, &x, pixman_image_get_width (src)) ||
+	!repeat_coord (repeat, &y, pixman_image_get_height (src)))
+    {
+	argb[0] = argb[1] = argb[2] = argb[3] = 0;
+	return;
+    }
+
+    p = bits[y * stride + x];
+
+    if (format == PIXMAN_x8r8g8b8)
+	p |= 0xff000000;
+    else if (format == PIXMAN_a8b8g8r8)
+	p = (p & 0xff00ff00) | ((p >> 16) & 0xff) | ((p & 0xff) << 16);
+
+    argb[0] = ((p >> 24) & 0xff) / 255.;
+    argb[1] = ((p >> 16) & 0xff) / 255.;
+    argb[2] = ((p >> 8) & 0xff) / 255.;
+    argb[3] = ((p >> 0) & 0xff) / 255.;
+}
+
+static void
+reference_pixel (pixman_image_t *src, pixman_repeat_t repeat,
+		 pixman_fixed_t fx, pixman_fixed_t fy, double *result)
+{
+    double x = fx / 65536. - 0.5;
+    double y = fy / 65536. - 0.5;
+    double ix = floor (x), iy = floor (y);
+    double wx[4], wy[4];
+    int i, j, k;
+
+    cubic_weights (x - ix, wx);
+    cubic_weights (y - iy, wy);
+
+    for (k = 0; k < 4; k++)
+	result[k] = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+	for (j = 0; j < 4; j++)
+	{
+	    double argb[4];
+
+	    fetch_source (src, repeat, (int)ix - 1 + j, (int)iy - 1 + i, argb);
+
+	    for (k = 0; k < 4; k++)
+		result[k] += wx[j] * wy[i] * argb[k];
+	}
+    }
+
+    result[0] = result[0] < 0 ? 0 : (result[0] > 1 ? 1 : result[0]);
+    for (k = 1; k < 4; k++)
+	result[k] = result[k] < 0 ? 0 : (result[k] > result[0] ? result[0] : result[k]);
+}
+
+static void
+random_transform (pixman_transform_t *transform)
+{
+    double angle = prng_rand_n (4) ? (prng_rand_n (1000) / 1000. * 2 * M_PI) : 0;
+    double sx = 0.3 + prng_rand_n (1000) / 1000. * 2.7;
+    double sy = prng_rand_n (2) ? sx : 0.3 + prng_rand_n (1000) / 1000. * 2.7;
+
+    pixman_transform_init_identity (transform);
+
+    transform->matrix[0][0] = pixman_double_to_fixed (cos (angle) * sx);
+    transform->matrix[0][1] = pixman_double_to_fixed (-sin (angle) * sx);
+    transform->matrix[1][0] = pixman_double_to_fixed (sin (angle) * sy);
+    transform->matrix[1][1] = pixman_double_to_fixed (cos (angle) * sy);
+    transform->matrix[0][2] = prng_rand_n (64 << 16) - (32 << 16);
+    transform->matrix[1][2] = prng_rand_n (64 << 16) - (32 << 16);
+}
+
+static void
+result_pixel (pixman_image_t *dest, int x, int y, double *argb)
+{
+    int stride = pixman_image_get_stride (dest);
+    uint8_t *line = (uint8_t *)pixman_image_get_data (dest) + y * stride;
+
+    if (pixman_image_get_format (dest) == PIXMAN_rgba_float)
+    {
+	float *f = (float *)line + 4 * x;
+
+	argb[0] = f[3];
+	argb[1] = f[0];
+	argb[2] = f[1];
+	argb[3] = f[2];
+    }
+    else
+    {
+	uint32_t p = ((uint32_t *)line)[x];
+
+	argb[0] = ((p >> 24) & 0xff) / 255.;
+	argb[1] = ((p >> 16) & 0xff) / 255.;
+	argb[2] = ((p >> 8) & 0xff) / 255.;
+	argb[3] = ((p >> 0) & 0xff) / 255.;
+    }
+}
+
+static int
+test_bicubic (pixman_format_code_t src_format,
+	      pixman_format_code_t dest_format,
+	      pixman_repeat_t      repeat)
+{
+    int src_width = 1 + prng_rand_n (40);
+    int src_height = 1 + prng_rand_n (40);
+    double tolerance = dest_format == PIXMAN_rgba_float ?
+	WIDE_TOLERANCE : NARROW_TOLERANCE;
+    pixman_image_t *src, *dest;
+    pixman_transform_t transform;
+    int x, y, k, failed = 0;
+
+    src = pixman_image_create_bits (
+	src_format, src_width, src_height, NULL, 0);
+    prng_randmemset (pixman_image_get_data (src),
+		     pixman_image_get_stride (src) * src_height, 0);
+
+    dest = pixman_image_create_bits (dest_format, WIDTH, HEIGHT, NULL, 0);
+
+    random_transform (&transform);
+    pixman_image_set_transform (src, &transform);
+    pixman_image_set_filter (src, PIXMAN_FILTER_BICUBIC, NULL, 0);
+    pixman_image_set_repeat (src, repeat);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+    for (y = 0; y < HEIGHT && !failed; y++)
+    {
+	pixman_vector_t v;
+
+	/* Step along the scanline as the fetchers do */
+	v.vector[0] = pixman_fixed_1 / 2;
+	v.vector[1] = pixman_int_to_fixed (y) + pixman_fixed_1 / 2;
+	v.vector[2] = pixman_fixed_1;
+
+	if (!pixman_transform_point_3d (&transform, &v))
+	    abort ();
+
+	for (x = 0; x < WIDTH; x++)
+	{
+	    double expected[4], result[4];
+
+	    reference_pixel (src, repeat, v.vector[0], v.vector[1], expected);
+	    result_pixel (dest, x, y, result);
+
+	    for (k = 0; k < 4; k++)
+	    {
+		if (fabs (result[k] - expected[k]) > tolerance)
+		{
+		    printf ("bicubic %s -> %s, repeat %d: pixel %d, %d channel %d "
+			    "is %f, expected %f\n",
+			    format_name (src_format), format_name (dest_format),
+			    repeat, x, y, k, result[k] * 255, expected[k] * 255);
+		    failed = 1;
+		    break;
+		}
+	    }
+
+	    if (failed)
+		break;
+
+	    v.vector[0] += transform.matrix[0][0];
+	    v.vector[1] += transform.matrix[1][0];
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i, j, k, n;
+    int failed = 0;
+
+    prng_srand (0);
+
+    for (n = 0; n < 16; n++)
+    {
+	for (i = 0; i < ARRAY_LENGTH (src_formats); i++)
+	{
+	    for (j = 0; j < ARRAY_LENGTH (dest_formats); j++)
+	    {
+		for (k = 0; k < ARRAY_LENGTH (repeats); k++)
+		{
+		    failed |= test_bicubic (
+			src_formats[i], dest_formats[j], repeats[k]);
+		}
+	    }
+	}
+    }
+
+    return failed;
+}
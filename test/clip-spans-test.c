@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+#define WIDTH	96
+#define HEIGHT	64
+
+typedef struct
+{
+    pixman_op_t			op;
+    int				solid;		/* Solid source, or a8r8g8b8 */
+    pixman_format_code_t	mask_format;	/* Or PIXMAN_null */
+    pixman_format_code_t	dest_format;
+} operation_t;
+
+static const operation_t operations[] =
+{
+    { PIXMAN_OP_SRC,  TRUE,  PIXMAN_null, PIXMAN_a8r8g8b8 },
+    { PIXMAN_OP_SRC,  TRUE,  PIXMAN_null, PIXMAN_x8r8g8b8 },
+    { PIXMAN_OP_SRC,  TRUE,  PIXMAN_null, PIXMAN_r5g6b5 },
+    { PIXMAN_OP_SRC,  TRUE,  PIXMAN_null, PIXMAN_a8 },
+    { PIXMAN_OP_SRC,  FALSE, PIXMAN_null, PIXMAN_a8r8g8b8 },
+    { PIXMAN_OP_OVER, TRUE,  PIXMAN_null, PIXMAN_a8r8g8b8 },
+    { PIXMAN_OP_OVER, TRUE,  PIXMAN_a8,   PIXMAN_a8r8g8b8 },
+    { PIXMAN_OP_OVER, FALSE, PIXMAN_null, PIXMAN_a8r8g8b8 },
+    { PIXMAN_OP_OVER, FALSE, PIXMAN_a8,   PIXMAN_x8r8g8b8 },
+};
+
+static pixman_image_t *
+create_random (pixman_format_code_t format)
+{
+    pixman_image_t *image = pixman_image_create_bits (
+	format, WIDTH, HEIGHT, NULL, 0);
+
+    prng_randmemset (pixman_image_get_data (image),
+		     pixman_image_get_stride (image) * HEIGHT, 0);
+
+    return image;
+}
+
+/* A clip with many narrow boxes in bands of one or a few scanlines, as
+ * the shape of a window with rounded corners or a dithered mask gives.
+ */
+static void
+create_clip (pixman_region32_t *clip)
+{
+    pixman_box32_t boxes[400];
+    int i;
+
+    for (i = 0; i < ARRAY_LENGTH (boxes); i++)
+    {
+	boxes[i].x1 = prng_rand_n (WIDTH + 10) - 5;
+	boxes[i].y1 = prng_rand_n (HEIGHT + 10) - 5;
+	boxes[i].x2 = boxes[i].x1 + 1 + prng_rand_n (prng_rand_n (2) ? 4 : 40);
+	boxes[i].y2 = boxes[i].y1 + 1 + prng_rand_n (3);
+    }
+
+    pixman_region32_init_rects (clip, boxes, ARRAY_LENGTH (boxes));
+}
+
+/* Compositing through a fragmented clip gives the same result as
+ * compositing each box of the clip by itself.
+ */
+static int
+test_operation (const operation_t *operation)
+{
+    pixman_color_t color = { 0x4000, 0x8000, 0xc000, 0xd000 };
+    pixman_image_t *src, *mask = NULL, *dest, *ref;
+    pixman_region32_t clip;
+    const pixman_box32_t *boxes;
+    int src_x = prng_rand_n (20), src_y = prng_rand_n (20);
+    int mask_x = prng_rand_n (20), mask_y = prng_rand_n (20);
+    int dest_x = prng_rand_n (20), dest_y = prng_rand_n (20);
+    int i, n_boxes, failed;
+
+    if (operation->solid)
+	src = pixman_image_create_solid_fill (&color);
+    else
+	src = create_random (PIXMAN_a8r8g8b8);
+
+    if (operation->mask_format != PIXMAN_null)
+	mask = create_random (operation->mask_format);
+
+    dest = create_random (operation->dest_format);
+    ref = pixman_image_create_bits (operation->dest_format, WIDTH, HEIGHT, NULL, 0);
+    memcpy (pixman_image_get_data (ref), pixman_image_get_data (dest),
+	    pixman_image_get_stride (dest) * HEIGHT);
+
+    create_clip (&clip);
+
+    pixman_image_set_clip_region32 (dest, &clip);
+    pixman_image_composite32 (operation->op, src, mask, dest,
+			      src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+			      WIDTH - 20, HEIGHT - 20);
+
+    /* The reference composites the boxes that fall inside the composite
+     * rectangle one at a time.
+     */
+    pixman_region32_intersect_rect (&clip, &clip, dest_x, dest_y,
+				    WIDTH - 20, HEIGHT - 20);
+    pixman_region32_intersect_rect (&clip, &clip, 0, 0, WIDTH, HEIGHT);
+    boxes = pixman_region32_rectangles (&clip, &n_boxes);
+
+    for (i = 0; i < n_boxes; i++)
+    {
+	const pixman_box32_t *b = &boxes[i];
+
+	pixman_image_composite32 (operation->op, src, mask, ref,
+				  src_x + b->x1 - dest_x, src_y + b->y1 - dest_y,
+				  mask_x + b->x1 - dest_x, mask_y + b->y1 - dest_y,
+				  b->x1, b->y1, b->x2 - b->x1, b->y2 - b->y1);
+    }
+
+    failed = memcmp (pixman_image_get_data (ref), pixman_image_get_data (dest),
+		     pixman_image_get_stride (dest) * HEIGHT) != 0;
+
+    if (failed)
+    {
+	printf ("op %d, %s source, mask %08x, dest %08x: mismatch\n",
+		operation->op, operation->solid ? "solid" : "a8r8g8b8",
+		operation->mask_format, operation->dest_format);
+    }
+
+    pixman_region32_fini (&clip);
+    pixman_image_unref (src);
+    if (mask)
+	pixman_image_unref (mask);
+    pixman_image_unref (dest);
+    pixman_image_unref (ref);
+
+    return failed;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    int i, j, failed = FALSE;
+
+    prng_srand (0x510E527F);
+
+    for (i = 0; i < 20; ++i)
+    {
+	for (j = 0; j < ARRAY_LENGTH (operations); ++j)
+	    failed |= test_operation (&operations[j]);
+    }
+
+    return failed;
+}
@@ -0,0 +1,477 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "utils.h"
+#include "pixman-private.h"
+
+#define WIDTH	256
+#define HEIGHT	4
+
+/* Narrow gradient output goes through the colour ramp table and the
+ * SIMD iterators, wide output through the walker and the C iterators in
+ * floating point. Premultiplied narrow channels must be within TOLERANCE
+ * units of the wide ones: half a unit for rounding, and less than one
+ * unit for sampling the ramp at the center of a table entry.
+ */
+#define TOLERANCE	1.5
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+/* Stops a fraction of a table entry to a few entries apart, with the
+ * colour swinging from transparent to opaque in between, and a hard stop.
+ */
+static const pixman_gradient_stop_t steep_stops[] =
+{
+    { pixman_double_to_fixed (0.1),			{ 0x0000, 0x0000, 0x0000, 0x0000 } },
+    { pixman_double_to_fixed (0.1) + 24,		{ 0xffff, 0xffff, 0xffff, 0xffff } },
+    { pixman_double_to_fixed (0.1) + 72,		{ 0x0000, 0x0000, 0x0000, 0x0000 } },
+    { pixman_double_to_fixed (0.3),			{ 0xffff, 0x0000, 0x0000, 0xffff } },
+    { pixman_double_to_fixed (0.3) + 200,		{ 0x0000, 0xffff, 0x0000, 0x8000 } },
+    { pixman_double_to_fixed (0.3) + 1000,		{ 0x0000, 0x0000, 0xffff, 0xffff } },
+    { pixman_double_to_fixed (0.6),			{ 0x0000, 0x0000, 0xffff, 0xffff } },
+    { pixman_double_to_fixed (0.6),			{ 0xffff, 0xffff, 0x0000, 0x4000 } },
+    { pixman_double_to_fixed (0.6) + 600,		{ 0x8000, 0x0000, 0x8000, 0xffff } },
+    { pixman_double_to_fixed (0.9),			{ 0x0000, 0x0000, 0x0000, 0x0000 } },
+};
+
+static int
+compare_pixels (pixman_image_t *narrow, pixman_image_t *wide, const char *name)
+{
+    uint32_t *n = pixman_image_get_data (narrow);
+    float *w = (float *)pixman_image_get_data (wide);
+    int n_stride = pixman_image_get_stride (narrow) / 4;
+    int w_stride = pixman_image_get_stride (wide) / 4;
+    int x, y, k;
+
+    for (y = 0; y < HEIGHT; y++)
+    {
+	for (x = 0; x < WIDTH; x++)
+	{
+	    uint32_t p = n[y * n_stride + x];
+	    const float *f = w + y * w_stride + 4 * x;
+
+	    /* rgba_float is stored r, g, b, a */
+	    double expected[4] = { f[3], f[0], f[1], f[2] };
+
+	    for (k = 0; k < 4; k++)
+	    {
+		int v = (p >> (24 - 8 * k)) & 0xff;
+
+		if (fabs (v - expected[k] * 255.) > TOLERANCE)
+		{
+		    printf ("%s: pixel %d, %d is %08x, channel %d expected %f\n",
+			    name, x, y, p, k, expected[k] * 255.);
+		    return 1;
+		}
+	    }
+	}
+    }
+
+    return 0;
+}
+
+/* The table is built once a gradient has produced 4096 narrow pixels */
+static void
+prepare_table (pixman_image_t *gradient)
+{
+    pixman_image_t *scratch =
+	pixman_image_create_bits (PIXMAN_a8r8g8b8, 64, 64, NULL, 0);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, gradient, NULL, scratch,
+			      0, 0, 0, 0, 0, 0, 64, 64);
+    pixman_image_unref (scratch);
+}
+
+/* Render the same gradient to a narrow and a wide destination */
+static int
+test_gradient (pixman_image_t *gradient, const char *name)
+{
+    pixman_image_t *narrow, *wide;
+    int failed;
+
+    narrow = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, 0);
+    wide = pixman_image_create_bits (PIXMAN_rgba_float, WIDTH, HEIGHT, NULL, 0);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, gradient, NULL, narrow,
+			      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+    pixman_image_composite32 (PIXMAN_OP_SRC, gradient, NULL, wide,
+			      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+    failed = compare_pixels (narrow, wide, name);
+
+    pixman_image_unref (narrow);
+    pixman_image_unref (wide);
+
+    return failed;
+}
+
+/* A linear gradient whose ramp advances by a fraction of a table entry
+ * per pixel, so that every entry around the steep stops is sampled at
+ * many positions. The gradient runs from 0 to 1 in x, so the transform
+ * maps pixels directly to positions in the ramp.
+ */
+static int
+test_steep_stops (pixman_repeat_t repeat)
+{
+    static const double starts[] = { 0.1, 0.3, 0.6, 1.1, 1.6 };
+    pixman_point_fixed_t p1 = { 0, 0 };
+    pixman_point_fixed_t p2 = { pixman_fixed_1, 0 };
+    pixman_transform_t transform;
+    pixman_image_t *gradient;
+    char name[64];
+    int i, j, failed = 0;
+
+    gradient = pixman_image_create_linear_gradient (
+	&p1, &p2, steep_stops, ARRAY_LENGTH (steep_stops));
+    pixman_image_set_repeat (gradient, repeat);
+    prepare_table (gradient);
+
+    for (i = 0; i < ARRAY_LENGTH (starts); i++)
+    {
+	/* 1/16, 1/4 and 1 table entry per pixel */
+	for (j = 0; j < 3; j++)
+	{
+	    pixman_fixed_t step = 1 << (2 * j);
+
+	    pixman_transform_init_identity (&transform);
+	    transform.matrix[0][0] = step;
+	    transform.matrix[0][2] =
+		pixman_double_to_fixed (starts[i]) - 32 * step;
+	    pixman_image_set_transform (gradient, &transform);
+
+	    snprintf (name, sizeof (name),
+		      "steep stops, repeat %d, start %g, step %d",
+		      repeat, starts[i], step);
+	    failed |= test_gradient (gradient, name);
+	}
+    }
+
+    pixman_image_unref (gradient);
+
+    return failed;
+}
+
+/* Fetch the gradient through the first iterator that @imp or its
+ * fallbacks have for it, the way _pixman_implementation_iter_init()
+ * picks one. The image must have been validated by compositing it.
+ */
+static void
+fetch_gradient (pixman_implementation_t *imp, pixman_image_t *image,
+		iter_flags_t iter_flags, uint32_t *result)
+{
+    int n = (iter_flags & ITER_NARROW) ? 1 : 4;
+    uint32_t buffer[WIDTH * 4];
+    const pixman_iter_info_t *info;
+    pixman_iter_t iter;
+    int y;
+
+    for (; imp; imp = imp->fallback)
+    {
+	for (info = imp->iter_info; info && info->format != PIXMAN_null; ++info)
+	{
+	    if ((info->format == PIXMAN_any ||
+		 info->format == image->common.extended_format_code) &&
+		(info->image_flags & image->common.flags) == info->image_flags &&
+		(info->iter_flags & iter_flags) == info->iter_flags)
+	    {
+		goto found;
+	    }
+	}
+    }
+
+    abort ();
+
+found:
+    memset (&iter, 0, sizeof (iter));
+    iter.image = image;
+    iter.buffer = buffer;
+    iter.width = WIDTH;
+    iter.height = HEIGHT;
+    iter.iter_flags = iter_flags;
+    iter.image_flags = image->common.flags;
+    iter.get_scanline = info->get_scanline;
+    iter.write_back = info->write_back;
+
+    if (info->initializer)
+	info->initializer (&iter, info);
+
+    for (y = 0; y < HEIGHT; y++)
+    {
+	memcpy (result + y * WIDTH * n,
+		iter.get_scanline (&iter, NULL), WIDTH * n * 4);
+    }
+
+    if (iter.fini)
+	iter.fini (&iter);
+}
+
+/* The C iterators of the general implementation are the reference for
+ * the SIMD ones. Channels, narrow or scaled to 255 if wide, may differ
+ * by at most @tolerance.
+ */
+static int
+compare_iterators (pixman_image_t *gradient, iter_flags_t iter_flags,
+		   double tolerance, const char *name)
+{
+    pixman_implementation_t *imp = _pixman_internal_only_get_implementation ();
+    pixman_implementation_t *general = imp;
+    int n = (iter_flags & ITER_NARROW) ? 1 : 4;
+    uint32_t *fast = malloc (WIDTH * HEIGHT * n * 4);
+    uint32_t *reference = malloc (WIDTH * HEIGHT * n * 4);
+    int i, k, failed = 0;
+
+    while (general->fallback)
+	general = general->fallback;
+
+    fetch_gradient (imp, gradient, iter_flags | ITER_SRC, fast);
+    fetch_gradient (general, gradient, iter_flags | ITER_SRC, reference);
+
+    for (i = 0; i < WIDTH * HEIGHT && !failed; i++)
+    {
+	for (k = 0; k < 4; k++)
+	{
+	    double f, r;
+
+	    if (n == 1)
+	    {
+		f = (fast[i] >> (24 - 8 * k)) & 0xff;
+		r = (reference[i] >> (24 - 8 * k)) & 0xff;
+	    }
+	    else
+	    {
+		f = ((float *)fast)[4 * i + k] * 255.;
+		r = ((float *)reference)[4 * i + k] * 255.;
+	    }
+
+	    if (fabs (f - r) > tolerance)
+	    {
+		printf ("%s, %s: pixel %d, %d channel %d is %f, expected %f\n",
+			name, n == 1 ? "narrow" : "wide",
+			i % WIDTH, i / WIDTH, k, f, r);
+		failed = 1;
+		break;
+	    }
+	}
+    }
+
+    free (fast);
+    free (reference);
+
+    return failed;
+}
+
+/* Compare the iterators on @gradient without its colour ramp table,
+ * and again once it has one.
+ */
+static int
+test_iterators (pixman_image_t *gradient, double tolerance, const char *name)
+{
+    pixman_image_t *dest =
+	pixman_image_create_bits (PIXMAN_a8r8g8b8, 1, 1, NULL, 0);
+    int failed = 0;
+
+    /* Validate the image */
+    pixman_image_composite32 (PIXMAN_OP_SRC, gradient, NULL, dest,
+			      0, 0, 0, 0, 0, 0, 1, 1);
+    pixman_image_unref (dest);
+
+    failed |= compare_iterators (gradient, ITER_NARROW, tolerance, name);
+    failed |= compare_iterators (gradient, ITER_WIDE, tolerance, name);
+
+    prepare_table (gradient);
+
+    failed |= compare_iterators (gradient, ITER_NARROW, tolerance, name);
+
+    return failed;
+}
+
+/* Random stops in increasing order */
+static void
+random_stops (pixman_gradient_stop_t *stops, int n_stops)
+{
+    int i, j;
+
+    for (i = 0; i < n_stops; i++)
+    {
+	pixman_fixed_t x = prng_rand_n (pixman_fixed_1 + 1);
+
+	for (j = i; j > 0 && stops[j - 1].x > x; j--)
+	    stops[j].x = stops[j - 1].x;
+
+	stops[j].x = x;
+    }
+
+    for (i = 0; i < n_stops; i++)
+    {
+	stops[i].color.alpha = prng_rand_n (0x10000);
+	stops[i].color.red = prng_rand_n (0x10000);
+	stops[i].color.green = prng_rand_n (0x10000);
+	stops[i].color.blue = prng_rand_n (0x10000);
+    }
+}
+
+static pixman_fixed_t
+random_coord (int lo, int hi)
+{
+    return pixman_int_to_fixed (lo) + prng_rand_n (pixman_int_to_fixed (hi - lo));
+}
+
+/* Scaled, rotated and translated, or no transform at all */
+static void
+random_transform (pixman_image_t *image)
+{
+    pixman_transform_t transform;
+    double angle = prng_rand_n (1000) / 1000. * 2 * M_PI;
+    double scale = 0.25 + prng_rand_n (1000) / 1000. * 3.75;
+
+    if (!prng_rand_n (4))
+    {
+	pixman_image_set_transform (image, NULL);
+	return;
+    }
+
+    pixman_transform_init_identity (&transform);
+    transform.matrix[0][0] = pixman_double_to_fixed (cos (angle) * scale);
+    transform.matrix[0][1] = pixman_double_to_fixed (-sin (angle) * scale);
+    transform.matrix[1][0] = pixman_double_to_fixed (sin (angle) * scale);
+    transform.matrix[1][1] = pixman_double_to_fixed (cos (angle) * scale);
+    transform.matrix[0][2] = random_coord (-256, 256);
+    transform.matrix[1][2] = random_coord (-256, 256);
+
+    pixman_image_set_transform (image, &transform);
+}
+
+static int
+test_linear (pixman_repeat_t repeat)
+{
+    pixman_gradient_stop_t stops[6];
+    int n_stops = 2 + prng_rand_n (5);
+    pixman_point_fixed_t p1, p2;
+    pixman_image_t *gradient;
+    char name[64];
+    int failed;
+
+    random_stops (stops, n_stops);
+    p1.x = random_coord (-64, 320);
+    p1.y = random_coord (-64, 64);
+    p2.x = random_coord (-64, 320);
+    p2.y = random_coord (-64, 64);
+
+    gradient = pixman_image_create_linear_gradient (&p1, &p2, stops, n_stops);
+    pixman_image_set_repeat (gradient, repeat);
+    random_transform (gradient);
+
+    /* The parameter is computed exactly as in linear_get_scanline () */
+    snprintf (name, sizeof (name), "linear, repeat %d", repeat);
+    failed = test_iterators (gradient, 0, name);
+
+    pixman_image_unref (gradient);
+
+    return failed;
+}
+
+static int
+test_radial (pixman_repeat_t repeat)
+{
+    pixman_gradient_stop_t stops[6];
+    int n_stops = 2 + prng_rand_n (5);
+    pixman_point_fixed_t inner, outer;
+    pixman_fixed_t inner_radius, outer_radius;
+    pixman_image_t *gradient;
+    char name[64];
+    int failed;
+
+    random_stops (stops, n_stops);
+    inner.x = random_coord (-64, 320);
+    inner.y = random_coord (-64, 64);
+    outer.x = random_coord (-64, 320);
+    outer.y = random_coord (-64, 64);
+    inner_radius = random_coord (0, 64);
+    outer_radius = random_coord (0, 256);
+
+    gradient = pixman_image_create_radial_gradient (
+	&inner, &outer, inner_radius, outer_radius, stops, n_stops);
+    pixman_image_set_repeat (gradient, repeat);
+    random_transform (gradient);
+
+    /* B and C are exact in double precision, see pixman-sse2.c */
+    snprintf (name, sizeof (name), "radial, repeat %d", repeat);
+    failed = test_iterators (gradient, 0, name);
+
+    pixman_image_unref (gradient);
+
+    return failed;
+}
+
+static int
+test_conical (pixman_repeat_t repeat)
+{
+    pixman_gradient_stop_t stops[6];
+    int n_stops = 2 + prng_rand_n (5);
+    pixman_point_fixed_t center;
+    pixman_fixed_t angle;
+    pixman_image_t *gradient;
+    char name[64];
+    int i, failed;
+
+    /* Evenly spaced stops, so that a step of the parameter changes the
+     * colour by less than a unit. The parameter wraps from 1 back to 0
+     * along a ray from the center; where the two iterators put a pixel
+     * on different sides of it, the colour would jump, so the ramp ends
+     * with the colour it starts with.
+     */
+    random_stops (stops, n_stops);
+    for (i = 0; i < n_stops; i++)
+	stops[i].x = i * pixman_fixed_1 / (n_stops - 1);
+    stops[n_stops - 1].color = stops[0].color;
+
+    center.x = random_coord (-64, 320);
+    center.y = random_coord (-64, 64);
+    angle = random_coord (-720, 720);
+
+    gradient = pixman_image_create_conical_gradient (
+	&center, angle, stops, n_stops);
+    pixman_image_set_repeat (gradient, repeat);
+    random_transform (gradient);
+
+    /* The SSE2 iterator approximates atan2 () to within one step of the
+     * parameter.
+     */
+    snprintf (name, sizeof (name), "conical, repeat %d", repeat);
+    failed = test_iterators (gradient, 1, name);
+
+    pixman_image_unref (gradient);
+
+    return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i, n;
+    int failed = 0;
+
+    prng_srand (0);
+
+    for (i = 0; i < ARRAY_LENGTH (repeats); i++)
+	failed |= test_steep_stops (repeats[i]);
+
+    for (n = 0; n < 64; n++)
+    {
+	for (i = 0; i < ARRAY_LENGTH (repeats); i++)
+	{
+	    failed |= test_linear (repeats[i]);
+	    failed |= test_radial (repeats[i]);
+	    failed |= test_conical (repeats[i]);
+	}
+    }
+
+    return failed;
+}
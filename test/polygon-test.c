@@ -0,0 +1,314 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "utils.h"
+
+#define WIDTH	32
+#define HEIGHT	32
+
+/* Render the polygon with ADD into a cleared a8 image */
+static pixman_image_t *
+render (int n_points, const pixman_point_fixed_t *points,
+	pixman_fill_rule_t fill_rule, pixman_format_code_t mask_format)
+{
+    pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_image_t *src = pixman_image_create_solid_fill (&white);
+    pixman_image_t *dest = pixman_image_create_bits (
+	PIXMAN_a8, WIDTH, HEIGHT, NULL, 0);
+
+    pixman_composite_polygon (PIXMAN_OP_ADD, src, dest, mask_format,
+			      0, 0, 0, 0, n_points, points, fill_rule);
+
+    pixman_image_unref (src);
+
+    return dest;
+}
+
+static int
+pixel (pixman_image_t *image, int x, int y)
+{
+    uint8_t *bits = (uint8_t *)pixman_image_get_data (image);
+
+    return bits[y * pixman_image_get_stride (image) + x];
+}
+
+/* Check every pixel against @expected, which gives the value inside the
+ * box [x1, x2) x [y1, y2) and zero outside.
+ */
+static int
+check_box (const char *name, pixman_image_t *image,
+	   int x1, int y1, int x2, int y2, int expected, int tolerance)
+{
+    int x, y;
+
+    for (y = 0; y < HEIGHT; ++y)
+    {
+	for (x = 0; x < WIDTH; ++x)
+	{
+	    int e = (x >= x1 && x < x2 && y >= y1 && y < y2)? expected : 0;
+	    int p = pixel (image, x, y);
+
+	    if (abs (p - e) > tolerance)
+	    {
+		printf ("%s: at %d, %d expected %d, got %d\n", name, x, y, e, p);
+		return TRUE;
+	    }
+	}
+    }
+
+    return FALSE;
+}
+
+#define P(x, y) { pixman_double_to_fixed (x), pixman_double_to_fixed (y) }
+
+static int
+test_rectangles (void)
+{
+    static const pixman_point_fixed_t aligned[] =
+    {
+	P (4, 5), P (20, 5), P (20, 17), P (4, 17)
+    };
+    static const pixman_point_fixed_t reversed[] =
+    {
+	P (4, 5), P (4, 17), P (20, 17), P (20, 5)
+    };
+    static const pixman_point_fixed_t half[] =
+    {
+	P (4.5, 5), P (5, 5), P (5, 17), P (4.5, 17)
+    };
+    static const pixman_point_fixed_t clipped[] =
+    {
+	P (-10, -10), P (50, -10), P (50, 50), P (-10, 50)
+    };
+    pixman_image_t *image;
+    int failed = FALSE;
+
+    image = render (4, aligned, PIXMAN_FILL_RULE_NONZERO, PIXMAN_a8);
+    failed |= check_box ("aligned", image, 4, 5, 20, 17, 255, 0);
+    pixman_image_unref (image);
+
+    image = render (4, reversed, PIXMAN_FILL_RULE_NONZERO, PIXMAN_a8);
+    failed |= check_box ("reversed", image, 4, 5, 20, 17, 255, 0);
+    pixman_image_unref (image);
+
+    image = render (4, aligned, PIXMAN_FILL_RULE_EVEN_ODD, PIXMAN_a4);
+    failed |= check_box ("a4", image, 4, 5, 20, 17, 255, 0);
+    pixman_image_unref (image);
+
+    image = render (4, half, PIXMAN_FILL_RULE_NONZERO, PIXMAN_a8);
+    failed |= check_box ("half", image, 4, 5, 5, 17, 128, 1);
+    pixman_image_unref (image);
+
+    image = render (4, clipped, PIXMAN_FILL_RULE_NONZERO, PIXMAN_a8);
+    failed |= check_box ("clipped", image, 0, 0, WIDTH, HEIGHT, 255, 0);
+    pixman_image_unref (image);
+
+    return failed;
+}
+
+/* A square that winds twice is filled by the nonzero rule only */
+static int
+test_fill_rules (void)
+{
+    static const pixman_point_fixed_t twice[] =
+    {
+	P (8, 8), P (24, 8), P (24, 24), P (8, 24),
+	P (8, 8), P (24, 8), P (24, 24), P (8, 24)
+    };
+    pixman_image_t *image;
+    int failed = FALSE;
+
+    image = render (8, twice, PIXMAN_FILL_RULE_NONZERO, PIXMAN_a8);
+    failed |= check_box ("nonzero", image, 8, 8, 24, 24, 255, 0);
+    pixman_image_unref (image);
+
+    image = render (8, twice, PIXMAN_FILL_RULE_EVEN_ODD, PIXMAN_a8);
+    failed |= check_box ("even-odd", image, 8, 8, 24, 24, 0, 0);
+    pixman_image_unref (image);
+
+    return failed;
+}
+
+static double
+total_coverage (pixman_image_t *image)
+{
+    double sum = 0.0;
+    int x, y;
+
+    for (y = 0; y < HEIGHT; ++y)
+    {
+	for (x = 0; x < WIDTH; ++x)
+	    sum += pixel (image, x, y) / 255.0;
+    }
+
+    return sum;
+}
+
+/* The total coverage of a random triangle, partly outside of the image,
+ * agrees with the sampling trapezoid rasterizer.
+ */
+static int
+test_triangles (void)
+{
+    pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_image_t *src = pixman_image_create_solid_fill (&white);
+    int i, j, failed = FALSE;
+
+    for (i = 0; i < 200; ++i)
+    {
+	pixman_point_fixed_t points[3];
+	pixman_triangle_t tri;
+	pixman_image_t *image;
+	double expected, actual;
+
+	for (j = 0; j < 3; ++j)
+	{
+	    points[j].x = prng_rand_n (pixman_int_to_fixed (WIDTH + 8)) -
+		pixman_int_to_fixed (4);
+	    points[j].y = prng_rand_n (pixman_int_to_fixed (HEIGHT + 8)) -
+		pixman_int_to_fixed (4);
+	}
+
+	image = render (3, points, PIXMAN_FILL_RULE_NONZERO, PIXMAN_a8);
+	actual = total_coverage (image);
+	pixman_image_unref (image);
+
+	tri.p1 = points[0];
+	tri.p2 = points[1];
+	tri.p3 = points[2];
+
+	image = pixman_image_create_bits (PIXMAN_a8, WIDTH, HEIGHT, NULL, 0);
+	pixman_composite_triangles (PIXMAN_OP_ADD, src, image, PIXMAN_a8,
+				    0, 0, 0, 0, 1, &tri);
+	expected = total_coverage (image);
+	pixman_image_unref (image);
+
+	if (fabs (actual - expected) > 1.0 + expected * 0.02)
+	{
+	    printf ("triangle %d: coverage %f, trapezoids give %f\n",
+		    i, actual, expected);
+	    failed = TRUE;
+	}
+    }
+
+    pixman_image_unref (src);
+
+    return failed;
+}
+
+/* A strip and a fan that tile a rectangle cover it without seams */
+static int
+test_meshes (void)
+{
+    static const pixman_point_fixed_t strip[] =
+    {
+	P (4, 5), P (4, 17), P (9.5, 5), P (12.25, 17), P (20, 5), P (20, 17)
+    };
+    static const pixman_point_fixed_t fan[] =
+    {
+	P (11.3, 9.7), P (4, 5), P (20, 5), P (20, 17), P (4, 17), P (4, 5)
+    };
+    pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_image_t *src = pixman_image_create_solid_fill (&white);
+    pixman_image_t *image;
+    int failed = FALSE;
+
+    image = pixman_image_create_bits (PIXMAN_a8, WIDTH, HEIGHT, NULL, 0);
+    pixman_composite_tri_strip (PIXMAN_OP_ADD, src, image, PIXMAN_a8,
+				0, 0, 0, 0, ARRAY_LENGTH (strip), strip);
+    failed |= check_box ("strip", image, 4, 5, 20, 17, 255, 0);
+    pixman_image_unref (image);
+
+    image = pixman_image_create_bits (PIXMAN_a8, WIDTH, HEIGHT, NULL, 0);
+    pixman_composite_tri_fan (PIXMAN_OP_ADD, src, image, PIXMAN_a8,
+			      0, 0, 0, 0, ARRAY_LENGTH (fan), fan);
+    failed |= check_box ("fan", image, 4, 5, 20, 17, 255, 0);
+    pixman_image_unref (image);
+
+    pixman_image_unref (src);
+
+    return failed;
+}
+
+/* Random strips and fans, which may fold over themselves, add up the
+ * coverage of their triangles.
+ */
+static int
+test_random_meshes (void)
+{
+    pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_image_t *src = pixman_image_create_solid_fill (&white);
+    int i, j, failed = FALSE;
+
+    for (i = 0; i < 200; ++i)
+    {
+	pixman_point_fixed_t points[8];
+	pixman_triangle_t tris[6];
+	pixman_image_t *image;
+	int n_points = 3 + prng_rand_n (6);
+	int is_fan = prng_rand_n (2);
+	double expected, actual;
+
+	for (j = 0; j < n_points; ++j)
+	{
+	    points[j].x = prng_rand_n (pixman_int_to_fixed (WIDTH + 8)) -
+		pixman_int_to_fixed (4);
+	    points[j].y = prng_rand_n (pixman_int_to_fixed (HEIGHT + 8)) -
+		pixman_int_to_fixed (4);
+	}
+
+	for (j = 0; j < n_points - 2; ++j)
+	{
+	    tris[j].p1 = points[is_fan ? 0 : j];
+	    tris[j].p2 = points[j + 1];
+	    tris[j].p3 = points[j + 2];
+	}
+
+	image = pixman_image_create_bits (PIXMAN_a8, WIDTH, HEIGHT, NULL, 0);
+	if (is_fan)
+	{
+	    pixman_composite_tri_fan (PIXMAN_OP_ADD, src, image, PIXMAN_a8,
+				      0, 0, 0, 0, n_points, points);
+	}
+	else
+	{
+	    pixman_composite_tri_strip (PIXMAN_OP_ADD, src, image, PIXMAN_a8,
+					0, 0, 0, 0, n_points, points);
+	}
+	actual = total_coverage (image);
+	pixman_image_unref (image);
+
+	image = pixman_image_create_bits (PIXMAN_a8, WIDTH, HEIGHT, NULL, 0);
+	pixman_composite_triangles (PIXMAN_OP_ADD, src, image, PIXMAN_a8,
+				    0, 0, 0, 0, n_points - 2, tris);
+	expected = total_coverage (image);
+	pixman_image_unref (image);
+
+	if (fabs (actual - expected) > (n_points - 2) + expected * 0.02)
+	{
+	    printf ("%s %d: coverage %f, triangles give %f\n",
+		    is_fan ? "fan" : "strip", i, actual, expected);
+	    failed = TRUE;
+	}
+    }
+
+    pixman_image_unref (src);
+
+    return failed;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    int failed = FALSE;
+
+    prng_srand (0x6A09E667);
+
+    failed |= test_rectangles ();
+    failed |= test_fill_rules ();
+    failed |= test_triangles ();
+    failed |= test_meshes ();
+    failed |= test_random_meshes ();
+
+    return failed;
+}
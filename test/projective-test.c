@@ -0,0 +1,198 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "utils.h"
+
+#define WIDTH	32
+#define HEIGHT	32
+
+/* The fast path has projective fetchers for a8r8g8b8 only; a8b8g8r8
+ * with the same bytes goes through the general fetcher. Both have to
+ * produce identical pixels, also for source coordinates close to the
+ * edge of the 16.16 range.
+ */
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+static const pixman_filter_t filters[] =
+{
+    PIXMAN_FILTER_NEAREST,
+    PIXMAN_FILTER_BILINEAR,
+};
+
+static double
+random_double (double lo, double hi)
+{
+    return lo + (hi - lo) * prng_rand_n (1 << 20) / (1 << 20);
+}
+
+/* Whether the destination, grown by a pixel as pixman_image_composite()
+ * checks it, maps to the source with w > 0 and coordinates no further
+ * than limit pixels from the origin. The map is projective, so checking
+ * the corners is enough.
+ */
+static pixman_bool_t
+transform_in_range (const pixman_transform_t *t, double limit)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+	double x = (i & 1) ? WIDTH + 1 : -1;
+	double y = (i & 2) ? HEIGHT + 1 : -1;
+	double m[3][3];
+	double tx, ty, tw;
+	int j, k;
+
+	for (j = 0; j < 3; j++)
+	{
+	    for (k = 0; k < 3; k++)
+		m[j][k] = pixman_fixed_to_double (t->matrix[j][k]);
+	}
+
+	tx = m[0][0] * x + m[0][1] * y + m[0][2];
+	ty = m[1][0] * x + m[1][1] * y + m[1][2];
+	tw = m[2][0] * x + m[2][1] * y + m[2][2];
+
+	if (tw < 0.01 || tx / tw > limit || tx / tw < -limit ||
+	    ty / tw > limit || ty / tw < -limit)
+	{
+	    return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
+static void
+random_transform (pixman_transform_t *t)
+{
+    do
+    {
+	pixman_transform_init_identity (t);
+
+	if (prng_rand_n (2))
+	{
+	    /* Anything with a visible perspective */
+	    t->matrix[0][0] = pixman_double_to_fixed (random_double (-3, 3));
+	    t->matrix[0][1] = pixman_double_to_fixed (random_double (-3, 3));
+	    t->matrix[0][2] = pixman_double_to_fixed (random_double (-50, 50));
+	    t->matrix[1][0] = pixman_double_to_fixed (random_double (-3, 3));
+	    t->matrix[1][1] = pixman_double_to_fixed (random_double (-3, 3));
+	    t->matrix[1][2] = pixman_double_to_fixed (random_double (-50, 50));
+	    t->matrix[2][0] = pixman_double_to_fixed (random_double (-0.05, 0.05));
+	    t->matrix[2][1] = pixman_double_to_fixed (random_double (-0.05, 0.05));
+	}
+	else
+	{
+	    /* Far away from the origin, close to the largest coordinate
+	     * a 16.16 fixed point number can hold.
+	     */
+	    double sign_x = prng_rand_n (2) ? 1 : -1;
+	    double sign_y = prng_rand_n (2) ? 1 : -1;
+
+	    t->matrix[0][2] = pixman_double_to_fixed (
+		sign_x * random_double (28000, 32700));
+	    t->matrix[1][2] = pixman_double_to_fixed (
+		sign_y * random_double (28000, 32700));
+	    t->matrix[2][0] = pixman_double_to_fixed (random_double (0, 0.001));
+	    t->matrix[2][1] = pixman_double_to_fixed (random_double (0, 0.001));
+	}
+
+	if (!t->matrix[2][0] && !t->matrix[2][1])
+	    t->matrix[2][0] = 1;
+    }
+    while (!transform_in_range (t, 32760));
+}
+
+static pixman_image_t *
+create_source (pixman_format_code_t format, uint32_t *bits,
+	       int width, int height,
+	       pixman_transform_t *transform,
+	       pixman_repeat_t repeat, pixman_filter_t filter)
+{
+    pixman_image_t *image = pixman_image_create_bits (
+	format, width, height, bits, width * 4);
+
+    pixman_image_set_transform (image, transform);
+    pixman_image_set_repeat (image, repeat);
+    pixman_image_set_filter (image, filter, NULL, 0);
+
+    return image;
+}
+
+static int
+test_projective (pixman_repeat_t repeat, pixman_filter_t filter)
+{
+    int width = 1 + prng_rand_n (40);
+    int height = 1 + prng_rand_n (40);
+    uint32_t *src_bits = malloc (width * height * 4);
+    uint32_t fast_bits[WIDTH * HEIGHT], general_bits[WIDTH * HEIGHT];
+    pixman_image_t *src, *dest;
+    pixman_transform_t transform;
+    int i, failed = 0;
+
+    prng_randmemset (src_bits, width * height * 4, 0);
+    memset (fast_bits, 0, sizeof (fast_bits));
+    memset (general_bits, 0, sizeof (general_bits));
+    random_transform (&transform);
+
+    src = create_source (PIXMAN_a8r8g8b8, src_bits, width, height,
+			 &transform, repeat, filter);
+    dest = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, WIDTH, HEIGHT, fast_bits, WIDTH * 4);
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    src = create_source (PIXMAN_a8b8g8r8, src_bits, width, height,
+			 &transform, repeat, filter);
+    dest = pixman_image_create_bits (
+	PIXMAN_a8b8g8r8, WIDTH, HEIGHT, general_bits, WIDTH * 4);
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    for (i = 0; i < WIDTH * HEIGHT; i++)
+    {
+	if (fast_bits[i] != general_bits[i])
+	{
+	    printf ("filter %d, repeat %d: pixel %d, %d is %08x, expected %08x\n",
+		    filter, repeat, i % WIDTH, i / WIDTH,
+		    fast_bits[i], general_bits[i]);
+	    failed = 1;
+	    break;
+	}
+    }
+
+    free (src_bits);
+
+    return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i, j, n;
+    int failed = 0;
+
+    prng_srand (0);
+
+    for (n = 0; n < 100; n++)
+    {
+	for (i = 0; i < ARRAY_LENGTH (repeats); i++)
+	{
+	    for (j = 0; j < ARRAY_LENGTH (filters); j++)
+		failed |= test_projective (repeats[i], filters[j]);
+	}
+    }
+
+    return failed;
+}
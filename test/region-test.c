@@ -3,12 +3,23 @@
 #include <stdio.h>
 #include "utils.h"
 
+/* Empty regions are equal whatever their extents */
+static pixman_bool_t
+same_region (pixman_region32_t *a, pixman_region32_t *b)
+{
+    if (!pixman_region32_not_empty (a))
+	return !pixman_region32_not_empty (b);
+
+    return pixman_region32_equal (a, b);
+}
+
 int
 main ()
 {
     pixman_region32_t r1;
     pixman_region32_t r2;
     pixman_region32_t r3;
+    pixman_region32_t r4;
     pixman_box32_t boxes[] = {
 	{ 10, 10, 20, 20 },
 	{ 30, 30, 30, 40 },
@@ -23,14 +34,21 @@ main ()
 	{ 4, 1, 6, 1 },
     };
     int i, j;
+    pixman_bool_t ok;
     pixman_box32_t *b;
-    pixman_image_t *image, *fill;
+    pixman_image_t *image, *fill, *half;
     pixman_color_t white = {
 	0xffff,
 	0xffff,
 	0xffff,
 	0xffff
     };
+    pixman_color_t threshold = {
+	0x8080,
+	0x8080,
+	0x8080,
+	0x8080
+    };
 
     prng_srand (0);
 
@@ -84,6 +102,7 @@ main ()
     assert (i == 0);
 
     fill = pixman_image_create_solid_fill (&white);
+    half = pixman_image_create_solid_fill (&threshold);
     for (i = 0; i < 100; i++)
     {
 	int image_size = 128;
@@ -114,12 +133,499 @@ main ()
 
 	pixman_image_unref (image);
 
+	assert (pixman_region32_equal (&r1, &r2));
+	pixman_region32_fini (&r2);
+
+	/* render region to a8 mask, of a width that isn't a multiple of
+	 * 32, on a background that is below the threshold. Every other
+	 * time, the background is 0x7f and the region is filled with
+	 * 0x80, right at either side of the threshold.
+	 */
+	pixman_region32_init_rect (&r2, 0, 0, image_size - i % 31, image_size);
+	pixman_region32_intersect (&r1, &r1, &r2);
+	pixman_region32_fini (&r2);
+
+	image = pixman_image_create_bits (
+	    PIXMAN_a8, image_size - i % 31, image_size, NULL, 0);
+	for (j = 0; j < pixman_image_get_stride (image) * image_size; j++)
+	{
+	    ((uint8_t *)pixman_image_get_data (image))[j] =
+		(i % 2)? 0x7f : prng_rand_n (0x80);
+	}
+	pixman_image_set_clip_region32 (image, &r1);
+	pixman_image_composite32 (PIXMAN_OP_SRC,
+				  (i % 2)? half : fill, NULL, image,
+				  0, 0, 0, 0, 0, 0,
+				  image_size, image_size);
+	pixman_region32_init_from_image (&r2, image);
+
+	pixman_image_unref (image);
+
 	assert (pixman_region32_equal (&r1, &r2));
 	pixman_region32_fini (&r1);
 	pixman_region32_fini (&r2);
 
     }
     pixman_image_unref (fill);
+    pixman_image_unref (half);
+
+    /* Adding many rectangles at once gives the same region as adding
+     * them one by one.
+     */
+    for (i = 0; i < 100; i++)
+    {
+	pixman_box32_t rects[200];
+	int n = prng_rand_n (ARRAY_LENGTH (rects));
+
+	pixman_region32_init_rect (&r1, 20, 30, prng_rand_n (40), 50);
+	pixman_region32_init (&r2);
+	pixman_region32_copy (&r2, &r1);
+
+	for (j = 0; j < n; j++)
+	{
+	    rects[j].x1 = prng_rand_n (200) - 20;
+	    rects[j].y1 = prng_rand_n (200) - 20;
+	    rects[j].x2 = rects[j].x1 + prng_rand_n (40) - 2;
+	    rects[j].y2 = rects[j].y1 + prng_rand_n (40) - 2;
+
+	    if (rects[j].x1 < rects[j].x2 && rects[j].y1 < rects[j].y2)
+	    {
+		pixman_region32_union_rect (&r2, &r2, rects[j].x1, rects[j].y1,
+					    rects[j].x2 - rects[j].x1,
+					    rects[j].y2 - rects[j].y1);
+	    }
+	}
+
+	ok = pixman_region32_union_rects (&r1, rects, n);
+	assert (ok);
+	assert (pixman_region32_selfcheck (&r1));
+	assert (pixman_region32_equal (&r1, &r2));
+
+	pixman_region32_fini (&r1);
+	pixman_region32_fini (&r2);
+    }
+
+    /* Intersecting into another region and in place give the same
+     * region as subtracting twice.
+     */
+    for (i = 0; i < 100; i++)
+    {
+	pixman_box32_t rects[50];
+
+	for (j = 0; j < ARRAY_LENGTH (rects); j++)
+	{
+	    rects[j].x1 = prng_rand_n (200);
+	    rects[j].y1 = prng_rand_n (200);
+	    rects[j].x2 = rects[j].x1 + prng_rand_n (40);
+	    rects[j].y2 = rects[j].y1 + prng_rand_n (40);
+	}
+
+	pixman_region32_init (&r1);
+	pixman_region32_init (&r2);
+	ok = pixman_region32_union_rects (&r1, rects, ARRAY_LENGTH (rects));
+	assert (ok);
+
+	if (i % 2)
+	{
+	    pixman_region32_init_rect (&r3, prng_rand_n (150), prng_rand_n (150),
+				       prng_rand_n (100), prng_rand_n (100));
+	}
+	else
+	{
+	    pixman_region32_init_rects (&r3, rects, ARRAY_LENGTH (rects) / 2);
+	    pixman_region32_translate (&r3, prng_rand_n (20), prng_rand_n (20));
+	}
+
+	ok = pixman_region32_subtract (&r2, &r1, &r3);
+	assert (ok);
+	ok = pixman_region32_subtract (&r2, &r1, &r2);
+	assert (ok);
+
+	pixman_region32_init (&r4);
+	ok = pixman_region32_intersect (&r4, &r1, &r3);
+	assert (ok);
+	assert (pixman_region32_selfcheck (&r4));
+	assert (same_region (&r2, &r4));
+
+	ok = pixman_region32_intersect (&r1, &r1, &r3);
+	assert (ok);
+	assert (pixman_region32_selfcheck (&r1));
+	assert (same_region (&r2, &r1));
+
+	pixman_region32_fini (&r1);
+	pixman_region32_fini (&r2);
+	pixman_region32_fini (&r3);
+	pixman_region32_fini (&r4);
+    }
+
+    /* Combining many regions at once gives the same region as applying
+     * the operations one by one.
+     */
+    for (i = 0; i < 100; i++)
+    {
+	pixman_region32_t regions[80], *operands[80];
+	pixman_region_op_t ops[79];
+	int n = 1 + prng_rand_n (ARRAY_LENGTH (regions));
+
+	for (j = 0; j < n; j++)
+	{
+	    pixman_box32_t rects[10];
+	    int k;
+
+	    for (k = 0; k < ARRAY_LENGTH (rects); k++)
+	    {
+		rects[k].x1 = prng_rand_n (100);
+		rects[k].y1 = prng_rand_n (100);
+		rects[k].x2 = rects[k].x1 + prng_rand_n (50);
+		rects[k].y2 = rects[k].y1 + prng_rand_n (50);
+	    }
+
+	    pixman_region32_init_rects (&regions[j], rects, prng_rand_n (11));
+	    operands[j] = &regions[j];
+
+	    if (j > 0)
+		ops[j - 1] = prng_rand_n (3);
+	}
+
+	pixman_region32_init (&r1);
+	pixman_region32_copy (&r1, &regions[0]);
+
+	for (j = 1; j < n; j++)
+	{
+	    if (ops[j - 1] == PIXMAN_REGION_OP_UNION)
+		pixman_region32_union (&r1, &r1, &regions[j]);
+	    else if (ops[j - 1] == PIXMAN_REGION_OP_INTERSECT)
+		pixman_region32_intersect (&r1, &r1, &regions[j]);
+	    else
+		pixman_region32_subtract (&r1, &r1, &regions[j]);
+	}
+
+	pixman_region32_init (&r2);
+	ok = pixman_region32_combine (&r2, n, operands, ops);
+	assert (ok);
+	assert (pixman_region32_selfcheck (&r2));
+	assert (same_region (&r1, &r2));
+
+	/* The destination can be one of the operands */
+	ok = pixman_region32_combine (&regions[0], n, operands, ops);
+	assert (ok);
+	assert (same_region (&r1, &regions[0]));
+
+	for (j = 0; j < n; j++)
+	    pixman_region32_fini (&regions[j]);
+	pixman_region32_fini (&r1);
+	pixman_region32_fini (&r2);
+    }
+
+    /* Points and rectangles are located correctly in regions with many
+     * boxes per band.
+     */
+    for (i = 0; i < 20; i++)
+    {
+	pixman_box32_t rects[400], box;
+	int n_in, n_rects;
+
+	for (j = 0; j < ARRAY_LENGTH (rects); j++)
+	{
+	    rects[j].x1 = prng_rand_n (1000);
+	    rects[j].y1 = prng_rand_n (50);
+	    rects[j].x2 = rects[j].x1 + 1 + prng_rand_n (3);
+	    rects[j].y2 = rects[j].y1 + 1 + prng_rand_n (20);
+	}
+
+	pixman_region32_init_rects (&r1, rects, ARRAY_LENGTH (rects));
+	b = pixman_region32_rectangles (&r1, &n_rects);
+
+	for (j = 0; j < 1000; j++)
+	{
+	    int x = prng_rand_n (1010) - 5;
+	    int y = prng_rand_n (80) - 5;
+	    pixman_region_overlap_t expected;
+
+	    for (n_in = 0; n_in < n_rects; n_in++)
+	    {
+		if (x >= b[n_in].x1 && x < b[n_in].x2 &&
+		    y >= b[n_in].y1 && y < b[n_in].y2)
+		{
+		    break;
+		}
+	    }
+
+	    assert (pixman_region32_contains_point (&r1, x, y, &box) ==
+		    (n_in < n_rects));
+	    if (n_in < n_rects)
+		assert (memcmp (&box, &b[n_in], sizeof (box)) == 0);
+
+	    box.x1 = x;
+	    box.y1 = y;
+	    box.x2 = x + 1 + prng_rand_n (8);
+	    box.y2 = y + 1 + prng_rand_n (8);
+
+	    pixman_region32_init_with_extents (&r2, &box);
+	    pixman_region32_init (&r3);
+	    pixman_region32_intersect (&r3, &r1, &r2);
+
+	    if (!pixman_region32_not_empty (&r3))
+		expected = PIXMAN_REGION_OUT;
+	    else if (pixman_region32_equal (&r3, &r2))
+		expected = PIXMAN_REGION_IN;
+	    else
+		expected = PIXMAN_REGION_PART;
+
+	    assert (pixman_region32_contains_rectangle (&r1, &box) == expected);
+
+	    pixman_region32_fini (&r2);
+	    pixman_region32_fini (&r3);
+	}
+
+	pixman_region32_fini (&r1);
+    }
+
+    /* Packed regions give back the same boxes, in less memory, and
+     * clip compositing like the equivalent clip region.
+     */
+    fill = pixman_image_create_solid_fill (&white);
+    for (i = 0; i < 50; i++)
+    {
+	pixman_region32_packed_t *packed;
+	pixman_region_packed_iter_t iter;
+	pixman_image_t *image2;
+	pixman_box32_t rects[300], box;
+	int n_rects;
+
+	for (j = 0; j < ARRAY_LENGTH (rects); j++)
+	{
+	    rects[j].x1 = prng_rand_n (100) - 20;
+	    rects[j].y1 = prng_rand_n (100) - 20;
+	    rects[j].x2 = rects[j].x1 + 1 + prng_rand_n (4);
+	    rects[j].y2 = rects[j].y1 + 1 + prng_rand_n (4);
+	}
+
+	pixman_region32_init_rects (&r1, rects, prng_rand_n (ARRAY_LENGTH (rects)));
+	b = pixman_region32_rectangles (&r1, &n_rects);
+
+	packed = pixman_region32_pack (&r1);
+	assert (packed);
+	assert (memcmp (pixman_region32_packed_extents (packed),
+			pixman_region32_extents (&r1), sizeof (box)) == 0);
+	if (n_rects > 10)
+	{
+	    assert (pixman_region32_packed_size (packed) <
+		    n_rects * sizeof (pixman_box32_t) / 2);
+	}
+
+	pixman_region32_packed_iter_init (&iter, packed);
+	for (j = 0; pixman_region32_packed_iter_next (&iter, &box); j++)
+	{
+	    assert (j < n_rects);
+	    assert (memcmp (&box, &b[j], sizeof (box)) == 0);
+	}
+	assert (j == n_rects);
+
+	ok = pixman_region32_init_from_packed (&r2, packed);
+	assert (ok);
+	assert (pixman_region32_selfcheck (&r2));
+	assert (same_region (&r1, &r2));
+	pixman_region32_fini (&r2);
+
+	image = pixman_image_create_bits (PIXMAN_a8, 64, 64, NULL, 0);
+	image2 = pixman_image_create_bits (PIXMAN_a8, 64, 64, NULL, 0);
+
+	/* Every other time, the destination has a clip of its own */
+	pixman_region32_init_rect (&r2, 0, 0, 64, 64);
+	if (i % 2)
+	{
+	    pixman_region32_init_rect (&r3, 10, 10, 20, 30);
+	    pixman_region32_subtract (&r2, &r2, &r3);
+	    pixman_region32_fini (&r3);
+	}
+	pixman_image_set_clip_region32 (image2, &r2);
+	pixman_region32_intersect (&r2, &r2, &r1);
+	pixman_image_set_clip_region32 (image, &r2);
+	pixman_region32_fini (&r2);
+
+	pixman_image_composite32 (PIXMAN_OP_SRC, fill, NULL, image,
+				  0, 0, 0, 0, 5, 3, 50, 55);
+	pixman_image_composite_packed_region32 (PIXMAN_OP_SRC, fill, NULL, image2,
+						packed, 0, 0, 0, 0, 5, 3, 50, 55);
+	assert (memcmp (pixman_image_get_data (image),
+			pixman_image_get_data (image2),
+			64 * pixman_image_get_stride (image)) == 0);
+
+	pixman_image_unref (image);
+	pixman_image_unref (image2);
+	pixman_region32_packed_destroy (packed);
+	pixman_region32_fini (&r1);
+    }
+    pixman_image_unref (fill);
+
+    /* The same for 16-bit regions, with coordinates anywhere in their
+     * range.
+     */
+    for (i = 0; i < 50; i++)
+    {
+	pixman_region16_t s1, s2;
+	pixman_region16_packed_t *packed;
+	pixman_region_packed_iter_t iter;
+	pixman_box16_t rects[300], box, *b16;
+	int n_rects;
+
+	for (j = 0; j < ARRAY_LENGTH (rects); j++)
+	{
+	    if (i % 2)
+	    {
+		rects[j].x1 = prng_rand_n (0xfffc) - 0x8000;
+		rects[j].y1 = prng_rand_n (0xfffc) - 0x8000;
+	    }
+	    else
+	    {
+		rects[j].x1 = prng_rand_n (100) - 20;
+		rects[j].y1 = prng_rand_n (100) - 20;
+	    }
+	    rects[j].x2 = rects[j].x1 + 1 + prng_rand_n (4);
+	    rects[j].y2 = rects[j].y1 + 1 + prng_rand_n (4);
+	}
+
+	pixman_region_init_rects (&s1, rects, prng_rand_n (ARRAY_LENGTH (rects)));
+	b16 = pixman_region_rectangles (&s1, &n_rects);
+
+	packed = pixman_region_pack (&s1);
+	assert (packed);
+	assert (memcmp (pixman_region_packed_extents (packed),
+			pixman_region_extents (&s1), sizeof (box)) == 0);
+
+	pixman_region_packed_iter_init (&iter, packed);
+	for (j = 0; pixman_region_packed_iter_next (&iter, &box); j++)
+	{
+	    assert (j < n_rects);
+	    assert (memcmp (&box, &b16[j], sizeof (box)) == 0);
+	}
+	assert (j == n_rects);
+
+	ok = pixman_region_init_from_packed (&s2, packed);
+	assert (ok);
+	assert (pixman_region_selfcheck (&s2));
+	assert (pixman_region_equal (&s1, &s2));
+
+	pixman_region_fini (&s2);
+	pixman_region_packed_destroy (packed);
+	pixman_region_fini (&s1);
+    }
+
+    /* Rasterizing a region sets the pixels inside of it to 0xff and the
+     * others to 0, and the antialiased variant gives each pixel the
+     * fraction of its subpixels that are inside.
+     */
+    for (i = 0; i < 40; i++)
+    {
+	pixman_box32_t rects[40];
+	int shift = i % 5;
+	int n = 1 << shift;
+	int x = prng_rand_n (20) - 10, y = prng_rand_n (20) - 10;
+	int width = 1 + prng_rand_n (60), height = 1 + prng_rand_n (60);
+	uint8_t *bits;
+	int stride, k;
+
+	for (j = 0; j < ARRAY_LENGTH (rects); j++)
+	{
+	    rects[j].x1 = prng_rand_n (80 * n) - 10 * n;
+	    rects[j].y1 = prng_rand_n (80 * n) - 10 * n;
+	    rects[j].x2 = rects[j].x1 + prng_rand_n (20 * n);
+	    rects[j].y2 = rects[j].y1 + prng_rand_n (20 * n);
+	}
+
+	pixman_region32_init_rects (&r1, rects, prng_rand_n (ARRAY_LENGTH (rects)));
+
+	image = pixman_image_create_bits (PIXMAN_a8, width, height, NULL, 0);
+	bits = (uint8_t *)pixman_image_get_data (image);
+	stride = pixman_image_get_stride (image);
+	memset (bits, 0x55, stride * height);
+
+	ok = pixman_region32_rasterize_aa (&r1, image, x, y, shift);
+	assert (ok);
+
+	for (j = 0; j < height; j++)
+	{
+	    for (k = 0; k < width; k++)
+	    {
+		int sx, sy, count = 0;
+
+		for (sy = 0; sy < n; sy++)
+		{
+		    for (sx = 0; sx < n; sx++)
+		    {
+			count += pixman_region32_contains_point (
+			    &r1, (k - x) * n + sx, (j - y) * n + sy, NULL);
+		    }
+		}
+
+		assert (bits[j * stride + k] ==
+			(count * 255 + n * n / 2) / (n * n));
+	    }
+	}
+
+	pixman_image_unref (image);
+	pixman_region32_fini (&r1);
+    }
+
+    /* The damage history gives the union of the damage of the last
+     * frames, as far back as it goes.
+     */
+    {
+	pixman_region32_history_t *history = pixman_region32_history_create (5);
+	pixman_region32_t frames[100];
+
+	for (i = 0; i < ARRAY_LENGTH (frames); i++)
+	{
+	    pixman_box32_t rects[8];
+	    int age;
+
+	    for (j = 0; j < ARRAY_LENGTH (rects); j++)
+	    {
+		rects[j].x1 = prng_rand_n (500);
+		rects[j].y1 = prng_rand_n (500);
+		rects[j].x2 = rects[j].x1 + prng_rand_n (100);
+		rects[j].y2 = rects[j].y1 + prng_rand_n (100);
+	    }
+
+	    pixman_region32_init_rects (&frames[i], rects, prng_rand_n (9));
+	    ok = pixman_region32_history_add (history, &frames[i]);
+	    assert (ok);
+
+	    if (i == 50)
+		pixman_region32_history_reset (history);
+
+	    for (age = 0; age <= 7; age++)
+	    {
+		int n_frames = i < 50 ? i + 1 : i - 50;
+
+		pixman_region32_init (&r2);
+
+		if (age < 1 || age > 5 || age > n_frames)
+		{
+		    ok = pixman_region32_history_get (history, age, &r2);
+		    assert (!ok);
+		}
+		else
+		{
+		    pixman_region32_init (&r1);
+		    for (j = i - age + 1; j <= i; j++)
+			pixman_region32_union (&r1, &r1, &frames[j]);
+
+		    ok = pixman_region32_history_get (history, age, &r2);
+		    assert (ok);
+		    assert (same_region (&r1, &r2));
+		    pixman_region32_fini (&r1);
+		}
+
+		pixman_region32_fini (&r2);
+	    }
+	}
+
+	for (i = 0; i < ARRAY_LENGTH (frames); i++)
+	    pixman_region32_fini (&frames[i]);
+	pixman_region32_history_destroy (history);
+    }
 
     return 0;
 }
@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+static const pixman_kernel_t kernels[] =
+{
+    PIXMAN_KERNEL_IMPULSE,
+    PIXMAN_KERNEL_BOX,
+    PIXMAN_KERNEL_LINEAR,
+    PIXMAN_KERNEL_CUBIC,
+    PIXMAN_KERNEL_GAUSSIAN,
+    PIXMAN_KERNEL_LANCZOS2,
+    PIXMAN_KERNEL_LANCZOS3,
+    PIXMAN_KERNEL_LANCZOS3_STRETCHED,
+};
+
+static pixman_image_t *
+create_image (pixman_format_code_t format, int width, int height)
+{
+    return pixman_image_create_bits (format, width, height, NULL, 0);
+}
+
+static void
+fill_random_opaque (pixman_image_t *image)
+{
+    uint32_t *bits = pixman_image_get_data (image);
+    int n = pixman_image_get_stride (image) / 4 * pixman_image_get_height (image);
+    int i;
+
+    for (i = 0; i < n; ++i)
+	bits[i] = prng_rand () | 0xff000000;
+}
+
+static int
+channel (uint32_t p, int shift)
+{
+    return (p >> shift) & 0xff;
+}
+
+static int
+compare_pixel (uint32_t expected, uint32_t actual, int tolerance)
+{
+    int shift;
+
+    for (shift = 0; shift < 32; shift += 8)
+    {
+	if (abs (channel (expected, shift) - channel (actual, shift)) > tolerance)
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Resizing to the same size must not change an image with kernels
+ * that interpolate.
+ */
+static int
+test_identity (void)
+{
+    static const pixman_kernel_t interpolating[] =
+    {
+	PIXMAN_KERNEL_IMPULSE,
+	PIXMAN_KERNEL_BOX,
+	PIXMAN_KERNEL_LINEAR,
+	PIXMAN_KERNEL_LANCZOS2,
+	PIXMAN_KERNEL_LANCZOS3,
+    };
+    pixman_image_t *src = create_image (PIXMAN_a8r8g8b8, 37, 23);
+    pixman_image_t *dest = create_image (PIXMAN_a8r8g8b8, 37, 23);
+    int i, failed = FALSE;
+
+    fill_random_opaque (src);
+
+    for (i = 0; i < ARRAY_LENGTH (interpolating); ++i)
+    {
+	pixman_image_resize (src, dest, interpolating[i]);
+
+	if (memcmp (pixman_image_get_data (src), pixman_image_get_data (dest),
+		    37 * 23 * 4) != 0)
+	{
+	    printf ("identity resize failed for kernel %d\n", interpolating[i]);
+	    failed = TRUE;
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    return failed;
+}
+
+/* A BOX downscale by an integer factor is the average of each block */
+static int
+test_box_average (void)
+{
+    pixman_image_t *src = create_image (PIXMAN_a8r8g8b8, 48, 30);
+    pixman_image_t *dest = create_image (PIXMAN_a8r8g8b8, 16, 10);
+    uint32_t *s = pixman_image_get_data (src);
+    uint32_t *d = pixman_image_get_data (dest);
+    int x, y, i, j, shift, failed = FALSE;
+
+    fill_random_opaque (src);
+    pixman_image_resize (src, dest, PIXMAN_KERNEL_BOX);
+
+    for (y = 0; y < 10; ++y)
+    {
+	for (x = 0; x < 16; ++x)
+	{
+	    uint32_t expected = 0;
+
+	    for (shift = 0; shift < 32; shift += 8)
+	    {
+		int sum = 0;
+
+		for (j = 0; j < 3; ++j)
+		{
+		    for (i = 0; i < 3; ++i)
+			sum += channel (s[(y * 3 + j) * 48 + x * 3 + i], shift);
+		}
+
+		expected |= (uint32_t)((sum + 4) / 9) << shift;
+	    }
+
+	    if (!compare_pixel (expected, d[y * 16 + x], 1))
+	    {
+		printf ("box average at %d, %d: expected %08x, got %08x\n",
+			x, y, expected, d[y * 16 + x]);
+		failed = TRUE;
+	    }
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    return failed;
+}
+
+/* Every kernel preserves a solid color, at any scale */
+static int
+test_solid (void)
+{
+    int i, k, failed = FALSE;
+
+    for (i = 0; i < 50; ++i)
+    {
+	int sw = 1 + prng_rand_n (60), sh = 1 + prng_rand_n (60);
+	int dw = 1 + prng_rand_n (60), dh = 1 + prng_rand_n (60);
+	uint32_t color = prng_rand () | 0xff000000;
+	pixman_image_t *src = create_image (PIXMAN_x8r8g8b8, sw, sh);
+	pixman_image_t *dest = create_image (PIXMAN_a8r8g8b8, dw, dh);
+	uint32_t *s = pixman_image_get_data (src);
+	uint32_t *d = pixman_image_get_data (dest);
+
+	for (k = 0; k < sw * sh; ++k)
+	    s[k] = color;
+
+	for (k = 0; k < ARRAY_LENGTH (kernels); ++k)
+	{
+	    int p;
+
+	    pixman_image_resize (src, dest, kernels[k]);
+
+	    for (p = 0; p < dw * dh; ++p)
+	    {
+		if (!compare_pixel (color, d[p], 1))
+		{
+		    printf ("solid %dx%d -> %dx%d, kernel %d: expected %08x, got %08x\n",
+			    sw, sh, dw, dh, kernels[k], color, d[p]);
+		    failed = TRUE;
+		    break;
+		}
+	    }
+	}
+
+	pixman_image_unref (src);
+	pixman_image_unref (dest);
+    }
+
+    return failed;
+}
+
+/* Black and white averaged in linear light is 0.5, which is 188 in sRGB */
+static int
+test_srgb (void)
+{
+    pixman_image_t *src = create_image (PIXMAN_a8r8g8b8_sRGB, 2, 1);
+    pixman_image_t *dest = create_image (PIXMAN_a8r8g8b8_sRGB, 1, 1);
+    uint32_t *s = pixman_image_get_data (src);
+    uint32_t *d = pixman_image_get_data (dest);
+    int failed = FALSE;
+
+    s[0] = 0xff000000;
+    s[1] = 0xffffffff;
+
+    pixman_image_resize (src, dest, PIXMAN_KERNEL_BOX);
+
+    if (!compare_pixel (0xffbcbcbc, d[0], 1))
+    {
+	printf ("sRGB average: expected ffbcbcbc, got %08x\n", d[0]);
+	failed = TRUE;
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    return failed;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    int failed = FALSE;
+
+    prng_srand (0x3F1A6D52);
+
+    failed |= test_identity ();
+    failed |= test_box_average ();
+    failed |= test_solid ();
+    failed |= test_srgb ();
+
+    return failed;
+}
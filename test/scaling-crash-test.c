@@ -109,6 +109,7 @@ static const filter_info_t filters[] =
 {
     { PIXMAN_FILTER_NEAREST, "NEAREST" },
     { PIXMAN_FILTER_BILINEAR, "BILINEAR" },
+    { PIXMAN_FILTER_BICUBIC, "BICUBIC" },
     { PIXMAN_FILTER_CONVOLUTION, "CONVOLUTION" },
 };
 
@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "utils.h"
+
+/* pixman_composite_trapezoids() rasterizes its mask in bands of rows
+ * that fit in 64 KiB, and composites each band before it moves on.
+ * The destinations here are wide enough that every mask format needs
+ * several bands, and the trapezoids cross the boundaries between them.
+ * The result must be byte-identical to rasterizing every trapezoid
+ * with pixman_add_trapezoids() into a mask the size of the destination,
+ * and compositing that.
+ *
+ * Likewise, rasterizing a trapezoid with pixman_rasterize_trapezoid_band()
+ * one band of rows after another must produce the same bytes as
+ * pixman_rasterize_trapezoid() on the whole image.
+ */
+#define MIN_WIDTH	2048
+#define MIN_HEIGHT	256
+
+static const pixman_format_code_t mask_formats[] =
+{
+    PIXMAN_a1, PIXMAN_a4, PIXMAN_a8,
+};
+
+static const pixman_format_code_t dest_formats[] =
+{
+    PIXMAN_a8r8g8b8, PIXMAN_r5g6b5, PIXMAN_a8, PIXMAN_a4, PIXMAN_a1,
+};
+
+static const pixman_op_t operators[] =
+{
+    PIXMAN_OP_OVER, PIXMAN_OP_ADD, PIXMAN_OP_SRC, PIXMAN_OP_IN,
+};
+
+#define RANDOM_ELT(array)						\
+    ((array)[prng_rand_n (ARRAY_LENGTH ((array)))])
+
+static pixman_fixed_t
+random_coord (int lo, int hi)
+{
+    return pixman_int_to_fixed (lo) + prng_rand_n (pixman_int_to_fixed (hi - lo));
+}
+
+/* Trapezoids anywhere across the destination and a little beyond it,
+ * a few of them thin like stroked lines. The edges run from the top to
+ * the bottom, because the extents of the mask are computed from their
+ * end points.
+ */
+static void
+random_trap (pixman_trapezoid_t *trap, int width, int height)
+{
+    pixman_fixed_t y1 = random_coord (-16, height + 16);
+    pixman_fixed_t y2 = random_coord (-16, height + 16);
+    pixman_fixed_t dx;
+
+    trap->top = MIN (y1, y2);
+    trap->bottom = MAX (y1, y2);
+
+    trap->left.p1.x = random_coord (-64, width + 64);
+    trap->left.p1.y = trap->top;
+    trap->left.p2.x = random_coord (-64, width + 64);
+    trap->left.p2.y = trap->bottom;
+
+    if (prng_rand_n (2))
+    {
+	dx = random_coord (0, 4);
+
+	trap->right.p1.x = trap->left.p1.x + dx;
+	trap->right.p2.x = trap->left.p2.x + dx;
+    }
+    else
+    {
+	trap->right.p1.x = random_coord (-64, width + 64);
+	trap->right.p2.x = random_coord (-64, width + 64);
+    }
+
+    trap->right.p1.y = trap->top;
+    trap->right.p2.y = trap->bottom;
+}
+
+static pixman_image_t *
+random_source (void)
+{
+    pixman_image_t *src;
+    pixman_color_t color;
+
+    if (prng_rand_n (2))
+    {
+	color.alpha = prng_rand_n (2) ? 0xffff : prng_rand_n (0x10000);
+	color.red = prng_rand_n (0x10000) & color.alpha;
+	color.green = prng_rand_n (0x10000) & color.alpha;
+	color.blue = prng_rand_n (0x10000) & color.alpha;
+
+	return pixman_image_create_solid_fill (&color);
+    }
+
+    src = pixman_image_create_bits (PIXMAN_a8r8g8b8, 16, 16, NULL, 0);
+    prng_randmemset (pixman_image_get_data (src), 16 * 16 * 4, 0);
+    pixman_image_set_repeat (src, PIXMAN_REPEAT_NORMAL);
+
+    return src;
+}
+
+static pixman_image_t *
+create_dest (pixman_format_code_t format, int width, int height,
+	     const uint8_t *bits)
+{
+    pixman_image_t *dest = pixman_image_create_bits (
+	format, width, height, NULL, 0);
+
+    memcpy (pixman_image_get_data (dest), bits,
+	    pixman_image_get_stride (dest) * height);
+
+    return dest;
+}
+
+static int
+test_composite_trapezoids (int testnum)
+{
+    int width = MIN_WIDTH + prng_rand_n (1024);
+    int height = MIN_HEIGHT + prng_rand_n (512);
+    int n_traps = 1 + prng_rand_n (32);
+    pixman_format_code_t mask_format = RANDOM_ELT (mask_formats);
+    pixman_format_code_t dest_format = RANDOM_ELT (dest_formats);
+    pixman_op_t op = RANDOM_ELT (operators);
+    int x_src = prng_rand_n (64) - 32;
+    int y_src = prng_rand_n (64) - 32;
+    int x_dst = 0, y_dst = 0;
+    pixman_trapezoid_t *traps;
+    pixman_image_t *src, *mask, *dest, *reference;
+    uint8_t *bits;
+    int i, size, failed;
+
+    /* With an operator where zero coverage has an effect, the whole
+     * destination is composited, but starting at (x_dst, y_dst).
+     */
+    if (op == PIXMAN_OP_OVER || op == PIXMAN_OP_ADD)
+    {
+	x_dst = prng_rand_n (64) - 32;
+	y_dst = prng_rand_n (64) - 32;
+    }
+
+    if (prng_rand_n (4) == 0)
+    {
+	/* The ADD fast path rasterizes straight into the destination */
+	op = PIXMAN_OP_ADD;
+	dest_format = mask_format;
+    }
+
+    traps = malloc (n_traps * sizeof (pixman_trapezoid_t));
+    for (i = 0; i < n_traps; i++)
+	random_trap (&traps[i], width, height);
+
+    src = random_source ();
+
+    dest = pixman_image_create_bits (dest_format, width, height, NULL, 0);
+    size = pixman_image_get_stride (dest) * height;
+    bits = malloc (size);
+    prng_randmemset (bits, size, 0);
+    pixman_image_unref (dest);
+
+    dest = create_dest (dest_format, width, height, bits);
+    pixman_composite_trapezoids (op, src, dest, mask_format,
+				 x_src, y_src, x_dst, y_dst, n_traps, traps);
+
+    reference = create_dest (dest_format, width, height, bits);
+    mask = pixman_image_create_bits (mask_format, width, height, NULL, 0);
+    pixman_add_trapezoids (mask, x_dst, y_dst, n_traps, traps);
+    pixman_image_composite32 (op, src, mask, reference,
+			      x_src - x_dst, y_src - y_dst, 0, 0, 0, 0,
+			      width, height);
+
+    failed = memcmp (pixman_image_get_data (dest),
+		     pixman_image_get_data (reference), size) != 0;
+    if (failed)
+    {
+	printf ("test %d: op %d, mask %s, dest %s %dx%d, %d trapezoids "
+		"differ from the reference\n", testnum, op,
+		format_name (mask_format), format_name (dest_format),
+		width, height, n_traps);
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (mask);
+    pixman_image_unref (dest);
+    pixman_image_unref (reference);
+    free (traps);
+    free (bits);
+
+    return failed;
+}
+
+static int
+test_rasterize_bands (int testnum)
+{
+    int width = 1 + prng_rand_n (300);
+    int height = 1 + prng_rand_n (300);
+    int n_traps = 1 + prng_rand_n (8);
+    pixman_format_code_t format = RANDOM_ELT (mask_formats);
+    int x_off = prng_rand_n (64) - 32;
+    int y_off = prng_rand_n (64) - 32;
+    pixman_image_t *whole, *banded;
+    pixman_trapezoid_t trap;
+    int i, y, band_height, size, failed;
+
+    whole = pixman_image_create_bits (format, width, height, NULL, 0);
+    banded = pixman_image_create_bits (format, width, height, NULL, 0);
+    size = pixman_image_get_stride (whole) * height;
+
+    for (i = 0; i < n_traps; i++)
+    {
+	random_trap (&trap, width, height);
+	band_height = 1 + prng_rand_n (height);
+
+	pixman_rasterize_trapezoid (whole, &trap, x_off, y_off);
+
+	/* The first and last bands reach past the image */
+	for (y = -prng_rand_n (band_height); y < height; y += band_height)
+	{
+	    pixman_rasterize_trapezoid_band (banded, &trap, x_off, y_off,
+					     y, y + band_height);
+	}
+    }
+
+    failed = memcmp (pixman_image_get_data (whole),
+		     pixman_image_get_data (banded), size) != 0;
+    if (failed)
+    {
+	printf ("test %d: %s %dx%d, %d trapezoids rasterized in bands "
+		"differ from the whole image\n", testnum,
+		format_name (format), width, height, n_traps);
+    }
+
+    pixman_image_unref (whole);
+    pixman_image_unref (banded);
+
+    return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i;
+    int failed = 0;
+
+    prng_srand (0);
+
+    for (i = 0; i < 64; i++)
+	failed |= test_composite_trapezoids (i);
+
+    for (i = 0; i < 1000; i++)
+	failed |= test_rasterize_bands (i);
+
+    return failed;
+}